@@ -0,0 +1,235 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <cmath>
+
+#include "RtMidi.h"
+
+#include "IECore.h"
+
+#include "IEMidiLatencyMonitor.h"
+#include "IEMidiProcessor.h"
+
+/*
+* End to end loopback over ALSA virtual ports, no hardware required.
+* A virtual output port plays timed message streams into the real RtMidi callback path of an activated device,
+* a recording volume action stands in for the OS backend and timestamps each invocation.
+* Exits with 0 when every message reached the action, 1 on loss or mismatch and 77 when ALSA sequencer ports are unavailable.
+*/
+
+static constexpr const char* LOOPBACK_CLIENT_NAME = "IEMidi Loopback";
+static constexpr const char* LOOPBACK_PORT_NAME = "IEMidi Loopback";
+static constexpr int LOOPBACK_SKIP_EXIT_CODE = 77;
+static constexpr unsigned char LOOPBACK_CONTROL_CHANGE_STATUS = 0xB0;
+static constexpr unsigned char LOOPBACK_CONTROL_CHANGE_NUMBER = 7;
+static constexpr std::chrono::seconds LOOPBACK_DRAIN_TIMEOUT = std::chrono::seconds(5);
+
+struct IELoopbackStream
+{
+public:
+    const char* Name = "";
+    size_t MessageCount = 0;
+    size_t BurstSize = 1;
+    std::chrono::microseconds BurstInterval = std::chrono::microseconds(0);
+};
+
+static constexpr std::array<IELoopbackStream, 3> LOOPBACK_STREAMS =
+{
+    IELoopbackStream{ "Steady 100Hz", 200, 1, std::chrono::microseconds(10000) },
+    IELoopbackStream{ "Steady 1kHz", 2000, 1, std::chrono::microseconds(1000) },
+    IELoopbackStream{ "Burst 32", 2048, 32, std::chrono::microseconds(20000) },
+};
+
+/* Records the time and value of every invocation, slots are preallocated so the action lane never allocates */
+class IELoopbackAction_Volume : public IEAction_Volume
+{
+public:
+    float GetVolume() const override { return m_Volume; }
+    void SetVolume(float Volume) override
+    {
+        m_Volume = Volume;
+        const size_t InvocationIndex = m_InvocationCount.load(std::memory_order_relaxed);
+        if (InvocationIndex < m_InvocationTimes.size())
+        {
+            m_InvocationTimes[InvocationIndex] = IEClock::now();
+            m_InvocationValues[InvocationIndex] = Volume;
+        }
+        m_InvocationCount.store(InvocationIndex + 1, std::memory_order_release);
+    }
+
+public:
+    void Reset(size_t MessageCount)
+    {
+        m_InvocationTimes.assign(MessageCount, IEClock::time_point());
+        m_InvocationValues.assign(MessageCount, 0.0f);
+        m_InvocationCount.store(0, std::memory_order_release);
+    }
+
+    size_t GetInvocationCount() const { return m_InvocationCount.load(std::memory_order_acquire); }
+    IEClock::time_point GetInvocationTime(size_t InvocationIndex) const { return m_InvocationTimes[InvocationIndex]; }
+    float GetInvocationValue(size_t InvocationIndex) const { return m_InvocationValues[InvocationIndex]; }
+
+private:
+    float m_Volume = 0.0f;
+    std::vector<IEClock::time_point> m_InvocationTimes;
+    std::vector<float> m_InvocationValues;
+    std::atomic<size_t> m_InvocationCount = 0;
+};
+
+class IELoopbackAction_Mute : public IEAction_Mute
+{
+public:
+    bool GetMute() const override { return false; }
+    void SetMute(bool bMute) override {}
+};
+
+class IELoopbackAction_ConsoleCommand : public IEAction_ConsoleCommand
+{
+public:
+    void ExecuteConsoleCommand(const std::string& ConsoleCommand, float Value) override {}
+};
+
+class IELoopbackAction_OpenFile : public IEAction_OpenFile
+{
+public:
+    void OpenFile(const std::string& FilePath) override {}
+};
+
+struct IELoopbackResult
+{
+public:
+    IEMidiLatencySummary LatencySummary;
+    size_t LostCount = 0;
+    size_t MismatchedCount = 0;
+};
+
+static IELoopbackResult RunLoopbackStream(IEMidiProcessor& MidiProcessor, RtMidiOut& LoopbackMidiOut, IELoopbackAction_Volume& LoopbackVolumeAction,
+                                          const IELoopbackStream& LoopbackStream)
+{
+    std::vector<IEClock::time_point> SendTimes(LoopbackStream.MessageCount);
+    LoopbackVolumeAction.Reset(LoopbackStream.MessageCount);
+
+    IEClock::time_point NextBurstTime = IEClock::now();
+    for (size_t MessageIndex = 0; MessageIndex < LoopbackStream.MessageCount; MessageIndex++)
+    {
+        if (MessageIndex % LoopbackStream.BurstSize == 0)
+        {
+            std::this_thread::sleep_until(NextBurstTime);
+            NextBurstTime += LoopbackStream.BurstInterval;
+        }
+
+        // The value carries the sequence number so that invocations can be matched to their message
+        const IEMidiMessage MidiMessage(LOOPBACK_CONTROL_CHANGE_STATUS, LOOPBACK_CONTROL_CHANGE_NUMBER, static_cast<unsigned char>(MessageIndex % 128));
+        SendTimes[MessageIndex] = IEClock::now();
+        LoopbackMidiOut.sendMessage(MidiMessage.data(), MidiMessage.size());
+    }
+
+    const IEClock::time_point DrainDeadline = IEClock::now() + LOOPBACK_DRAIN_TIMEOUT;
+    IEMidiEvent MidiEvent;
+    while (LoopbackVolumeAction.GetInvocationCount() < LoopbackStream.MessageCount && IEClock::now() < DrainDeadline)
+    {
+        // Nothing consumes the incoming event rings here, drain them so they do not count as dropped
+        while (MidiProcessor.PopIncomingMidiEvent(MidiEvent));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    IELoopbackResult LoopbackResult;
+    IEMidiLatencyHistogram LatencyHistogram;
+    const size_t InvocationCount = std::min(LoopbackVolumeAction.GetInvocationCount(), LoopbackStream.MessageCount);
+    for (size_t InvocationIndex = 0; InvocationIndex < InvocationCount; InvocationIndex++)
+    {
+        const unsigned char ExpectedValue = static_cast<unsigned char>(InvocationIndex % 128);
+        const unsigned char ReceivedValue = static_cast<unsigned char>(std::lround(LoopbackVolumeAction.GetInvocationValue(InvocationIndex) * 127.0f));
+        if (ReceivedValue != ExpectedValue)
+        {
+            LoopbackResult.MismatchedCount++;
+            continue;
+        }
+
+        const IEClock::duration Latency = LoopbackVolumeAction.GetInvocationTime(InvocationIndex) - SendTimes[InvocationIndex];
+        LatencyHistogram.Record(static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(Latency).count())));
+    }
+    LoopbackResult.LostCount = LoopbackStream.MessageCount - InvocationCount;
+    LoopbackResult.LatencySummary = LatencyHistogram.GetSummary();
+    return LoopbackResult;
+}
+
+int main()
+{
+#if !defined(__linux__)
+    IELOG_ERROR("The loopback harness needs ALSA virtual ports and only runs on Linux");
+    return LOOPBACK_SKIP_EXIT_CODE;
+#else
+    if (!std::filesystem::exists("/dev/snd/seq"))
+    {
+        IELOG_ERROR("ALSA sequencer is unavailable (/dev/snd/seq missing), load the snd-seq module to run the loopback harness");
+        return LOOPBACK_SKIP_EXIT_CODE;
+    }
+
+    std::unique_ptr<IELoopbackAction_Volume> LoopbackVolumeActionPtr = std::make_unique<IELoopbackAction_Volume>();
+    IELoopbackAction_Volume& LoopbackVolumeAction = *LoopbackVolumeActionPtr;
+    IEMidiProcessor MidiProcessor(DEFAULT_INCOMING_MIDI_EVENTS_CAPACITY,
+        std::make_unique<IEMidiActionExecutor>(std::move(LoopbackVolumeActionPtr),
+                                               std::make_unique<IELoopbackAction_Mute>(),
+                                               std::make_unique<IELoopbackAction_ConsoleCommand>(),
+                                               std::make_unique<IELoopbackAction_OpenFile>()));
+
+    // A virtual output plays into the device input, a virtual input of the same name gives the device an output to open
+    std::unique_ptr<RtMidiOut> LoopbackMidiOut;
+    std::unique_ptr<RtMidiIn> LoopbackMidiIn;
+    try
+    {
+        LoopbackMidiOut = std::make_unique<RtMidiOut>(RtMidi::LINUX_ALSA, LOOPBACK_CLIENT_NAME);
+        LoopbackMidiOut->openVirtualPort(LOOPBACK_PORT_NAME);
+        LoopbackMidiIn = std::make_unique<RtMidiIn>(RtMidi::LINUX_ALSA, LOOPBACK_CLIENT_NAME);
+        LoopbackMidiIn->openVirtualPort(LOOPBACK_PORT_NAME);
+    }
+    catch (const RtMidiError& Error)
+    {
+        IELOG_ERROR("Failed to open ALSA virtual ports: %s", Error.getMessage().c_str());
+        return LOOPBACK_SKIP_EXIT_CODE;
+    }
+
+    std::string LoopbackMidiDeviceName;
+    for (const std::string& MidiDeviceName : MidiProcessor.GetAvailableMidiDevices())
+    {
+        if (MidiDeviceName.starts_with(LOOPBACK_CLIENT_NAME))
+        {
+            LoopbackMidiDeviceName = MidiDeviceName;
+            break;
+        }
+    }
+
+    const IEResult Result = LoopbackMidiDeviceName.empty() ? IEResult(IEResult::Type::Fail, "Loopback port is not listed as a midi device") :
+                                                             MidiProcessor.ActivateMidiDeviceProfile(LoopbackMidiDeviceName);
+    if (!Result)
+    {
+        IELOG_ERROR("%s", Result.Message.c_str());
+        return 1;
+    }
+
+    IEMidiDeviceProfile& MidiDeviceProfile = MidiProcessor.GetActiveMidiDeviceProfile(LoopbackMidiDeviceName);
+    IEMidiDeviceProperty& MidiDeviceProperty = MidiDeviceProfile.Properties.emplace_back(MidiDeviceProfile.Name);
+    MidiDeviceProperty.MidiMessageType = IEMidiMessageType::ControlChange;
+    MidiDeviceProperty.MidiActionType = IEMidiActionType::Volume;
+    MidiDeviceProperty.MidiMessage = IEMidiMessage(LOOPBACK_CONTROL_CHANGE_STATUS, LOOPBACK_CONTROL_CHANGE_NUMBER, 0);
+    MidiProcessor.RefreshMidiDispatchTable(LoopbackMidiDeviceName);
+
+    std::printf("%-14s %10s %8s %10s %12s %12s %12s\n", "Stream", "Messages", "Lost", "Mismatched", "p50 ms", "p99 ms", "Max ms");
+
+    bool bPassed = true;
+    for (const IELoopbackStream& LoopbackStream : LOOPBACK_STREAMS)
+    {
+        const IELoopbackResult LoopbackResult = RunLoopbackStream(MidiProcessor, *LoopbackMidiOut, LoopbackVolumeAction, LoopbackStream);
+        std::printf("%-14s %10zu %8zu %10zu %12.3f %12.3f %12.3f\n", LoopbackStream.Name, LoopbackStream.MessageCount,
+            LoopbackResult.LostCount, LoopbackResult.MismatchedCount,
+            LoopbackResult.LatencySummary.P50Ns / 1e6, LoopbackResult.LatencySummary.P99Ns / 1e6, LoopbackResult.LatencySummary.MaxNs / 1e6);
+
+        bPassed &= LoopbackResult.LostCount == 0 && LoopbackResult.MismatchedCount == 0;
+    }
+
+    MidiProcessor.DeactivateAllMidiDeviceProfiles();
+    return bPassed ? 0 : 1;
+#endif
+}
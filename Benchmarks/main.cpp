@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <new>
+
+#include "IECore.h"
+
+#include "IEMidiProcessor.h"
+
+static constexpr size_t BENCHMARK_MESSAGE_COUNT = 200000;
+static constexpr size_t BENCHMARK_LANE_CAPACITY = 1 << 16;
+static constexpr std::array<size_t, 4> BENCHMARK_PROPERTY_COUNTS = { 10, 100, 1000, 10000 };
+
+static std::atomic<uint64_t> AllocationCount = 0;
+
+void* operator new(size_t Size)
+{
+    AllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* const Memory = std::malloc(Size ? Size : 1))
+    {
+        return Memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* Memory) noexcept
+{
+    std::free(Memory);
+}
+
+void operator delete(void* Memory, size_t Size) noexcept
+{
+    std::free(Memory);
+}
+
+/* Stub actions, they do no work so that the benchmark measures dispatch and not the OS backends */
+
+class IEBenchmarkAction_Volume : public IEAction_Volume
+{
+public:
+    float GetVolume() const override { return m_Volume; }
+    void SetVolume(float Volume) override { m_Volume = Volume; }
+
+private:
+    float m_Volume = 0.0f;
+};
+
+class IEBenchmarkAction_Mute : public IEAction_Mute
+{
+public:
+    bool GetMute() const override { return m_bMute; }
+    void SetMute(bool bMute) override { m_bMute = bMute; }
+
+private:
+    bool m_bMute = false;
+};
+
+class IEBenchmarkAction_ConsoleCommand : public IEAction_ConsoleCommand
+{
+public:
+    void ExecuteConsoleCommand(const std::string& ConsoleCommand, float Value) override {}
+};
+
+class IEBenchmarkAction_OpenFile : public IEAction_OpenFile
+{
+public:
+    void OpenFile(const std::string& FilePath) override {}
+};
+
+enum class IEBenchmarkToggleMix : uint8_t
+{
+    NonToggle,
+    Mixed,
+    Toggle,
+
+    Count,
+};
+
+struct IEBenchmarkResult
+{
+public:
+    double MessagesPerSecond = 0.0;
+    double NsPerMessage = 0.0;
+    double AllocationsPerMessage = 0.0;
+    uint64_t DroppedCount = 0;
+};
+
+static IEMidiDeviceProfile CreateBenchmarkProfile(size_t PropertyCount, IEMidiActionType MidiActionType, IEBenchmarkToggleMix ToggleMix)
+{
+    IEMidiDeviceProfile MidiDeviceProfile("Benchmark", 0, 0);
+    MidiDeviceProfile.Properties.reserve(PropertyCount);
+
+    // Volume only reacts to continuous controllers, every other action is bound to notes
+    const bool bControlChange = MidiActionType == IEMidiActionType::Volume;
+    const unsigned char StatusBase = bControlChange ? 0xB0 : 0x90;
+    for (size_t PropertyIndex = 0; PropertyIndex < PropertyCount; PropertyIndex++)
+    {
+        IEMidiDeviceProperty& MidiDeviceProperty = MidiDeviceProfile.Properties.emplace_back(MidiDeviceProfile.Name);
+        MidiDeviceProperty.MidiMessageType = bControlChange ? IEMidiMessageType::ControlChange : IEMidiMessageType::NoteOnOff;
+        MidiDeviceProperty.MidiActionType = MidiActionType;
+        MidiDeviceProperty.ConsoleCommand = "true";
+        MidiDeviceProperty.OpenFilePath = "/dev/null";
+        MidiDeviceProperty.MidiMessage = IEMidiMessage(static_cast<unsigned char>(StatusBase | ((PropertyIndex / 128) % 16)),
+                                                       static_cast<unsigned char>(PropertyIndex % 128), 0);
+        if (MidiActionType == IEMidiActionType::Macro)
+        {
+            // Immediate steps only, a press starts the macro and the next press of a still running one cancels it
+            IEMidiMacroStep& VolumeMacroStep = MidiDeviceProperty.MacroSteps.emplace_back();
+            VolumeMacroStep.MacroStepType = IEMidiMacroStepType::Volume;
+            VolumeMacroStep.Value = 0.5f;
+            IEMidiMacroStep& MuteMacroStep = MidiDeviceProperty.MacroSteps.emplace_back();
+            MuteMacroStep.MacroStepType = IEMidiMacroStepType::Mute;
+            MuteMacroStep.Value = 1.0f;
+        }
+        switch (ToggleMix)
+        {
+            case IEBenchmarkToggleMix::Mixed: MidiDeviceProperty.bToggle = PropertyIndex % 2 == 0; break;
+            case IEBenchmarkToggleMix::Toggle: MidiDeviceProperty.bToggle = true; break;
+            default: break;
+        }
+    }
+    return MidiDeviceProfile;
+}
+
+static std::vector<IEMidiMessage> CreateBenchmarkMessages(const IEMidiDeviceProfile& MidiDeviceProfile)
+{
+    std::vector<IEMidiMessage> MidiMessages;
+    MidiMessages.reserve(BENCHMARK_MESSAGE_COUNT);
+
+    uint32_t RandomState = 0x9E3779B9;
+    for (size_t MessageIndex = 0; MessageIndex < BENCHMARK_MESSAGE_COUNT; MessageIndex++)
+    {
+        RandomState ^= RandomState << 13;
+        RandomState ^= RandomState >> 17;
+        RandomState ^= RandomState << 5;
+
+        IEMidiMessage MidiMessage = MidiDeviceProfile.Properties[RandomState % MidiDeviceProfile.Properties.size()].MidiMessage;
+        MidiMessage[2] = static_cast<unsigned char>((RandomState >> 8) % 128);
+        MidiMessages.push_back(MidiMessage);
+    }
+    return MidiMessages;
+}
+
+static IEBenchmarkResult RunBenchmark(IEMidiProcessor& MidiProcessor, const IEMidiDeviceProfile& MidiDeviceProfile)
+{
+    const std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable = std::make_shared<const IEMidiDispatchTable>(MidiDeviceProfile);
+    const std::vector<IEMidiMessage> MidiMessages = CreateBenchmarkMessages(MidiDeviceProfile);
+
+    const uint64_t StartAllocationCount = AllocationCount.load(std::memory_order_relaxed);
+    const IEClock::time_point StartTime = IEClock::now();
+    for (const IEMidiMessage& MidiMessage : MidiMessages)
+    {
+        MidiProcessor.ProcessMidiInputMessage(MidiDispatchTable, MidiMessage);
+    }
+    const IEClock::time_point EndTime = IEClock::now();
+    const uint64_t EndAllocationCount = AllocationCount.load(std::memory_order_relaxed);
+
+    const double ElapsedNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(EndTime - StartTime).count());
+    const double MessageCount = static_cast<double>(MidiMessages.size());
+
+    IEBenchmarkResult BenchmarkResult;
+    BenchmarkResult.NsPerMessage = ElapsedNs / MessageCount;
+    BenchmarkResult.MessagesPerSecond = ElapsedNs > 0.0 ? MessageCount * 1e9 / ElapsedNs : 0.0;
+    BenchmarkResult.AllocationsPerMessage = static_cast<double>(EndAllocationCount - StartAllocationCount) / MessageCount;
+    for (size_t ActionTypeIndex = 0; ActionTypeIndex < static_cast<size_t>(IEMidiActionType::Count); ActionTypeIndex++)
+    {
+        BenchmarkResult.DroppedCount += MidiProcessor.GetMidiActionExecutor().GetActionStats(static_cast<IEMidiActionType>(ActionTypeIndex)).DroppedCount;
+    }
+    BenchmarkResult.DroppedCount += MidiProcessor.GetMidiMacroStats().DroppedTriggerCount;
+    return BenchmarkResult;
+}
+
+int main()
+{
+    static const char* const ActionTypeNames[static_cast<size_t>(IEMidiActionType::Count)] = { "None", "Volume", "Mute", "ConsoleCommand", "OpenFile", "Macro" };
+    static const char* const ToggleMixNames[static_cast<size_t>(IEBenchmarkToggleMix::Count)] = { "NonToggle", "Mixed", "Toggle" };
+
+    std::printf("%-16s %-10s %10s %16s %12s %14s %10s\n", "Action", "Toggle", "Properties", "Messages/s", "ns/Message", "Allocs/Message", "Dropped");
+
+    for (size_t ActionTypeIndex = 1; ActionTypeIndex < static_cast<size_t>(IEMidiActionType::Count); ActionTypeIndex++)
+    {
+        const IEMidiActionType MidiActionType = static_cast<IEMidiActionType>(ActionTypeIndex);
+        for (size_t ToggleMixIndex = 0; ToggleMixIndex < static_cast<size_t>(IEBenchmarkToggleMix::Count); ToggleMixIndex++)
+        {
+            const IEBenchmarkToggleMix ToggleMix = static_cast<IEBenchmarkToggleMix>(ToggleMixIndex);
+
+            // Toggles only apply to note driven Mute and ConsoleCommand properties
+            const bool bSupportsToggle = MidiActionType == IEMidiActionType::Mute || MidiActionType == IEMidiActionType::ConsoleCommand;
+            if (!bSupportsToggle && ToggleMix != IEBenchmarkToggleMix::NonToggle)
+            {
+                continue;
+            }
+
+            for (const size_t PropertyCount : BENCHMARK_PROPERTY_COUNTS)
+            {
+                // A fresh processor per run so queued actions of the previous run do not skew the next one
+                IEMidiProcessor MidiProcessor(DEFAULT_INCOMING_MIDI_EVENTS_CAPACITY,
+                    std::make_unique<IEMidiActionExecutor>(std::make_unique<IEBenchmarkAction_Volume>(),
+                                                           std::make_unique<IEBenchmarkAction_Mute>(),
+                                                           std::make_unique<IEBenchmarkAction_ConsoleCommand>(),
+                                                           std::make_unique<IEBenchmarkAction_OpenFile>(),
+                                                           BENCHMARK_LANE_CAPACITY));
+
+                const IEMidiDeviceProfile MidiDeviceProfile = CreateBenchmarkProfile(PropertyCount, MidiActionType, ToggleMix);
+                const IEBenchmarkResult BenchmarkResult = RunBenchmark(MidiProcessor, MidiDeviceProfile);
+
+                std::printf("%-16s %-10s %10zu %16.0f %12.1f %14.3f %10llu\n", ActionTypeNames[ActionTypeIndex], ToggleMixNames[ToggleMixIndex],
+                    PropertyCount, BenchmarkResult.MessagesPerSecond, BenchmarkResult.NsPerMessage, BenchmarkResult.AllocationsPerMessage,
+                    static_cast<unsigned long long>(BenchmarkResult.DroppedCount));
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <csignal>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <signal.h>
+#endif
+
+#include "IECore.h"
+
+#include "IEMidiProcessor.h"
+#include "IEMidiProfileManager.h"
+
+/* Moves the profile library to one file per device, migrating profiles.yaml on first use */
+static constexpr char SHARDED_PROFILES_ARGUMENT[] = "--sharded-profiles";
+
+#if defined(__linux__) || defined(__APPLE__)
+static sigset_t GetTerminationSignals()
+{
+    sigset_t TerminationSignals;
+    sigemptyset(&TerminationSignals);
+    sigaddset(&TerminationSignals, SIGINT);
+    sigaddset(&TerminationSignals, SIGTERM);
+    return TerminationSignals;
+}
+
+static void WaitForTerminationSignal()
+{
+    const sigset_t TerminationSignals = GetTerminationSignals();
+    int Signal = 0;
+    sigwait(&TerminationSignals, &Signal);
+}
+#else
+static std::atomic<bool> bIsDaemonRunning = true;
+
+static void OnTerminationSignal(int Signal)
+{
+    bIsDaemonRunning.store(false);
+}
+
+static void WaitForTerminationSignal()
+{
+    std::signal(SIGINT, OnTerminationSignal);
+    std::signal(SIGTERM, OnTerminationSignal);
+    while (bIsDaemonRunning.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+}
+#endif
+
+struct IEMidiDaemonContext
+{
+public:
+    IEMidiProcessor& MidiProcessor;
+    IEMidiProfileManager& MidiProfileManager;
+    /* Devices given on the command line, empty to activate every device that has a saved profile */
+    std::vector<std::string> MidiDeviceNames;
+    /* Serializes activations with profile reloads, both load into active profiles */
+    std::mutex MidiProfilesMutex;
+    std::atomic<bool> bIsMidiDeviceActivatorStopping = false;
+};
+
+static void ActivateConnectedMidiDevices(IEMidiDaemonContext& DaemonContext)
+{
+    const std::vector<std::string> MidiDeviceNames = DaemonContext.MidiDeviceNames.empty() ?
+        DaemonContext.MidiProfileManager.GetProfileNames() : DaemonContext.MidiDeviceNames;
+
+    std::scoped_lock MidiProfilesLock(DaemonContext.MidiProfilesMutex);
+    IEMidiProcessor& MidiProcessor = DaemonContext.MidiProcessor;
+    for (const std::string& MidiDeviceName : MidiDeviceNames)
+    {
+        IEMidiDeviceEntry MidiDeviceEntry;
+        if (MidiProcessor.HasActiveMidiDeviceProfile(MidiDeviceName) || !MidiProcessor.GetMidiDeviceRegistry().FindMidiDevice(MidiDeviceName, MidiDeviceEntry))
+        {
+            continue;
+        }
+
+        const IEResult Result = MidiProcessor.ActivateMidiDeviceProfile(MidiDeviceName);
+        if (Result)
+        {
+            IEMidiDeviceProfile& ActiveMidiDeviceProfile = MidiProcessor.GetActiveMidiDeviceProfile(MidiDeviceName);
+            DaemonContext.MidiProfileManager.LoadProfile(ActiveMidiDeviceProfile);
+            MidiProcessor.RefreshMidiDispatchTable(MidiDeviceName);
+            MidiProcessor.SendInitialOutputMidiMessages(MidiDeviceName);
+            IELOG_SUCCESS("%s", Result.Message.c_str());
+        }
+        else
+        {
+            IELOG_ERROR("%s", Result.Message.c_str());
+        }
+    }
+}
+
+/*
+* Activates configured devices as they are plugged in, so the daemon can start before its controllers.
+* Once active a device is kept by the session supervisor, which reconnects it when it comes back.
+*/
+static void RunMidiDeviceActivator(IEMidiDaemonContext& DaemonContext)
+{
+    IEMidiDeviceRegistry& MidiDeviceRegistry = DaemonContext.MidiProcessor.GetMidiDeviceRegistry();
+    while (!DaemonContext.bIsMidiDeviceActivatorStopping.load())
+    {
+        const uint64_t ChangeCount = MidiDeviceRegistry.GetChangeCount();
+        ActivateConnectedMidiDevices(DaemonContext);
+        MidiDeviceRegistry.WaitForMidiDevicesChanged(ChangeCount, SESSION_SUPERVISOR_WAKE_INTERVAL);
+    }
+}
+
+/* Reloads happen in place on the watcher thread, under the same lock as activations */
+static void OnMidiProfilesChanged(const std::vector<std::string>& ChangedProfileNames, void* UserData)
+{
+    IEMidiDaemonContext& DaemonContext = *reinterpret_cast<IEMidiDaemonContext*>(UserData);
+    std::scoped_lock MidiProfilesLock(DaemonContext.MidiProfilesMutex);
+    for (const std::string& MidiDeviceName : ChangedProfileNames)
+    {
+        if (DaemonContext.MidiProcessor.HasActiveMidiDeviceProfile(MidiDeviceName))
+        {
+            const IEResult Result = DaemonContext.MidiProfileManager.LoadProfile(DaemonContext.MidiProcessor.GetActiveMidiDeviceProfile(MidiDeviceName));
+            if (Result)
+            {
+                DaemonContext.MidiProcessor.RefreshMidiDispatchTable(MidiDeviceName);
+                IELOG_SUCCESS("Reloaded profile %s", MidiDeviceName.c_str());
+            }
+            else
+            {
+                IELOG_ERROR("%s", Result.Message.c_str());
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+#if defined(__linux__) || defined(__APPLE__)
+    // Block termination signals before any worker thread is spawned so that only sigwait receives them
+    const sigset_t TerminationSignals = GetTerminationSignals();
+    pthread_sigmask(SIG_BLOCK, &TerminationSignals, nullptr);
+#endif
+
+    // Devices given on the command line, otherwise every connected device that has a saved profile
+    std::vector<std::string> MidiDeviceNames;
+    IEMidiProfileStorage ProfileStorage = IEMidiProfileStorage::SingleFile;
+    for (int ArgumentIndex = 1; ArgumentIndex < argc; ArgumentIndex++)
+    {
+        if (std::strcmp(argv[ArgumentIndex], SHARDED_PROFILES_ARGUMENT) == 0)
+        {
+            ProfileStorage = IEMidiProfileStorage::Sharded;
+        }
+        else
+        {
+            MidiDeviceNames.emplace_back(argv[ArgumentIndex]);
+        }
+    }
+
+    IEMidiProcessor MidiProcessor;
+    IEMidiProfileManager MidiProfileManager(ProfileStorage);
+
+    // Devices that are not plugged in yet are activated when the registry sees them, the daemon keeps running meanwhile
+    IEMidiDaemonContext DaemonContext = { MidiProcessor, MidiProfileManager, std::move(MidiDeviceNames) };
+    ActivateConnectedMidiDevices(DaemonContext);
+    if (MidiProcessor.GetMidiDeviceSessions().empty())
+    {
+        IELOG_ERROR("No configured midi device connected, waiting for one");
+    }
+
+    const IEResult Result = MidiProfileManager.StartWatchingProfiles(OnMidiProfilesChanged, &DaemonContext);
+    if (!Result)
+    {
+        IELOG_ERROR("%s", Result.Message.c_str());
+    }
+
+    // Unplugged devices stay active and are reconnected when they come back
+    MidiProcessor.StartSessionSupervisor();
+    MidiProcessor.StartMidiStateFeedback();
+    std::thread MidiDeviceActivator(&RunMidiDeviceActivator, std::ref(DaemonContext));
+
+    WaitForTerminationSignal();
+
+    DaemonContext.bIsMidiDeviceActivatorStopping.store(true);
+    MidiProcessor.GetMidiDeviceRegistry().WakeMidiDevicesChangedWaiters();
+    MidiDeviceActivator.join();
+    MidiProcessor.StopMidiStateFeedback();
+    MidiProcessor.StopSessionSupervisor();
+    MidiProfileManager.StopWatchingProfiles();
+    MidiProcessor.DeactivateAllMidiDeviceProfiles();
+    return 0;
+}
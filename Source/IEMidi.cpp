@@ -14,6 +14,23 @@ IEMidi::IEMidi() :
 {
     m_Renderer->AddOnWindowCloseCallbackFunc(OnAppWindowClosed, this);
     m_Renderer->AddOnWindowRestoreCallbackFunc(OnAppWindowRestored, this);
+
+    m_MidiProcessor->GetMidiDeviceRegistry().SetOnMidiDevicesChangedCallbackFunc(OnMidiDevicesChanged, this);
+    m_MidiProcessor->StartSessionSupervisor();
+    m_MidiProcessor->StartMidiStateFeedback();
+
+    const IEResult Result = m_MidiProfileManager->StartWatchingProfiles(OnMidiProfilesChanged, this);
+    if (!Result)
+    {
+        IELOG_ERROR("%s", Result.Message.c_str());
+    }
+}
+
+IEMidi::~IEMidi()
+{
+    // The watchers call back into this instance, stop them before any member goes away
+    m_MidiProfileManager->StopWatchingProfiles();
+    m_MidiProcessor->GetMidiDeviceRegistry().SetOnMidiDevicesChangedCallbackFunc(nullptr, nullptr);
 }
 
 IEAppState IEMidi::GetAppState() const
@@ -29,6 +46,9 @@ void IEMidi::SetAppState(IEAppState AppState)
 
 void IEMidi::OnPreFrameRender()
 {
+    ProcessIncomingMidiEvents();
+    ProcessChangedMidiProfiles();
+
     switch (m_AppState)
     {
         case IEAppState::MidiDeviceSelection:
@@ -52,6 +72,94 @@ void IEMidi::OnPreFrameRender()
 void IEMidi::OnPostFrameRender()
 {}
 
+void IEMidi::ProcessIncomingMidiEvents()
+{
+    IEMidiProcessor& MidiProcessor = GetMidiProcessor();
+
+    IEMidiEvent MidiEvent;
+    while (MidiProcessor.PopIncomingMidiEvent(MidiEvent))
+    {
+        if (MidiEvent.bRecorded)
+        {
+            if (const std::shared_ptr<IEMidiDeviceSession> MidiDeviceSession = MidiProcessor.FindMidiDeviceSession(MidiEvent.MidiDeviceSessionID))
+            {
+                for (IEMidiDeviceProperty& MidiDeviceProperty : MidiDeviceSession->GetMidiDeviceProfile().Properties)
+                {
+                    if (MidiDeviceProperty.bIsRecording)
+                    {
+                        MidiDeviceProperty.MidiMessage = MidiEvent.MidiMessage;
+                        MidiDeviceProperty.MidiMessage.Size = static_cast<uint8_t>(IEMidiParser::GetMidiMessageSize(MidiEvent.MidiMessage[0]));
+                        MidiDeviceProperty.bIsRecording = false;
+                    }
+                }
+                MidiDeviceSession->RefreshMidiDispatchTable();
+            }
+        }
+
+        if (m_MidiLoggerEvents.size() == MIDI_LOGGER_EVENTS_SIZE)
+        {
+            m_MidiLoggerEvents.pop_back();
+        }
+        m_MidiLoggerEvents.push_front(MidiEvent);
+    }
+}
+
+void IEMidi::ProcessChangedMidiProfiles()
+{
+    std::vector<std::string> ChangedMidiProfileNames;
+    {
+        std::scoped_lock ChangedMidiProfileNamesLock(m_ChangedMidiProfileNamesMutex);
+        ChangedMidiProfileNames.swap(m_ChangedMidiProfileNames);
+    }
+
+    IEMidiProcessor& MidiProcessor = GetMidiProcessor();
+    for (const std::string& MidiDeviceName : ChangedMidiProfileNames)
+    {
+        if (!MidiProcessor.HasActiveMidiDeviceProfile(MidiDeviceName))
+        {
+            continue;
+        }
+
+        // Unsaved edits win over the file, saving them overwrites the external change anyway
+        if (MidiDeviceName == m_EditedMidiDeviceName && m_AppState == IEAppState::MidiDeviceEditor)
+        {
+            IELOG_ERROR("Profile %s changed on disk while being edited, the external change is ignored", MidiDeviceName.c_str());
+            continue;
+        }
+
+        // Only the dispatch table is swapped, the ports stay open and no initial messages are sent again
+        const IEResult Result = GetMidiProfileManager().LoadProfile(MidiProcessor.GetActiveMidiDeviceProfile(MidiDeviceName));
+        if (Result)
+        {
+            MidiProcessor.RefreshMidiDispatchTable(MidiDeviceName);
+            IELOG_SUCCESS("Reloaded profile %s", MidiDeviceName.c_str());
+        }
+        else
+        {
+            IELOG_ERROR("%s", Result.Message.c_str());
+        }
+    }
+}
+
+IEResult IEMidi::ActivateMidiDevice(const std::string& MidiDeviceName)
+{
+    IEMidiProcessor& MidiProcessor = GetMidiProcessor();
+    if (MidiProcessor.HasActiveMidiDeviceProfile(MidiDeviceName))
+    {
+        return IEResult(IEResult::Type::Success, std::format("Midi device profile {} is already active", MidiDeviceName));
+    }
+
+    const IEResult Result = MidiProcessor.ActivateMidiDeviceProfile(MidiDeviceName);
+    if (Result)
+    {
+        IEMidiDeviceProfile& ActiveMidiDeviceProfile = MidiProcessor.GetActiveMidiDeviceProfile(MidiDeviceName);
+        GetMidiProfileManager().LoadProfile(ActiveMidiDeviceProfile);
+        MidiProcessor.RefreshMidiDispatchTable(MidiDeviceName);
+        MidiProcessor.SendInitialOutputMidiMessages(MidiDeviceName);
+    }
+    return Result;
+}
+
 void IEMidi::DrawMidiDeviceSelectionWindow()
 {
     static constexpr uint32_t WindowFlags = ImGuiWindowFlags_NoResize |
@@ -90,20 +198,21 @@ void IEMidi::DrawMidiDeviceSelectionWindow()
             ImGui::Separator();
 
             ImGui::SetSmartCursorPosY(80.0f);
-            static const char ActivateText[] = "Activate";
             ImGui::SetSmartCursorPosX(WindowWidth * 0.5f - ImGui::IEStyle::GetDefaultButtonSize().x - 8.0f);
-            if (ImGui::IEStyle::DefaultButton(ActivateText))
+            if (MidiProcessor.HasActiveMidiDeviceProfile(MidiDeviceName))
             {
-                if (MidiProcessor.ActivateMidiDeviceProfile(MidiDeviceName))
+                static const char DeactivateText[] = "Deactivate";
+                if (ImGui::IEStyle::RedButton(DeactivateText))
                 {
-                    IEMidiDeviceProfile& ActiveMidiDeviceProfile = MidiProcessor.GetActiveMidiDeviceProfile();
-                    GetMidiProfileManager().LoadProfile(ActiveMidiDeviceProfile);
-                    for (const std::vector<unsigned char>& MidiMessage : ActiveMidiDeviceProfile.InitialOutputMidiMessages)
-                    {
-                        MidiProcessor.SendMidiOutputMessage(MidiMessage);
-                    }
-                    
-                    GetRenderer().CloseAppWindow();
+                    MidiProcessor.DeactivateMidiDeviceProfile(MidiDeviceName);
+                }
+            }
+            else
+            {
+                static const char ActivateText[] = "Activate";
+                if (ImGui::IEStyle::DefaultButton(ActivateText))
+                {
+                    ActivateMidiDevice(MidiDeviceName);
                 }
             }
 
@@ -113,15 +222,9 @@ void IEMidi::DrawMidiDeviceSelectionWindow()
             ImGui::SetSmartCursorPosX(WindowWidth * 0.5f + 8.0f);
             if (ImGui::IEStyle::DefaultButton(EditText))
             {
-                if (MidiProcessor.ActivateMidiDeviceProfile(MidiDeviceName))
+                if (ActivateMidiDevice(MidiDeviceName))
                 {
-                    IEMidiDeviceProfile& ActiveMidiDeviceProfile = MidiProcessor.GetActiveMidiDeviceProfile();
-                    GetMidiProfileManager().LoadProfile(ActiveMidiDeviceProfile);
-                    for (const std::vector<unsigned char>& MidiMessage : ActiveMidiDeviceProfile.InitialOutputMidiMessages)
-                    {
-                        MidiProcessor.SendMidiOutputMessage(MidiMessage);
-                    }
-
+                    m_EditedMidiDeviceName = MidiDeviceName;
                     SetAppState(IEAppState::MidiDeviceEditor);
                 }
             }
@@ -160,7 +263,12 @@ void IEMidi::DrawSelectedMidiDeviceEditorWindow()
     ImGui::SetNextWindowPos(ImVec2(WindowPosX, WindowPosY));
 
     IEMidiProcessor& MidiProcessor = GetMidiProcessor();
-    IEMidiDeviceProfile& ActiveMidiDeviceProfile = MidiProcessor.GetActiveMidiDeviceProfile();
+    if (!MidiProcessor.HasActiveMidiDeviceProfile(m_EditedMidiDeviceName))
+    {
+        SetAppState(IEAppState::MidiDeviceSelection);
+        return;
+    }
+    IEMidiDeviceProfile& ActiveMidiDeviceProfile = MidiProcessor.GetActiveMidiDeviceProfile(m_EditedMidiDeviceName);
 
     const std::string WindowLabel = std::format("Editing {}", ActiveMidiDeviceProfile.Name);
 
@@ -175,7 +283,9 @@ void IEMidi::DrawSelectedMidiDeviceEditorWindow()
     {
         if (GetMidiProfileManager().SaveProfile(ActiveMidiDeviceProfile))
         {
-            MidiProcessor.DeactivateMidiDeviceProfile();
+            // Initial output messages are edited in place, the table the output scheduler reads them from is rebuilt here
+            GetMidiProcessor().RefreshMidiDispatchTable(ActiveMidiDeviceProfile.Name);
+            m_EditedMidiDeviceName.clear();
             SetAppState(IEAppState::MidiDeviceSelection);
         }
     }
@@ -205,7 +315,8 @@ void IEMidi::DrawSideBar()
     ImGui::Begin("MidiDeviceInfoWindow", nullptr, WindowFlags);
 
     const IEMidiProcessor& MidiProcessor = GetMidiProcessor();
-    RtMidiIn& MidiIn = MidiProcessor.GetMidiIn();
+    const std::shared_ptr<IEMidiDeviceSession> EditedMidiDeviceSession = MidiProcessor.FindMidiDeviceSession(m_EditedMidiDeviceName);
+    RtMidiIn& MidiIn = EditedMidiDeviceSession ? EditedMidiDeviceSession->GetMidiIn() : MidiProcessor.GetMidiIn();
 
     ImGui::PushFont(ImGui::IEStyle::GetTitleFont());
     ImGui::WindowPositionedText(0.5f, 0.035f, "Midi Device Info");
@@ -231,23 +342,30 @@ void IEMidi::DrawSideBar()
         ImGui::Text("Name:");
         ImGui::PopFont();
         ImGui::TableNextColumn();
-        ImGui::Text("%s", MidiProcessor.HasActiveMidiDeviceProfile() ? MidiProcessor.GetActiveMidiDeviceProfile().Name.c_str() : "No Active Midi Profile");
+        ImGui::Text("%s", EditedMidiDeviceSession ? EditedMidiDeviceSession->GetMidiDeviceProfile().Name.c_str() : "No Active Midi Profile");
 
         ImGui::TableNextColumn();
         ImGui::PushFont(ImGui::IEStyle::GetBoldFont());
         ImGui::Text("Input Port:");
         ImGui::PopFont();
         ImGui::TableNextColumn();
-        ImGui::Text("%s", MidiProcessor.HasActiveMidiDeviceProfile() ?
-            std::to_string(MidiProcessor.GetActiveMidiDeviceProfile().GetInputPortNumber()).c_str() : "No Active Midi Profile");
+        ImGui::Text("%s", EditedMidiDeviceSession ?
+            std::to_string(EditedMidiDeviceSession->GetMidiDeviceProfile().GetInputPortNumber()).c_str() : "No Active Midi Profile");
 
         ImGui::TableNextColumn();
         ImGui::PushFont(ImGui::IEStyle::GetBoldFont());
         ImGui::Text("Output Port:");
         ImGui::PopFont();
         ImGui::TableNextColumn();
-        ImGui::Text("%s", MidiProcessor.HasActiveMidiDeviceProfile() ?
-            std::to_string(MidiProcessor.GetActiveMidiDeviceProfile().GetOutputPortNumber()).c_str() : "No Active Midi Profile");
+        ImGui::Text("%s", EditedMidiDeviceSession ?
+            std::to_string(EditedMidiDeviceSession->GetMidiDeviceProfile().GetOutputPortNumber()).c_str() : "No Active Midi Profile");
+
+        ImGui::TableNextColumn();
+        ImGui::PushFont(ImGui::IEStyle::GetBoldFont());
+        ImGui::Text("Active Devices:");
+        ImGui::PopFont();
+        ImGui::TableNextColumn();
+        ImGui::Text("%zu", MidiProcessor.GetMidiDeviceSessions().size());
 
         ImGui::TableNextColumn();
         ImGui::PushFont(ImGui::IEStyle::GetBoldFont());
@@ -263,17 +381,88 @@ void IEMidi::DrawSideBar()
         ImGui::TableNextColumn();
         ImGui::Text("%s", MidiIn.getVersion().c_str());
 
+        ImGui::TableNextColumn();
+        ImGui::PushFont(ImGui::IEStyle::GetBoldFont());
+        ImGui::Text("Dropped Actions:");
+        ImGui::PopFont();
+        ImGui::TableNextColumn();
+        uint64_t DroppedActionCount = 0;
+        for (int ActionTypeIndex = 0; ActionTypeIndex < static_cast<int>(IEMidiActionType::Count); ActionTypeIndex++)
+        {
+            DroppedActionCount += MidiProcessor.GetMidiActionExecutor().GetActionStats(static_cast<IEMidiActionType>(ActionTypeIndex)).DroppedCount;
+        }
+        ImGui::Text("%llu", static_cast<unsigned long long>(DroppedActionCount));
+
+        ImGui::TableNextColumn();
+        ImGui::PushFont(ImGui::IEStyle::GetBoldFont());
+        ImGui::Text("Coalesced CCs:");
+        ImGui::PopFont();
+        ImGui::TableNextColumn();
+        const IEMidiCoalescingStats MidiCoalescingStats = MidiProcessor.GetMidiCoalescingStats();
+        ImGui::Text("%llu merged / %llu applied", static_cast<unsigned long long>(MidiCoalescingStats.MergedCount),
+            static_cast<unsigned long long>(MidiCoalescingStats.AppliedCount));
+
+        ImGui::TableNextColumn();
+        ImGui::PushFont(ImGui::IEStyle::GetBoldFont());
+        ImGui::Text("Macros:");
+        ImGui::PopFont();
+        ImGui::TableNextColumn();
+        const IEMidiMacroStats MidiMacroStats = MidiProcessor.GetMidiMacroStats();
+        ImGui::Text("%llu started / %llu cancelled", static_cast<unsigned long long>(MidiMacroStats.StartedCount),
+            static_cast<unsigned long long>(MidiMacroStats.CancelledCount));
+
+        ImGui::TableNextColumn();
+        ImGui::PushFont(ImGui::IEStyle::GetBoldFont());
+        ImGui::Text("Command Runner:");
+        ImGui::PopFont();
+        ImGui::TableNextColumn();
+        const IEMidiConsoleCommandRunnerStats ConsoleCommandRunnerStats = MidiProcessor.GetMidiActionExecutor().GetConsoleCommandRunnerStats();
+        ImGui::Text("%llu sent / %llu dropped / %llu spawned", static_cast<unsigned long long>(ConsoleCommandRunnerStats.SentCount),
+            static_cast<unsigned long long>(ConsoleCommandRunnerStats.DroppedCount), static_cast<unsigned long long>(ConsoleCommandRunnerStats.SpawnedCount));
+
+        static const char* const ActionLatencyLabels[static_cast<int>(IEMidiActionType::Count)] =
+            { "", "Volume Latency:", "Mute Latency:", "Command Latency:", "Open File Latency:", "Macro Latency:" };
+        const IEMidiLatencyMonitor& MidiLatencyMonitor = MidiProcessor.GetMidiActionExecutor().GetLatencyMonitor();
+        for (int ActionTypeIndex = 1; ActionTypeIndex < static_cast<int>(IEMidiActionType::Count); ActionTypeIndex++)
+        {
+            const IEMidiLatencySummary LatencySummary = MidiLatencyMonitor.GetLatencySummary(static_cast<IEMidiActionType>(ActionTypeIndex), IEMidiLatencyStage::Total);
+            if (LatencySummary.SampleCount > 0)
+            {
+                ImGui::TableNextColumn();
+                ImGui::PushFont(ImGui::IEStyle::GetBoldFont());
+                ImGui::Text("%s", ActionLatencyLabels[ActionTypeIndex]);
+                ImGui::PopFont();
+                ImGui::TableNextColumn();
+                ImGui::TextWrapped("p50 %.2fms p99 %.2fms max %.2fms", LatencySummary.P50Ns * 1e-6, LatencySummary.P99Ns * 1e-6, LatencySummary.MaxNs * 1e-6);
+            }
+        }
+
         ImGui::TableNextColumn();
         ImGui::PushFont(ImGui::IEStyle::GetBoldFont());
         ImGui::Text("Save File:");
         ImGui::PopFont();
         ImGui::TableNextColumn();
-        ImGui::TextWrapped("%s", GetMidiProfileManager().GetIEMidiProfilesFilePath().string().c_str());
+        ImGui::TextWrapped("%s", GetMidiProfileManager().GetIEMidiProfileLibraryFilePath().string().c_str());
         ImGui::TableNextColumn();
 
         ImGui::EndTable();
     }
     ImGui::PopStyleColor();
+
+    if (ImGui::IEStyle::DefaultButton("Export Latency Report"))
+    {
+        const std::filesystem::path LatencyReportFilePath = IEUtils::GetIEConfigFolderPath() / MIDI_LATENCY_REPORT_FILENAME;
+        const IEResult Result = MidiProcessor.GetMidiActionExecutor().GetLatencyMonitor().ExportLatencyReport(LatencyReportFilePath);
+        if (Result)
+        {
+            IELOG_SUCCESS("%s", Result.Message.c_str());
+        }
+        else
+        {
+            IELOG_ERROR("%s", Result.Message.c_str());
+        }
+    }
+
     ImGui::End();
 
     /* End Midi Device Info */
@@ -329,24 +518,21 @@ void IEMidi::DrawSideBar()
         ImGui::TableSetupColumn("Data2Column", ImGuiTableColumnFlags_WidthStretch, MidiLoggerColumnWidth);
         ImGui::TableNextRow();
 
-        std::deque<std::vector<unsigned char>> Copy = GetMidiProcessor().GetIncomingMidiMessages();
-        while (!Copy.empty())
+        for (const IEMidiEvent& MidiEvent : m_MidiLoggerEvents)
         {
             if (ImGui::GetCursorPosY() > MidiLoggerWindowHeight - ImGui::TableGetHeaderRowHeight() * 2.0f)
             {
                 break;
             }
 
-            const std::vector<unsigned char>& MidiMessage = Copy.front();
-            for (int i = 0; i < MidiMessage.size(); i++)
+            for (int i = 0; i < MidiEvent.MidiMessage.size(); i++)
             {
-                const unsigned char& Byte = MidiMessage[i];
+                const unsigned char& Byte = MidiEvent.MidiMessage[i];
                 ImGui::TableNextColumn();
                 const std::string ByteString = std::to_string(static_cast<int>(Byte));
                 ImGui::SetSmartCursorPosX(MidiLoggerTableStartCursor + MidiLoggerColumnWidth * static_cast<float>(i) - ImGui::CalcTextSize(ByteString.c_str()).x * 0.5f);
                 ImGui::Text("%s", ByteString.c_str());
             }
-            Copy.pop_front();
         }
         ImGui::PopFont();
         ImGui::EndTable();
@@ -372,7 +558,28 @@ void IEMidi::OnAppWindowRestored(uint32_t WindowID, void* UserData)
 {
     if (IEMidi* const IEMidiApp = reinterpret_cast<IEMidi*>(UserData))
     {
-        IEMidiApp->GetMidiProcessor().DeactivateMidiDeviceProfile();
         IEMidiApp->SetAppState(IEAppState::MidiDeviceSelection);
     }
+}
+
+void IEMidi::OnMidiProfilesChanged(const std::vector<std::string>& ChangedProfileNames, void* UserData)
+{
+    // Called from the profiles watcher thread, the reload itself happens on the render thread
+    if (IEMidi* const IEMidiApp = reinterpret_cast<IEMidi*>(UserData))
+    {
+        {
+            std::scoped_lock ChangedMidiProfileNamesLock(IEMidiApp->m_ChangedMidiProfileNamesMutex);
+            IEMidiApp->m_ChangedMidiProfileNames.insert(IEMidiApp->m_ChangedMidiProfileNames.end(), ChangedProfileNames.begin(), ChangedProfileNames.end());
+        }
+        IEMidiApp->GetRenderer().PostEmptyEvent();
+    }
+}
+
+void IEMidi::OnMidiDevicesChanged(void* UserData)
+{
+    // Called from the device registry listener thread, wakes the render loop so the device list redraws
+    if (IEMidi* const IEMidiApp = reinterpret_cast<IEMidi*>(UserData))
+    {
+        IEMidiApp->GetRenderer().PostEmptyEvent();
+    }
 }
\ No newline at end of file
@@ -14,6 +14,9 @@
 #include "IEMidiProfileManager.h"
 #include "IEMidiTypes.h"
 
+static constexpr size_t MIDI_LOGGER_EVENTS_SIZE = 20;
+static constexpr char MIDI_LATENCY_REPORT_FILENAME[] = "latency.csv";
+
 enum class IEAppState : uint16_t
 {
     Loading,
@@ -27,6 +30,7 @@ class IEMidi
 {
 public:
     IEMidi();
+    ~IEMidi();
 
 public:
     IERenderer& GetRenderer() const { return *m_Renderer; }
@@ -43,6 +47,11 @@ public:
     void OnPreFrameRender();
     void OnPostFrameRender();
 
+private:
+    void ProcessIncomingMidiEvents();
+    void ProcessChangedMidiProfiles();
+    IEResult ActivateMidiDevice(const std::string& MidiDeviceName);
+
 private:
     void DrawMidiDeviceSelectionWindow();
     void DrawSelectedMidiDeviceEditorWindow();
@@ -51,6 +60,8 @@ private:
 private:
     static void OnAppWindowClosed(uint32_t WindowID, void* UserData);
     static void OnAppWindowRestored(uint32_t WindowID, void* UserData);
+    static void OnMidiProfilesChanged(const std::vector<std::string>& ChangedProfileNames, void* UserData);
+    static void OnMidiDevicesChanged(void* UserData);
 
 private:
     std::shared_ptr<IERenderer> m_Renderer;
@@ -60,6 +71,16 @@ private:
     std::unique_ptr<IEMidiProfileManager> m_MidiProfileManager;
     std::unique_ptr<IEMidiEditor> m_MidiEditor;
 
+private:
+    std::deque<IEMidiEvent> m_MidiLoggerEvents;
+
+private:
+    std::vector<std::string> m_ChangedMidiProfileNames;
+    std::mutex m_ChangedMidiProfileNamesMutex;
+
+private:
+    std::string m_EditedMidiDeviceName;
+
 private:
     IEAppState m_AppState = IEAppState::None;
     float m_WindowOffsetAbs = 30.0f;
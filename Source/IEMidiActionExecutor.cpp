@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiActionExecutor.h"
+
+IEMidiActionExecutor::IEMidiActionExecutor(std::unique_ptr<IEAction_Volume> VolumeAction,
+                                           std::unique_ptr<IEAction_Mute> MuteAction,
+                                           std::unique_ptr<IEAction_ConsoleCommand> ConsoleCommandAction,
+                                           std::unique_ptr<IEAction_OpenFile> OpenFileAction,
+                                           size_t LaneCapacity,
+                                           size_t ConsoleCommandLaneCount) :
+    m_VolumeAction(std::move(VolumeAction)),
+    m_MuteAction(std::move(MuteAction)),
+    m_ConsoleCommandAction(std::move(ConsoleCommandAction)),
+    m_OpenFileAction(std::move(OpenFileAction)),
+    m_VolumeLane(std::make_unique<IEMidiActionLane>(LaneCapacity)),
+    m_MuteLane(std::make_unique<IEMidiActionLane>(LaneCapacity)),
+    m_OpenFileLane(std::make_unique<IEMidiActionLane>(LaneCapacity))
+{
+    for (size_t LaneIndex = 0; LaneIndex < std::max<size_t>(ConsoleCommandLaneCount, 1); LaneIndex++)
+    {
+        m_ConsoleCommandLanes.emplace_back(std::make_unique<IEMidiActionLane>(LaneCapacity));
+    }
+
+    m_VolumeLane->Worker = std::thread(&IEMidiActionExecutor::RunActionLane, this, std::ref(*m_VolumeLane));
+    m_MuteLane->Worker = std::thread(&IEMidiActionExecutor::RunActionLane, this, std::ref(*m_MuteLane));
+    m_OpenFileLane->Worker = std::thread(&IEMidiActionExecutor::RunActionLane, this, std::ref(*m_OpenFileLane));
+    for (std::unique_ptr<IEMidiActionLane>& ConsoleCommandLane : m_ConsoleCommandLanes)
+    {
+        ConsoleCommandLane->Worker = std::thread(&IEMidiActionExecutor::RunActionLane, this, std::ref(*ConsoleCommandLane));
+    }
+}
+
+IEMidiActionExecutor::~IEMidiActionExecutor()
+{
+    std::vector<IEMidiActionLane*> MidiActionLanes = { m_VolumeLane.get(), m_MuteLane.get(), m_OpenFileLane.get() };
+    for (std::unique_ptr<IEMidiActionLane>& ConsoleCommandLane : m_ConsoleCommandLanes)
+    {
+        MidiActionLanes.push_back(ConsoleCommandLane.get());
+    }
+
+    for (IEMidiActionLane* const MidiActionLane : MidiActionLanes)
+    {
+        {
+            std::scoped_lock LaneLock(MidiActionLane->Mutex);
+            MidiActionLane->bIsStopping = true;
+        }
+        MidiActionLane->ConditionVariable.notify_all();
+    }
+
+    for (IEMidiActionLane* const MidiActionLane : MidiActionLanes)
+    {
+        if (MidiActionLane->Worker.joinable())
+        {
+            MidiActionLane->Worker.join();
+        }
+    }
+}
+
+bool IEMidiActionExecutor::HasAction(IEMidiActionType MidiActionType) const
+{
+    switch (MidiActionType)
+    {
+        case IEMidiActionType::Volume: return m_VolumeAction != nullptr;
+        case IEMidiActionType::Mute: return m_MuteAction != nullptr;
+        case IEMidiActionType::ConsoleCommand: return m_ConsoleCommandAction != nullptr;
+        case IEMidiActionType::OpenFile: return m_OpenFileAction != nullptr;
+        default: return false;
+    }
+}
+
+float IEMidiActionExecutor::GetVolume() const
+{
+    std::scoped_lock VolumeActionLock(m_VolumeActionMutex);
+    return m_VolumeAction->GetVolume();
+}
+
+bool IEMidiActionExecutor::GetMute() const
+{
+    std::scoped_lock MuteActionLock(m_MuteActionMutex);
+    return m_MuteAction->GetMute();
+}
+
+bool IEMidiActionExecutor::SubmitActionTask(IEMidiActionTask&& MidiActionTask)
+{
+    bool bSubmitted = false;
+
+    const size_t ActionTypeIndex = static_cast<size_t>(MidiActionTask.MidiActionType);
+    if (HasAction(MidiActionTask.MidiActionType) && IEAssert(ActionTypeIndex < m_ActionCounters.size()))
+    {
+        IEMidiActionCounters& ActionCounters = m_ActionCounters[ActionTypeIndex];
+        IEMidiActionLane& MidiActionLane = GetActionLane(MidiActionTask);
+
+        size_t QueueDepth = 0;
+        {
+            std::scoped_lock LaneLock(MidiActionLane.Mutex);
+            if (MidiActionLane.TaskCount < MidiActionLane.Tasks.size())
+            {
+                const size_t TaskIndex = (MidiActionLane.HeadIndex + MidiActionLane.TaskCount) % MidiActionLane.Tasks.size();
+                MidiActionLane.Tasks[TaskIndex] = std::move(MidiActionTask);
+                QueueDepth = ++MidiActionLane.TaskCount;
+                bSubmitted = true;
+            }
+        }
+
+        if (bSubmitted)
+        {
+            MidiActionLane.ConditionVariable.notify_one();
+            ActionCounters.EnqueuedCount.fetch_add(1, std::memory_order_relaxed);
+
+            uint64_t MaxQueueDepth = ActionCounters.MaxQueueDepth.load(std::memory_order_relaxed);
+            while (QueueDepth > MaxQueueDepth && !ActionCounters.MaxQueueDepth.compare_exchange_weak(MaxQueueDepth, QueueDepth, std::memory_order_relaxed));
+        }
+        else
+        {
+            ActionCounters.DroppedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return bSubmitted;
+}
+
+IEMidiActionStats IEMidiActionExecutor::GetActionStats(IEMidiActionType MidiActionType) const
+{
+    IEMidiActionStats MidiActionStats;
+
+    const size_t ActionTypeIndex = static_cast<size_t>(MidiActionType);
+    if (ActionTypeIndex < m_ActionCounters.size())
+    {
+        const IEMidiActionCounters& ActionCounters = m_ActionCounters[ActionTypeIndex];
+        MidiActionStats.EnqueuedCount = ActionCounters.EnqueuedCount.load(std::memory_order_relaxed);
+        MidiActionStats.ExecutedCount = ActionCounters.ExecutedCount.load(std::memory_order_relaxed);
+        MidiActionStats.DroppedCount = ActionCounters.DroppedCount.load(std::memory_order_relaxed);
+        MidiActionStats.MaxQueueDepth = ActionCounters.MaxQueueDepth.load(std::memory_order_relaxed);
+    }
+    return MidiActionStats;
+}
+
+IEMidiActionExecutor::IEMidiActionLane& IEMidiActionExecutor::GetActionLane(const IEMidiActionTask& MidiActionTask)
+{
+    switch (MidiActionTask.MidiActionType)
+    {
+        case IEMidiActionType::Volume:
+        {
+            return *m_VolumeLane;
+        }
+        case IEMidiActionType::Mute:
+        {
+            return *m_MuteLane;
+        }
+        case IEMidiActionType::ConsoleCommand:
+        {
+            const uint32_t PropertyRuntimeID = MidiActionTask.MidiDispatchTable->GetEntry(MidiActionTask.EntryIndex).PropertyRuntimeID;
+            return *m_ConsoleCommandLanes[PropertyRuntimeID % m_ConsoleCommandLanes.size()];
+        }
+        default:
+        {
+            return *m_OpenFileLane;
+        }
+    }
+}
+
+void IEMidiActionExecutor::RunActionLane(IEMidiActionLane& MidiActionLane)
+{
+    while (true)
+    {
+        IEMidiActionTask MidiActionTask;
+        {
+            std::unique_lock LaneLock(MidiActionLane.Mutex);
+            MidiActionLane.ConditionVariable.wait(LaneLock, [&MidiActionLane]() { return MidiActionLane.bIsStopping || MidiActionLane.TaskCount > 0; });
+            if (MidiActionLane.bIsStopping)
+            {
+                break;
+            }
+
+            MidiActionTask = std::move(MidiActionLane.Tasks[MidiActionLane.HeadIndex]);
+            MidiActionLane.HeadIndex = (MidiActionLane.HeadIndex + 1) % MidiActionLane.Tasks.size();
+            MidiActionLane.TaskCount--;
+        }
+
+        MidiActionTask.LatencyTimestamps.ActionStartTime = IEClock::now();
+        ExecuteActionTask(MidiActionTask);
+        MidiActionTask.LatencyTimestamps.ActionEndTime = IEClock::now();
+
+        m_LatencyMonitor.RecordLatency(MidiActionTask.MidiActionType, MidiActionTask.LatencyTimestamps);
+        m_ActionCounters[static_cast<size_t>(MidiActionTask.MidiActionType)].ExecutedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void IEMidiActionExecutor::ExecuteActionTask(const IEMidiActionTask& MidiActionTask)
+{
+    switch (MidiActionTask.MidiActionType)
+    {
+        case IEMidiActionType::Volume:
+        {
+            std::scoped_lock VolumeActionLock(m_VolumeActionMutex);
+            m_VolumeAction->SetVolume(MidiActionTask.Value);
+            break;
+        }
+        case IEMidiActionType::Mute:
+        {
+            // Held across the toggle's read and write
+            std::scoped_lock MuteActionLock(m_MuteActionMutex);
+            if (MidiActionTask.bToggle)
+            {
+                m_MuteAction->SetMute(!m_MuteAction->GetMute());
+            }
+            else
+            {
+                m_MuteAction->SetMute(MidiActionTask.Value != 0.0f);
+            }
+            break;
+        }
+        case IEMidiActionType::ConsoleCommand:
+        {
+            const IEMidiDispatchEntry& MidiDispatchEntry = MidiActionTask.MidiDispatchTable->GetEntry(MidiActionTask.EntryIndex);
+            const std::string& ConsoleCommand = MidiActionTask.MacroStepIndex >= 0 ?
+                MidiActionTask.MidiDispatchTable->GetMacroSteps(MidiActionTask.EntryIndex)[MidiActionTask.MacroStepIndex].ConsoleCommand :
+                MidiDispatchEntry.ConsoleCommand;
+            if (MidiActionTask.MacroStepIndex < 0 && MidiDispatchEntry.bPersistentConsoleCommand && IEMidiConsoleCommandRunner::IsSupported())
+            {
+                m_ConsoleCommandRunner.SubmitValue(MidiDispatchEntry.PropertyRuntimeID, ConsoleCommand, MidiDispatchEntry.ConsoleCommandWorkerCount,
+                                                   MidiDispatchEntry.ConsoleCommandQueueDepth, MidiActionTask.Value);
+            }
+            else
+            {
+                m_ConsoleCommandAction->ExecuteConsoleCommand(ConsoleCommand, MidiActionTask.Value);
+            }
+            break;
+        }
+        case IEMidiActionType::OpenFile:
+        {
+            const IEMidiDispatchEntry& MidiDispatchEntry = MidiActionTask.MidiDispatchTable->GetEntry(MidiActionTask.EntryIndex);
+            m_OpenFileAction->OpenFile(MidiDispatchEntry.OpenFilePath);
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include "IEActions.h"
+#include "IECore.h"
+
+#include "IEMidiConsoleCommandRunner.h"
+#include "IEMidiDispatchTable.h"
+#include "IEMidiLatencyMonitor.h"
+#include "IEMidiTypes.h"
+
+static constexpr size_t DEFAULT_MIDI_ACTION_LANE_CAPACITY = 512;
+static constexpr size_t DEFAULT_MIDI_CONSOLE_COMMAND_LANE_COUNT = 2;
+
+struct IEMidiActionTask
+{
+public:
+    IEMidiActionType MidiActionType = IEMidiActionType::None;
+    std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable;
+    uint32_t EntryIndex = 0;
+    float Value = 0.0f;
+    bool bToggle = false;
+    /* Macro step the task was issued by, its console command replaces the entry's, -1 for tasks issued by the entry itself */
+    int32_t MacroStepIndex = -1;
+    IEMidiLatencyTimestamps LatencyTimestamps = IEMidiLatencyTimestamps();
+};
+
+struct IEMidiActionStats
+{
+public:
+    uint64_t EnqueuedCount = 0;
+    uint64_t ExecutedCount = 0;
+    uint64_t DroppedCount = 0;
+    uint64_t MaxQueueDepth = 0;
+};
+
+/*
+* Runs actions off the RtMidi callback thread.
+* Volume, Mute and OpenFile each run on their own lane in submission order.
+* ConsoleCommand runs on a pool of lanes, ordered per property, a persistent command only hands its value to the runner.
+* Lanes are bounded, a task submitted to a full lane is dropped and counted.
+* The volume and mute backends are not thread safe, every call into them holds that backend's lock.
+* Macro is not an action of its own, its steps are submitted here as Volume, Mute and ConsoleCommand tasks by the processor.
+*/
+class IEMidiActionExecutor
+{
+public:
+    IEMidiActionExecutor() = delete;
+    IEMidiActionExecutor(std::unique_ptr<IEAction_Volume> VolumeAction,
+                         std::unique_ptr<IEAction_Mute> MuteAction,
+                         std::unique_ptr<IEAction_ConsoleCommand> ConsoleCommandAction,
+                         std::unique_ptr<IEAction_OpenFile> OpenFileAction,
+                         size_t LaneCapacity = DEFAULT_MIDI_ACTION_LANE_CAPACITY,
+                         size_t ConsoleCommandLaneCount = DEFAULT_MIDI_CONSOLE_COMMAND_LANE_COUNT);
+    ~IEMidiActionExecutor();
+
+public:
+    bool HasAction(IEMidiActionType MidiActionType) const;
+    bool SubmitActionTask(IEMidiActionTask&& MidiActionTask);
+    IEMidiActionStats GetActionStats(IEMidiActionType MidiActionType) const;
+
+    /* Backend state read under the lock of the lane that changes it, used to mirror it back to the devices, check HasAction first */
+    float GetVolume() const;
+    bool GetMute() const;
+    IEMidiLatencyMonitor& GetLatencyMonitor() { return m_LatencyMonitor; }
+    const IEMidiLatencyMonitor& GetLatencyMonitor() const { return m_LatencyMonitor; }
+    IEMidiConsoleCommandRunnerStats GetConsoleCommandRunnerStats() const { return m_ConsoleCommandRunner.GetStats(); }
+
+private:
+    struct IEMidiActionLane
+    {
+    public:
+        IEMidiActionLane(size_t Capacity) : Tasks(Capacity) {}
+
+    public:
+        std::vector<IEMidiActionTask> Tasks;
+        size_t HeadIndex = 0;
+        size_t TaskCount = 0;
+        bool bIsStopping = false;
+        std::mutex Mutex;
+        std::condition_variable ConditionVariable;
+        std::thread Worker;
+    };
+
+    struct IEMidiActionCounters
+    {
+    public:
+        std::atomic<uint64_t> EnqueuedCount = 0;
+        std::atomic<uint64_t> ExecutedCount = 0;
+        std::atomic<uint64_t> DroppedCount = 0;
+        std::atomic<uint64_t> MaxQueueDepth = 0;
+    };
+
+private:
+    IEMidiActionLane& GetActionLane(const IEMidiActionTask& MidiActionTask);
+    void RunActionLane(IEMidiActionLane& MidiActionLane);
+    void ExecuteActionTask(const IEMidiActionTask& MidiActionTask);
+
+private:
+    std::unique_ptr<IEAction_Volume> m_VolumeAction;
+    std::unique_ptr<IEAction_Mute> m_MuteAction;
+    std::unique_ptr<IEAction_ConsoleCommand> m_ConsoleCommandAction;
+    std::unique_ptr<IEAction_OpenFile> m_OpenFileAction;
+    IEMidiConsoleCommandRunner m_ConsoleCommandRunner;
+    mutable std::mutex m_VolumeActionMutex;
+    mutable std::mutex m_MuteActionMutex;
+
+private:
+    std::unique_ptr<IEMidiActionLane> m_VolumeLane;
+    std::unique_ptr<IEMidiActionLane> m_MuteLane;
+    std::unique_ptr<IEMidiActionLane> m_OpenFileLane;
+    std::vector<std::unique_ptr<IEMidiActionLane>> m_ConsoleCommandLanes;
+    std::array<IEMidiActionCounters, static_cast<size_t>(IEMidiActionType::Count)> m_ActionCounters;
+    IEMidiLatencyMonitor m_LatencyMonitor;
+};
@@ -0,0 +1,384 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiConsoleCommandRunner.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+IEMidiConsoleCommandRunner::IEMidiConsoleCommandRunner()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    if (CreateClosedOnExecPipe(m_WakeFileDescriptors))
+    {
+        for (const int WakeFileDescriptor : m_WakeFileDescriptors)
+        {
+            fcntl(WakeFileDescriptor, F_SETFL, O_NONBLOCK);
+        }
+        m_Writer = std::thread(&IEMidiConsoleCommandRunner::RunWriter, this);
+    }
+#endif
+}
+
+IEMidiConsoleCommandRunner::~IEMidiConsoleCommandRunner()
+{
+    {
+        std::scoped_lock RunnerLock(m_Mutex);
+        m_bIsStopping = true;
+    }
+    WakeWriter();
+    if (m_Writer.joinable())
+    {
+        m_Writer.join();
+    }
+
+#if defined(__linux__) || defined(__APPLE__)
+    for (std::pair<const uint32_t, IEMidiConsoleCommandPool>& ConsoleCommandPool : m_ConsoleCommandPools)
+    {
+        for (IEMidiConsoleCommandWorker& ConsoleCommandWorker : ConsoleCommandPool.second.Workers)
+        {
+            StopWorker(ConsoleCommandWorker);
+        }
+    }
+
+    // Closed pipes end well behaved commands within the grace period, the others are terminated then killed,
+    // every wait is bounded so a command trapping signals cannot hold up shutdown
+    WaitForExitedWorkers(CONSOLE_COMMAND_WORKER_EXIT_TIMEOUT);
+    for (const int Signal : { SIGTERM, SIGKILL })
+    {
+        for (const int ProcessID : m_ExitingProcessIDs)
+        {
+            kill(ProcessID, Signal);
+        }
+        WaitForExitedWorkers(CONSOLE_COMMAND_WORKER_EXIT_TIMEOUT);
+    }
+
+    for (const int WakeFileDescriptor : m_WakeFileDescriptors)
+    {
+        if (WakeFileDescriptor >= 0)
+        {
+            close(WakeFileDescriptor);
+        }
+    }
+#endif
+}
+
+bool IEMidiConsoleCommandRunner::IsSupported()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void IEMidiConsoleCommandRunner::SubmitValue(uint32_t PropertyRuntimeID, const std::string& ConsoleCommand, uint32_t WorkerCount, uint32_t QueueDepth, float Value)
+{
+    {
+        std::scoped_lock RunnerLock(m_Mutex);
+        IEMidiConsoleCommandPool& ConsoleCommandPool = m_ConsoleCommandPools[PropertyRuntimeID];
+
+        const size_t PoolWorkerCount = std::clamp<uint32_t>(WorkerCount, 1, MAX_CONSOLE_COMMAND_WORKER_COUNT);
+        if (ConsoleCommandPool.ConsoleCommand != ConsoleCommand || ConsoleCommandPool.Workers.size() != PoolWorkerCount)
+        {
+            for (IEMidiConsoleCommandWorker& ConsoleCommandWorker : ConsoleCommandPool.Workers)
+            {
+                StopWorker(ConsoleCommandWorker);
+            }
+            ConsoleCommandPool.ConsoleCommand = ConsoleCommand;
+            ConsoleCommandPool.Workers = std::vector<IEMidiConsoleCommandWorker>(PoolWorkerCount);
+            ConsoleCommandPool.NextWorkerIndex = 0;
+        }
+
+        while (ConsoleCommandPool.PendingValues.size() >= std::max<uint32_t>(QueueDepth, 1))
+        {
+            ConsoleCommandPool.PendingValues.pop_front();
+            m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        ConsoleCommandPool.PendingValues.push_back(Value);
+        ConsoleCommandPool.LastSubmitTime = IEClock::now();
+    }
+    WakeWriter();
+}
+
+IEMidiConsoleCommandRunnerStats IEMidiConsoleCommandRunner::GetStats() const
+{
+    IEMidiConsoleCommandRunnerStats ConsoleCommandRunnerStats;
+    ConsoleCommandRunnerStats.SpawnedCount = m_SpawnedCount.load(std::memory_order_relaxed);
+    ConsoleCommandRunnerStats.SentCount = m_SentCount.load(std::memory_order_relaxed);
+    ConsoleCommandRunnerStats.DroppedCount = m_DroppedCount.load(std::memory_order_relaxed);
+    return ConsoleCommandRunnerStats;
+}
+
+void IEMidiConsoleCommandRunner::RunWriter()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    // A worker that exited raises SIGPIPE on the writing thread, it is blocked here and taken back after the failed write
+    sigset_t PipeSignalSet;
+    sigemptyset(&PipeSignalSet);
+    sigaddset(&PipeSignalSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &PipeSignalSet, nullptr);
+
+    std::vector<pollfd> PollFileDescriptors;
+    while (true)
+    {
+        int PollTimeoutMs = -1;
+        PollFileDescriptors.clear();
+        PollFileDescriptors.push_back(pollfd{ m_WakeFileDescriptors[0], POLLIN, 0 });
+        {
+            std::scoped_lock RunnerLock(m_Mutex);
+            for (const std::pair<const uint32_t, IEMidiConsoleCommandPool>& ConsoleCommandPool : m_ConsoleCommandPools)
+            {
+                for (const IEMidiConsoleCommandWorker& ConsoleCommandWorker : ConsoleCommandPool.second.Workers)
+                {
+                    if (!ConsoleCommandWorker.PendingInput.empty())
+                    {
+                        PollFileDescriptors.push_back(pollfd{ ConsoleCommandWorker.InputFileDescriptor, POLLOUT, 0 });
+                    }
+                }
+            }
+
+            if (!m_ConsoleCommandPools.empty() || !m_ExitingProcessIDs.empty())
+            {
+                PollTimeoutMs = static_cast<int>(CONSOLE_COMMAND_RUNNER_POLL_INTERVAL.count());
+            }
+        }
+
+        poll(PollFileDescriptors.data(), PollFileDescriptors.size(), PollTimeoutMs);
+
+        char WakeBuffer[64];
+        while (read(m_WakeFileDescriptors[0], WakeBuffer, sizeof(WakeBuffer)) > 0);
+
+        std::scoped_lock RunnerLock(m_Mutex);
+        if (m_bIsStopping)
+        {
+            break;
+        }
+
+        const IEClock::time_point Now = IEClock::now();
+        for (std::unordered_map<uint32_t, IEMidiConsoleCommandPool>::iterator It = m_ConsoleCommandPools.begin(); It != m_ConsoleCommandPools.end();)
+        {
+            IEMidiConsoleCommandPool& ConsoleCommandPool = It->second;
+            WritePendingValues(ConsoleCommandPool);
+
+            const bool bHasPendingInput = std::any_of(ConsoleCommandPool.Workers.begin(), ConsoleCommandPool.Workers.end(),
+                [](const IEMidiConsoleCommandWorker& ConsoleCommandWorker) { return !ConsoleCommandWorker.PendingInput.empty(); });
+            if (ConsoleCommandPool.PendingValues.empty() && !bHasPendingInput && Now - ConsoleCommandPool.LastSubmitTime > CONSOLE_COMMAND_WORKER_IDLE_TIMEOUT)
+            {
+                for (IEMidiConsoleCommandWorker& ConsoleCommandWorker : ConsoleCommandPool.Workers)
+                {
+                    StopWorker(ConsoleCommandWorker);
+                }
+                It = m_ConsoleCommandPools.erase(It);
+            }
+            else
+            {
+                ++It;
+            }
+        }
+        ReapExitedWorkers();
+    }
+#endif
+}
+
+void IEMidiConsoleCommandRunner::WritePendingValues(IEMidiConsoleCommandPool& ConsoleCommandPool)
+{
+    for (IEMidiConsoleCommandWorker& ConsoleCommandWorker : ConsoleCommandPool.Workers)
+    {
+        if (!ConsoleCommandWorker.PendingInput.empty())
+        {
+            WritePendingInput(ConsoleCommandWorker);
+        }
+    }
+
+    while (!ConsoleCommandPool.PendingValues.empty())
+    {
+        // Next worker in turn whose previous line went through, none means every pipe is full and values keep waiting
+        const size_t WorkerCount = ConsoleCommandPool.Workers.size();
+        size_t WorkerIndex = 0;
+        while (WorkerIndex < WorkerCount && !ConsoleCommandPool.Workers[(ConsoleCommandPool.NextWorkerIndex + WorkerIndex) % WorkerCount].PendingInput.empty())
+        {
+            WorkerIndex++;
+        }
+        if (WorkerIndex == WorkerCount)
+        {
+            break;
+        }
+
+        IEMidiConsoleCommandWorker& ConsoleCommandWorker = ConsoleCommandPool.Workers[(ConsoleCommandPool.NextWorkerIndex + WorkerIndex) % WorkerCount];
+        ConsoleCommandPool.NextWorkerIndex = (ConsoleCommandPool.NextWorkerIndex + WorkerIndex + 1) % WorkerCount;
+        if (ConsoleCommandWorker.InputFileDescriptor < 0 && !SpawnWorker(ConsoleCommandPool.ConsoleCommand, ConsoleCommandWorker))
+        {
+            m_DroppedCount.fetch_add(ConsoleCommandPool.PendingValues.size(), std::memory_order_relaxed);
+            ConsoleCommandPool.PendingValues.clear();
+            break;
+        }
+
+        ConsoleCommandWorker.PendingInput = std::format("{}\n", ConsoleCommandPool.PendingValues.front());
+        ConsoleCommandPool.PendingValues.pop_front();
+        if (!WritePendingInput(ConsoleCommandWorker))
+        {
+            m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool IEMidiConsoleCommandRunner::WritePendingInput(IEMidiConsoleCommandWorker& ConsoleCommandWorker)
+{
+    bool bIsWriting = true;
+#if defined(__linux__) || defined(__APPLE__)
+    while (!ConsoleCommandWorker.PendingInput.empty())
+    {
+        const ssize_t WrittenSize = write(ConsoleCommandWorker.InputFileDescriptor, ConsoleCommandWorker.PendingInput.data(), ConsoleCommandWorker.PendingInput.size());
+        if (WrittenSize > 0)
+        {
+            ConsoleCommandWorker.PendingInput.erase(0, static_cast<size_t>(WrittenSize));
+            if (ConsoleCommandWorker.PendingInput.empty())
+            {
+                m_SentCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        else if (WrittenSize < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        {
+            break;
+        }
+        else
+        {
+            // The worker exited, its line is lost and it is started again on the next value
+            sigset_t PendingSignalSet;
+            sigpending(&PendingSignalSet);
+            if (sigismember(&PendingSignalSet, SIGPIPE))
+            {
+                sigset_t PipeSignalSet;
+                sigemptyset(&PipeSignalSet);
+                sigaddset(&PipeSignalSet, SIGPIPE);
+                int Signal = 0;
+                sigwait(&PipeSignalSet, &Signal);
+            }
+            StopWorker(ConsoleCommandWorker);
+            bIsWriting = false;
+        }
+    }
+#endif
+    return bIsWriting;
+}
+
+bool IEMidiConsoleCommandRunner::SpawnWorker(const std::string& ConsoleCommand, IEMidiConsoleCommandWorker& ConsoleCommandWorker)
+{
+    bool bSpawned = false;
+#if defined(__linux__) || defined(__APPLE__)
+    // Both ends are close on exec so no other child holds the write end open, dup2 onto stdin clears it for the worker.
+    // Only the write end is non blocking, the read end becomes the worker's stdin
+    std::array<int, 2> PipeFileDescriptors = { -1, -1 };
+    if (CreateClosedOnExecPipe(PipeFileDescriptors))
+    {
+        fcntl(PipeFileDescriptors[1], F_SETFL, O_NONBLOCK);
+
+        posix_spawn_file_actions_t FileActions;
+        posix_spawn_file_actions_init(&FileActions);
+        posix_spawn_file_actions_adddup2(&FileActions, PipeFileDescriptors[0], STDIN_FILENO);
+
+        char ShellName[] = "sh";
+        char ShellCommandFlag[] = "-c";
+        std::vector<char> ShellCommand(ConsoleCommand.begin(), ConsoleCommand.end());
+        ShellCommand.push_back('\0');
+        char* const Arguments[] = { ShellName, ShellCommandFlag, ShellCommand.data(), nullptr };
+
+        pid_t ProcessID = -1;
+        bSpawned = posix_spawn(&ProcessID, "/bin/sh", &FileActions, nullptr, Arguments, environ) == 0;
+        posix_spawn_file_actions_destroy(&FileActions);
+        close(PipeFileDescriptors[0]);
+
+        if (bSpawned)
+        {
+            ConsoleCommandWorker.ProcessID = ProcessID;
+            ConsoleCommandWorker.InputFileDescriptor = PipeFileDescriptors[1];
+            ConsoleCommandWorker.PendingInput.clear();
+            m_SpawnedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            close(PipeFileDescriptors[1]);
+            IELOG_ERROR("Failed to start console command worker for %s", ConsoleCommand.c_str());
+        }
+    }
+#endif
+    return bSpawned;
+}
+
+bool IEMidiConsoleCommandRunner::CreateClosedOnExecPipe(std::array<int, 2>& PipeFileDescriptors)
+{
+    bool bCreated = false;
+#if defined(__linux__)
+    // Atomic so an action lane forking a process per event in between cannot inherit either end
+    bCreated = pipe2(PipeFileDescriptors.data(), O_CLOEXEC) == 0;
+#elif defined(__APPLE__)
+    // No pipe2 on macOS, the close on exec flags are set right after creation
+    bCreated = pipe(PipeFileDescriptors.data()) == 0;
+    if (bCreated)
+    {
+        fcntl(PipeFileDescriptors[0], F_SETFD, FD_CLOEXEC);
+        fcntl(PipeFileDescriptors[1], F_SETFD, FD_CLOEXEC);
+    }
+#endif
+    if (!bCreated)
+    {
+        PipeFileDescriptors = { -1, -1 };
+    }
+    return bCreated;
+}
+
+void IEMidiConsoleCommandRunner::StopWorker(IEMidiConsoleCommandWorker& ConsoleCommandWorker)
+{
+#if defined(__linux__) || defined(__APPLE__)
+    if (ConsoleCommandWorker.InputFileDescriptor >= 0)
+    {
+        close(ConsoleCommandWorker.InputFileDescriptor);
+    }
+    if (ConsoleCommandWorker.ProcessID > 0)
+    {
+        m_ExitingProcessIDs.push_back(ConsoleCommandWorker.ProcessID);
+    }
+#endif
+    ConsoleCommandWorker.ProcessID = -1;
+    ConsoleCommandWorker.InputFileDescriptor = -1;
+    ConsoleCommandWorker.PendingInput.clear();
+}
+
+void IEMidiConsoleCommandRunner::ReapExitedWorkers()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    std::erase_if(m_ExitingProcessIDs, [](int ProcessID) { return waitpid(ProcessID, nullptr, WNOHANG) != 0; });
+#endif
+}
+
+void IEMidiConsoleCommandRunner::WaitForExitedWorkers(std::chrono::milliseconds Timeout)
+{
+    const IEClock::time_point Deadline = IEClock::now() + Timeout;
+    ReapExitedWorkers();
+    while (!m_ExitingProcessIDs.empty() && IEClock::now() < Deadline)
+    {
+        std::this_thread::sleep_for(CONSOLE_COMMAND_WORKER_EXIT_POLL_INTERVAL);
+        ReapExitedWorkers();
+    }
+}
+
+void IEMidiConsoleCommandRunner::WakeWriter()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    if (m_WakeFileDescriptors[1] >= 0)
+    {
+        const char WakeByte = 0;
+        [[maybe_unused]] const ssize_t WrittenSize = write(m_WakeFileDescriptors[1], &WakeByte, 1);
+    }
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include "IECore.h"
+
+static constexpr uint32_t MAX_CONSOLE_COMMAND_WORKER_COUNT = 16;
+static constexpr std::chrono::seconds CONSOLE_COMMAND_WORKER_IDLE_TIMEOUT = std::chrono::seconds(60);
+static constexpr std::chrono::milliseconds CONSOLE_COMMAND_RUNNER_POLL_INTERVAL = std::chrono::milliseconds(1000);
+static constexpr std::chrono::milliseconds CONSOLE_COMMAND_WORKER_EXIT_TIMEOUT = std::chrono::milliseconds(500);
+static constexpr std::chrono::milliseconds CONSOLE_COMMAND_WORKER_EXIT_POLL_INTERVAL = std::chrono::milliseconds(10);
+
+struct IEMidiConsoleCommandRunnerStats
+{
+public:
+    uint64_t SpawnedCount = 0;
+    uint64_t SentCount = 0;
+    uint64_t DroppedCount = 0;
+};
+
+/*
+* Keeps persistent console commands running instead of starting a process per value.
+* Each property gets a pool of up to MAX_CONSOLE_COMMAND_WORKER_COUNT `sh -c` workers started with posix_spawn,
+* values are written to their standard input one per line and handed round robin to the workers.
+* A worker is only given its next line once the previous one fit in its pipe, values wait in a queue bounded by the
+* property's depth and the oldest is dropped when it is full, so a slow command sees the latest values of a knob sweep.
+* Workers that exit are started again on the next value, pools left unused for the idle timeout are stopped.
+* A single writer thread polls the pipes, submitting never blocks on a worker. Only available on Linux and macOS.
+*/
+class IEMidiConsoleCommandRunner
+{
+public:
+    IEMidiConsoleCommandRunner();
+    ~IEMidiConsoleCommandRunner();
+    IEMidiConsoleCommandRunner(const IEMidiConsoleCommandRunner&) = delete;
+    IEMidiConsoleCommandRunner& operator=(const IEMidiConsoleCommandRunner&) = delete;
+
+public:
+    static bool IsSupported();
+    /* A changed command or worker count restarts the property's pool */
+    void SubmitValue(uint32_t PropertyRuntimeID, const std::string& ConsoleCommand, uint32_t WorkerCount, uint32_t QueueDepth, float Value);
+    IEMidiConsoleCommandRunnerStats GetStats() const;
+
+private:
+    struct IEMidiConsoleCommandWorker
+    {
+    public:
+        int ProcessID = -1;
+        int InputFileDescriptor = -1;
+        std::string PendingInput;
+    };
+
+    struct IEMidiConsoleCommandPool
+    {
+    public:
+        std::string ConsoleCommand;
+        std::vector<IEMidiConsoleCommandWorker> Workers;
+        std::deque<float> PendingValues;
+        size_t NextWorkerIndex = 0;
+        IEClock::time_point LastSubmitTime = IEClock::time_point();
+    };
+
+private:
+    static bool CreateClosedOnExecPipe(std::array<int, 2>& PipeFileDescriptors);
+
+private:
+    void RunWriter();
+    void WritePendingValues(IEMidiConsoleCommandPool& ConsoleCommandPool);
+    bool WritePendingInput(IEMidiConsoleCommandWorker& ConsoleCommandWorker);
+    bool SpawnWorker(const std::string& ConsoleCommand, IEMidiConsoleCommandWorker& ConsoleCommandWorker);
+    void StopWorker(IEMidiConsoleCommandWorker& ConsoleCommandWorker);
+    void ReapExitedWorkers();
+    void WaitForExitedWorkers(std::chrono::milliseconds Timeout);
+    void WakeWriter();
+
+private:
+    std::unordered_map<uint32_t, IEMidiConsoleCommandPool> m_ConsoleCommandPools;
+    std::vector<int> m_ExitingProcessIDs;
+    std::mutex m_Mutex;
+    bool m_bIsStopping = false;
+
+private:
+    std::thread m_Writer;
+    std::array<int, 2> m_WakeFileDescriptors = { -1, -1 };
+    std::atomic<uint64_t> m_SpawnedCount = 0;
+    std::atomic<uint64_t> m_SentCount = 0;
+    std::atomic<uint64_t> m_DroppedCount = 0;
+};
\ No newline at end of file
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiControlChangeDecoder.h"
+
+static constexpr unsigned char CONTROL_CHANGE_STATUS = 0xB0;
+static constexpr unsigned char DATA_ENTRY_MSB_CONTROLLER = 6;
+static constexpr unsigned char DATA_ENTRY_LSB_CONTROLLER = 38;
+static constexpr unsigned char NRPN_LSB_CONTROLLER = 98;
+static constexpr unsigned char NRPN_MSB_CONTROLLER = 99;
+static constexpr unsigned char RPN_LSB_CONTROLLER = 100;
+static constexpr unsigned char RPN_MSB_CONTROLLER = 101;
+static constexpr unsigned char RPN_NULL_VALUE = 127;
+
+bool IEMidiControlChangeDecoder::Decode(const IEMidiMessage& MidiMessage, IEMidiDecodedControl& OutDecodedControl)
+{
+    if (MidiMessage.size() < 3 || (MidiMessage[0] & 0xF0) != CONTROL_CHANGE_STATUS)
+    {
+        return false;
+    }
+
+    const unsigned char Status = MidiMessage[0];
+    const unsigned char Controller = MidiMessage[1] & 0x7F;
+    const unsigned char Value = MidiMessage[2] & 0x7F;
+    IEMidiChannelState& ChannelState = m_ChannelStates[Status & 0x0F];
+
+    switch (Controller)
+    {
+        case NRPN_MSB_CONTROLLER:
+        case NRPN_LSB_CONTROLLER:
+        {
+            SelectParameter(ChannelState, IEMidiMessageType::NRPN, Controller, Value);
+            return false;
+        }
+        case RPN_MSB_CONTROLLER:
+        case RPN_LSB_CONTROLLER:
+        {
+            SelectParameter(ChannelState, IEMidiMessageType::RPN, Controller, Value);
+            return false;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    // Data entry belongs to the selected parameter, without one controllers 6 and 38 are a plain 14-bit pair
+    if (ChannelState.ParameterType != IEMidiMessageType::None && (Controller == DATA_ENTRY_MSB_CONTROLLER || Controller == DATA_ENTRY_LSB_CONTROLLER))
+    {
+        if (Controller == DATA_ENTRY_MSB_CONTROLLER)
+        {
+            ChannelState.DataEntryMSB = Value;
+            ChannelState.bHasDataEntryMSB = true;
+        }
+        else if (!ChannelState.bHasDataEntryMSB)
+        {
+            return false;
+        }
+
+        OutDecodedControl.MidiMessageType = ChannelState.ParameterType;
+        OutDecodedControl.Status = Status;
+        OutDecodedControl.Number = static_cast<uint16_t>((ChannelState.ParameterMSB << 7) | ChannelState.ParameterLSB);
+        OutDecodedControl.Value = static_cast<uint16_t>((ChannelState.DataEntryMSB << 7) | (Controller == DATA_ENTRY_LSB_CONTROLLER ? Value : 0));
+        return true;
+    }
+
+    if (Controller < 32)
+    {
+        ChannelState.ControllerMSBs[Controller] = Value;
+        ChannelState.ControllerMSBMask |= 1u << Controller;
+
+        OutDecodedControl.MidiMessageType = IEMidiMessageType::HighResControlChange;
+        OutDecodedControl.Status = Status;
+        OutDecodedControl.Number = Controller;
+        OutDecodedControl.Value = static_cast<uint16_t>(Value << 7);
+        return true;
+    }
+
+    if (Controller < 64 && (ChannelState.ControllerMSBMask & (1u << (Controller - 32))))
+    {
+        OutDecodedControl.MidiMessageType = IEMidiMessageType::HighResControlChange;
+        OutDecodedControl.Status = Status;
+        OutDecodedControl.Number = static_cast<uint16_t>(Controller - 32);
+        OutDecodedControl.Value = static_cast<uint16_t>((ChannelState.ControllerMSBs[Controller - 32] << 7) | Value);
+        return true;
+    }
+
+    return false;
+}
+
+void IEMidiControlChangeDecoder::Reset()
+{
+    m_ChannelStates = {};
+}
+
+void IEMidiControlChangeDecoder::SelectParameter(IEMidiChannelState& ChannelState, IEMidiMessageType ParameterType, unsigned char Controller, unsigned char Value)
+{
+    // Switching between NRPN and RPN forgets the other half of the previous parameter number
+    if (ChannelState.ParameterType != ParameterType)
+    {
+        ChannelState.ParameterMSB = 0;
+        ChannelState.ParameterLSB = 0;
+    }
+
+    const bool bIsMSB = Controller == NRPN_MSB_CONTROLLER || Controller == RPN_MSB_CONTROLLER;
+    (bIsMSB ? ChannelState.ParameterMSB : ChannelState.ParameterLSB) = Value;
+    ChannelState.ParameterType = ParameterType;
+    ChannelState.bHasDataEntryMSB = false;
+
+    // RPN 127/127 is the null parameter, it deselects so that stray data entry is ignored
+    if (ParameterType == IEMidiMessageType::RPN && ChannelState.ParameterMSB == RPN_NULL_VALUE && ChannelState.ParameterLSB == RPN_NULL_VALUE)
+    {
+        ChannelState.ParameterType = IEMidiMessageType::None;
+    }
+}
\ No newline at end of file
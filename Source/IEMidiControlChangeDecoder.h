@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include "IECore.h"
+
+#include "IEMidiTypes.h"
+
+static constexpr uint16_t MIDI_14_BIT_MAX_VALUE = 0x3FFF;
+
+/* A 14-bit value completed by a control change, Number is the MSB controller for HighResControlChange and the parameter for NRPN and RPN */
+struct IEMidiDecodedControl
+{
+public:
+    IEMidiMessageType MidiMessageType = IEMidiMessageType::None;
+    unsigned char Status = 0;
+    uint16_t Number = 0;
+    uint16_t Value = 0;
+};
+
+/*
+* Per channel state machine assembling 14-bit values out of 7-bit control changes.
+* Controllers 0-31 carry the MSB of a value whose LSB follows on controllers 32-63, an MSB alone is a value with a zero LSB.
+* Controllers 99/98 select an NRPN and 101/100 an RPN, data entry 6/38 then sets the MSB and LSB of the selected parameter.
+* The state is a fixed array of channels so decoding never allocates, it is only touched by the RtMidi callback of one session.
+*/
+class IEMidiControlChangeDecoder
+{
+public:
+    bool Decode(const IEMidiMessage& MidiMessage, IEMidiDecodedControl& OutDecodedControl);
+    void Reset();
+
+private:
+    struct IEMidiChannelState
+    {
+    public:
+        std::array<uint8_t, 32> ControllerMSBs = {};
+        uint32_t ControllerMSBMask = 0;
+        IEMidiMessageType ParameterType = IEMidiMessageType::None;
+        uint8_t ParameterMSB = 0;
+        uint8_t ParameterLSB = 0;
+        uint8_t DataEntryMSB = 0;
+        bool bHasDataEntryMSB = false;
+    };
+
+private:
+    void SelectParameter(IEMidiChannelState& ChannelState, IEMidiMessageType ParameterType, unsigned char Controller, unsigned char Value);
+
+private:
+    std::array<IEMidiChannelState, 16> m_ChannelStates = {};
+};
\ No newline at end of file
@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiDeviceRegistry.h"
+
+#if defined(__linux__)
+#include <alsa/asoundlib.h>
+#include <poll.h>
+#endif
+
+static constexpr int ANNOUNCE_LISTENER_POLL_TIMEOUT_MS = 250;
+static constexpr char ANNOUNCE_LISTENER_CLIENT_NAME[] = "IEMidi Device Registry";
+
+IEMidiDeviceRegistry::IEMidiDeviceRegistry(RtMidiIn& MidiIn, RtMidiOut& MidiOut) :
+    m_MidiIn(MidiIn),
+    m_MidiOut(MidiOut)
+{
+#if defined(__linux__)
+    if (m_MidiIn.getCurrentApi() == RtMidi::LINUX_ALSA)
+    {
+        m_AnnounceListener = std::thread(&IEMidiDeviceRegistry::RunAnnounceListener, this);
+    }
+#endif
+}
+
+IEMidiDeviceRegistry::~IEMidiDeviceRegistry()
+{
+    m_bIsAnnounceListenerStopping.store(true);
+    if (m_AnnounceListener.joinable())
+    {
+        m_AnnounceListener.join();
+    }
+}
+
+std::vector<IEMidiDeviceEntry> IEMidiDeviceRegistry::GetMidiDevices()
+{
+    RefreshIfStale();
+
+    std::scoped_lock MidiDevicesLock(m_MidiDevicesMutex);
+    return m_MidiDevices;
+}
+
+bool IEMidiDeviceRegistry::FindMidiDevice(const std::string& MidiDeviceName, IEMidiDeviceEntry& OutMidiDeviceEntry)
+{
+    // Port numbers are only trustworthy when announce events keep the list current, otherwise enumerate before binding to them
+    if (!HasAnnounceListener())
+    {
+        Invalidate();
+    }
+    RefreshIfStale();
+
+    std::scoped_lock MidiDevicesLock(m_MidiDevicesMutex);
+    for (const IEMidiDeviceEntry& MidiDeviceEntry : m_MidiDevices)
+    {
+        if (MidiDeviceEntry.Name == MidiDeviceName)
+        {
+            OutMidiDeviceEntry = MidiDeviceEntry;
+            return true;
+        }
+    }
+    return false;
+}
+
+IEClock::time_point IEMidiDeviceRegistry::GetLastChangeTime() const
+{
+    std::scoped_lock ChangeLock(m_ChangeMutex);
+    return m_LastChangeTime;
+}
+
+bool IEMidiDeviceRegistry::WaitForMidiDevicesChanged(uint64_t KnownChangeCount, std::chrono::milliseconds Timeout)
+{
+    std::unique_lock ChangeLock(m_ChangeMutex);
+    return m_ChangeConditionVariable.wait_for(ChangeLock, Timeout, [this, KnownChangeCount]() { return GetChangeCount() != KnownChangeCount; });
+}
+
+void IEMidiDeviceRegistry::WakeMidiDevicesChangedWaiters()
+{
+    m_ChangeConditionVariable.notify_all();
+}
+
+void IEMidiDeviceRegistry::SetOnMidiDevicesChangedCallbackFunc(IEMidiDevicesChangedCallback MidiDevicesChangedCallback, void* UserData)
+{
+    std::scoped_lock MidiDevicesChangedCallbackLock(m_MidiDevicesChangedCallbackMutex);
+    m_MidiDevicesChangedCallback = MidiDevicesChangedCallback;
+    m_MidiDevicesChangedUserData = UserData;
+}
+
+void IEMidiDeviceRegistry::RefreshIfStale()
+{
+    std::scoped_lock MidiDevicesLock(m_MidiDevicesMutex);
+    const bool bIsPollDue = !HasAnnounceListener() && IEClock::now() - m_LastEnumerationTime >= MIDI_DEVICE_REGISTRY_POLL_INTERVAL;
+    if (m_bIsStale.exchange(false, std::memory_order_acq_rel) || bIsPollDue)
+    {
+        Enumerate();
+    }
+}
+
+void IEMidiDeviceRegistry::Enumerate()
+{
+    std::vector<std::string> OutputPortNames;
+    OutputPortNames.reserve(m_MidiOut.getPortCount());
+    for (unsigned int OutputPortNumber = 0; OutputPortNumber < m_MidiOut.getPortCount(); OutputPortNumber++)
+    {
+        OutputPortNames.push_back(m_MidiOut.getPortName(OutputPortNumber));
+    }
+
+    std::vector<IEMidiDeviceEntry> MidiDevices;
+    const unsigned int InputPortCount = m_MidiIn.getPortCount();
+    MidiDevices.reserve(InputPortCount);
+    for (unsigned int InputPortNumber = 0; InputPortNumber < InputPortCount; InputPortNumber++)
+    {
+        const std::string InputPortName = m_MidiIn.getPortName(InputPortNumber);
+
+        IEMidiDeviceEntry& MidiDeviceEntry = MidiDevices.emplace_back();
+        MidiDeviceEntry.Name = GetSanitizedMidiDeviceName(InputPortName, InputPortNumber);
+        MidiDeviceEntry.InputPortNumber = static_cast<int>(InputPortNumber);
+
+        const std::pair<std::unordered_map<std::string, uint32_t>::iterator, bool> IDIt = m_MidiDeviceIDs.try_emplace(MidiDeviceEntry.Name, m_NextMidiDeviceID);
+        m_NextMidiDeviceID += IDIt.second ? 1 : 0;
+        MidiDeviceEntry.MidiDeviceID = IDIt.first->second;
+
+        // Ports of virtual devices live in separate ALSA clients, their names only match once the client:port address is stripped
+        const std::string UnaddressedInputPortName = GetUnaddressedMidiPortName(InputPortName);
+        for (size_t OutputPortNumber = 0; OutputPortNumber < OutputPortNames.size(); OutputPortNumber++)
+        {
+            const std::string MidiDeviceNameOut = GetSanitizedMidiDeviceName(OutputPortNames[OutputPortNumber], InputPortNumber);
+            if (MidiDeviceNameOut.find(MidiDeviceEntry.Name) != std::string::npos)
+            {
+                MidiDeviceEntry.OutputPortNumber = static_cast<int>(OutputPortNumber);
+                break;
+            }
+            if (MidiDeviceEntry.OutputPortNumber < 0 && GetUnaddressedMidiPortName(OutputPortNames[OutputPortNumber]) == UnaddressedInputPortName)
+            {
+                MidiDeviceEntry.OutputPortNumber = static_cast<int>(OutputPortNumber);
+            }
+        }
+    }
+
+    // Without announcements a changed enumeration is the only sign that devices came or went
+    const bool bHaveMidiDevicesChanged = !std::equal(MidiDevices.begin(), MidiDevices.end(), m_MidiDevices.begin(), m_MidiDevices.end(),
+        [](const IEMidiDeviceEntry& MidiDeviceEntry, const IEMidiDeviceEntry& OtherMidiDeviceEntry) { return MidiDeviceEntry.MidiDeviceID == OtherMidiDeviceEntry.MidiDeviceID; });
+
+    m_MidiDevices = std::move(MidiDevices);
+    m_LastEnumerationTime = IEClock::now();
+    m_Generation.fetch_add(1, std::memory_order_acq_rel);
+
+    if (bHaveMidiDevicesChanged && !HasAnnounceListener())
+    {
+        NotifyMidiDevicesChanged(m_LastEnumerationTime);
+    }
+}
+
+void IEMidiDeviceRegistry::RunAnnounceListener()
+{
+#if defined(__linux__)
+    snd_seq_t* Sequencer = nullptr;
+    if (snd_seq_open(&Sequencer, "default", SND_SEQ_OPEN_INPUT, SND_SEQ_NONBLOCK) < 0)
+    {
+        IELOG_ERROR("Failed to open the ALSA sequencer, midi devices are polled every %lld ms",
+            static_cast<long long>(MIDI_DEVICE_REGISTRY_POLL_INTERVAL.count()));
+        return;
+    }
+
+    snd_seq_set_client_name(Sequencer, ANNOUNCE_LISTENER_CLIENT_NAME);
+    const int AnnouncePort = snd_seq_create_simple_port(Sequencer, ANNOUNCE_LISTENER_CLIENT_NAME, SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_NO_EXPORT,
+                                                        SND_SEQ_PORT_TYPE_APPLICATION);
+    if (AnnouncePort < 0 || snd_seq_connect_from(Sequencer, AnnouncePort, SND_SEQ_CLIENT_SYSTEM, SND_SEQ_PORT_SYSTEM_ANNOUNCE) < 0)
+    {
+        IELOG_ERROR("Failed to subscribe to ALSA sequencer announcements, midi devices are polled every %lld ms",
+            static_cast<long long>(MIDI_DEVICE_REGISTRY_POLL_INTERVAL.count()));
+        snd_seq_close(Sequencer);
+        return;
+    }
+
+    std::vector<pollfd> PollFileDescriptors(snd_seq_poll_descriptors_count(Sequencer, POLLIN));
+    snd_seq_poll_descriptors(Sequencer, PollFileDescriptors.data(), static_cast<unsigned int>(PollFileDescriptors.size()), POLLIN);
+    m_bHasAnnounceListener.store(true, std::memory_order_release);
+
+    // Ports created between the first enumeration and the subscription would otherwise be missed
+    Invalidate();
+
+    const int ListenerClientID = snd_seq_client_id(Sequencer);
+    while (!m_bIsAnnounceListenerStopping.load())
+    {
+        if (poll(PollFileDescriptors.data(), PollFileDescriptors.size(), ANNOUNCE_LISTENER_POLL_TIMEOUT_MS) <= 0)
+        {
+            continue;
+        }
+
+        bool bHaveMidiDevicesChanged = false;
+        snd_seq_event_t* Event = nullptr;
+        while (snd_seq_event_input(Sequencer, &Event) >= 0 && Event)
+        {
+            switch (Event->type)
+            {
+                case SND_SEQ_EVENT_PORT_START:
+                case SND_SEQ_EVENT_PORT_EXIT:
+                case SND_SEQ_EVENT_PORT_CHANGE:
+                {
+                    bHaveMidiDevicesChanged |= Event->data.addr.client != ListenerClientID;
+                    break;
+                }
+                default:
+                {
+                    break;
+                }
+            }
+        }
+
+        // A device announces several ports at once, the whole burst costs a single enumeration on the next read
+        if (bHaveMidiDevicesChanged)
+        {
+            Invalidate();
+            NotifyMidiDevicesChanged(IEClock::now());
+        }
+    }
+
+    m_bHasAnnounceListener.store(false, std::memory_order_release);
+    snd_seq_close(Sequencer);
+#endif
+}
+
+void IEMidiDeviceRegistry::NotifyMidiDevicesChanged(IEClock::time_point ChangeTime)
+{
+    {
+        std::scoped_lock ChangeLock(m_ChangeMutex);
+        m_LastChangeTime = ChangeTime;
+        m_ChangeCount.fetch_add(1, std::memory_order_acq_rel);
+    }
+    m_ChangeConditionVariable.notify_all();
+
+    std::scoped_lock MidiDevicesChangedCallbackLock(m_MidiDevicesChangedCallbackMutex);
+    if (m_MidiDevicesChangedCallback)
+    {
+        m_MidiDevicesChangedCallback(m_MidiDevicesChangedUserData);
+    }
+}
+
+std::string IEMidiDeviceRegistry::GetSanitizedMidiDeviceName(const std::string& MidiDeviceName, uint32_t InputPortNumber)
+{
+    std::string SanitizedMidiDeviceName = MidiDeviceName;
+
+    const std::string NumericSuffix = std::to_string(InputPortNumber);
+    const size_t NumericSuffixIndex = MidiDeviceName.find(NumericSuffix);
+    if (NumericSuffixIndex != std::string::npos)
+    {
+        SanitizedMidiDeviceName.erase(NumericSuffixIndex - 1, NumericSuffix.length() + 1);
+    }
+    return SanitizedMidiDeviceName;
+}
+
+std::string IEMidiDeviceRegistry::GetUnaddressedMidiPortName(const std::string& MidiPortName)
+{
+    // ALSA port names end with " <client>:<port>"
+    const size_t AddressIndex = MidiPortName.find_last_of(' ');
+    if (AddressIndex != std::string::npos)
+    {
+        const std::string_view Address = std::string_view(MidiPortName).substr(AddressIndex + 1);
+        const size_t SeparatorIndex = Address.find(':');
+        const bool bIsAddress = SeparatorIndex != std::string_view::npos && SeparatorIndex > 0 && SeparatorIndex + 1 < Address.size() &&
+            std::all_of(Address.begin(), Address.end(), [](char Character) { return std::isdigit(static_cast<unsigned char>(Character)) || Character == ':'; });
+        if (bIsAddress)
+        {
+            return MidiPortName.substr(0, AddressIndex);
+        }
+    }
+    return MidiPortName;
+}
\ No newline at end of file
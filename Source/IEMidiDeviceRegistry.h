@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include "RtMidi.h"
+
+#include "IECore.h"
+
+static constexpr std::chrono::milliseconds MIDI_DEVICE_REGISTRY_POLL_INTERVAL = std::chrono::milliseconds(1000);
+
+/* A connected device as enumerated, the ID stays the same for a device name for the lifetime of the registry */
+struct IEMidiDeviceEntry
+{
+public:
+    uint32_t MidiDeviceID = 0;
+    std::string Name;
+    int InputPortNumber = -1;
+    int OutputPortNumber = -1;
+};
+
+/* Called from the announce listener thread whenever ports come and go, the registry itself is refreshed lazily by its readers */
+using IEMidiDevicesChangedCallback = void(*)(void* UserData);
+
+/*
+* Cached list of connected devices. Enumerating through RtMidi queries every port name, on ALSA each query is a round trip
+* to the sequencer, so the list is only rebuilt when it is known to be stale: on Linux a listener subscribed to the ALSA
+* sequencer announce port flags port start, exit and change events, elsewhere the list is rebuilt at most once per poll interval.
+*/
+class IEMidiDeviceRegistry
+{
+public:
+    IEMidiDeviceRegistry(RtMidiIn& MidiIn, RtMidiOut& MidiOut);
+    ~IEMidiDeviceRegistry();
+    IEMidiDeviceRegistry(const IEMidiDeviceRegistry&) = delete;
+    IEMidiDeviceRegistry& operator=(const IEMidiDeviceRegistry&) = delete;
+
+public:
+    std::vector<IEMidiDeviceEntry> GetMidiDevices();
+    bool FindMidiDevice(const std::string& MidiDeviceName, IEMidiDeviceEntry& OutMidiDeviceEntry);
+    uint64_t GetGeneration() const { return m_Generation.load(std::memory_order_acquire); }
+    bool HasAnnounceListener() const { return m_bHasAnnounceListener.load(std::memory_order_acquire); }
+
+    /* Forces the next read to enumerate again */
+    void Invalidate() { m_bIsStale.store(true, std::memory_order_release); }
+
+    /* Counts announced port changes, or changed enumerations when there is no listener */
+    uint64_t GetChangeCount() const { return m_ChangeCount.load(std::memory_order_acquire); }
+    IEClock::time_point GetLastChangeTime() const;
+    bool WaitForMidiDevicesChanged(uint64_t KnownChangeCount, std::chrono::milliseconds Timeout);
+    void WakeMidiDevicesChangedWaiters();
+    void SetOnMidiDevicesChangedCallbackFunc(IEMidiDevicesChangedCallback MidiDevicesChangedCallback, void* UserData);
+
+private:
+    void RefreshIfStale();
+    void Enumerate();
+    void RunAnnounceListener();
+    void NotifyMidiDevicesChanged(IEClock::time_point ChangeTime);
+
+private:
+    static std::string GetSanitizedMidiDeviceName(const std::string& MidiDeviceName, uint32_t InputPortNumber);
+    static std::string GetUnaddressedMidiPortName(const std::string& MidiPortName);
+
+private:
+    RtMidiIn& m_MidiIn;
+    RtMidiOut& m_MidiOut;
+
+private:
+    std::vector<IEMidiDeviceEntry> m_MidiDevices;
+    std::unordered_map<std::string, uint32_t> m_MidiDeviceIDs;
+    uint32_t m_NextMidiDeviceID = 1;
+    IEClock::time_point m_LastEnumerationTime = IEClock::time_point();
+    mutable std::mutex m_MidiDevicesMutex;
+    std::atomic<uint64_t> m_Generation = 0;
+    std::atomic<bool> m_bIsStale = true;
+
+private:
+    std::atomic<uint64_t> m_ChangeCount = 0;
+    IEClock::time_point m_LastChangeTime = IEClock::time_point();
+    mutable std::mutex m_ChangeMutex;
+    std::condition_variable m_ChangeConditionVariable;
+
+private:
+    std::thread m_AnnounceListener;
+    std::atomic<bool> m_bHasAnnounceListener = false;
+    std::atomic<bool> m_bIsAnnounceListenerStopping = false;
+    IEMidiDevicesChangedCallback m_MidiDevicesChangedCallback = nullptr;
+    void* m_MidiDevicesChangedUserData = nullptr;
+    std::mutex m_MidiDevicesChangedCallbackMutex;
+};
\ No newline at end of file
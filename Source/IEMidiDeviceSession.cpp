@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiDeviceSession.h"
+
+uint32_t IEMidiDeviceSession::MidiDeviceSessionIDGenerator = 1;
+
+IEMidiDeviceSession::IEMidiDeviceSession(IEMidiProcessor& MidiProcessor, const IEMidiDeviceProfile& MidiDeviceProfile, size_t IncomingMidiEventsCapacity) :
+    m_SessionID(MidiDeviceSessionIDGenerator++),
+    m_MidiProcessor(MidiProcessor),
+    m_MidiIn(std::make_unique<RtMidiIn>()),
+    m_MidiOut(std::make_unique<RtMidiOut>()),
+    m_MidiDeviceProfile(MidiDeviceProfile),
+    m_IncomingMidiEvents(IncomingMidiEventsCapacity)
+{
+    RefreshMidiDispatchTable();
+}
+
+IEMidiDeviceSession::~IEMidiDeviceSession()
+{
+    ClosePorts();
+}
+
+IEResult IEMidiDeviceSession::OpenPorts(RtMidiIn::RtMidiCallback MidiInCallback)
+{
+    std::scoped_lock PortsLock(m_PortsMutex);
+    return OpenPortsLocked(MidiInCallback);
+}
+
+void IEMidiDeviceSession::ClosePorts()
+{
+    std::scoped_lock PortsLock(m_PortsMutex);
+    ClosePortsLocked();
+}
+
+void IEMidiDeviceSession::Disconnect()
+{
+    std::scoped_lock PortsLock(m_PortsMutex);
+    ClosePortsLocked();
+    m_MidiOutputQueue.Clear();
+    m_DisconnectTime = IEClock::now();
+}
+
+IEResult IEMidiDeviceSession::Reconnect(uint32_t InputPortNumber, uint32_t OutputPortNumber, RtMidiIn::RtMidiCallback MidiInCallback)
+{
+    std::scoped_lock PortsLock(m_PortsMutex);
+    if (m_bIsDeactivated)
+    {
+        return IEResult(IEResult::Type::Fail, std::format("Midi device {} was deactivated", m_MidiDeviceProfile.Name));
+    }
+
+    // Port numbers are indices into the current enumeration, the device may come back at different ones
+    m_MidiDeviceProfile.SetPortNumbers(InputPortNumber, OutputPortNumber);
+    return OpenPortsLocked(MidiInCallback);
+}
+
+void IEMidiDeviceSession::Deactivate()
+{
+    std::scoped_lock PortsLock(m_PortsMutex);
+    m_bIsDeactivated = true;
+    ClosePortsLocked();
+    m_MidiOutputQueue.Clear();
+}
+
+IEClock::time_point IEMidiDeviceSession::GetDisconnectTime() const
+{
+    std::scoped_lock PortsLock(m_PortsMutex);
+    return m_DisconnectTime;
+}
+
+IEMidiOutputPushResult IEMidiDeviceSession::PushMidiOutputMessage(const IEMidiMessage& MidiMessage, bool bCoalesce)
+{
+    // Profiles store every message with three bytes, a shorter message must not leave a stray data byte on the wire
+    const size_t MidiMessageSize = IEMidiParser::GetMidiMessageSize(MidiMessage[0]);
+    if (!IsConnected() || MidiMessageSize == 0 || MidiMessage.size() < MidiMessageSize)
+    {
+        return IEMidiOutputPushResult::Dropped;
+    }
+
+    IEMidiMessage CompleteMidiMessage = MidiMessage;
+    CompleteMidiMessage.Size = static_cast<uint8_t>(MidiMessageSize);
+    return m_MidiOutputQueue.Push(CompleteMidiMessage, bCoalesce);
+}
+
+IEMidiOutputPushResult IEMidiDeviceSession::PushMidiSysExMessage(std::span<const unsigned char> SysExMessage)
+{
+    return IsConnected() ? m_MidiOutputQueue.Push(SysExMessage) : IEMidiOutputPushResult::Dropped;
+}
+
+bool IEMidiDeviceSession::SendNextMidiOutputMessage(IEClock::time_point Now, IEClock::time_point& OutNextSendTime)
+{
+    OutNextSendTime = IEClock::time_point::max();
+
+    std::scoped_lock PortsLock(m_PortsMutex);
+    if (!IsConnected())
+    {
+        // Whatever was pending describes state from before the disconnect, a reconnect sends the current state
+        m_MidiOutputQueue.Clear();
+        return false;
+    }
+
+    if (Now < m_NextMidiOutputTime)
+    {
+        OutNextSendTime = m_MidiOutputQueue.IsEmpty() ? IEClock::time_point::max() : m_NextMidiOutputTime;
+        return false;
+    }
+
+    if (!m_MidiOutputQueue.Pop(m_MidiOutputBuffer))
+    {
+        return false;
+    }
+
+    GetMidiOut().sendMessage(m_MidiOutputBuffer.data(), m_MidiOutputBuffer.size());
+
+    const std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable = GetMidiDispatchTable();
+    const uint32_t OutputRateHz = MidiDispatchTable ? MidiDispatchTable->GetOutputRateHz() : DEFAULT_OUTPUT_RATE_HZ;
+    m_NextMidiOutputTime = Now + std::chrono::duration_cast<IEClock::duration>(std::chrono::nanoseconds(std::nano::den / OutputRateHz));
+    OutNextSendTime = m_MidiOutputQueue.IsEmpty() ? IEClock::time_point::max() : m_NextMidiOutputTime;
+    return true;
+}
+
+IEResult IEMidiDeviceSession::OpenPortsLocked(RtMidiIn::RtMidiCallback MidiInCallback)
+{
+    IEResult Result(IEResult::Type::Fail);
+    Result.Message = std::format("Failed to open ports of midi device {}", m_MidiDeviceProfile.Name);
+
+    RtMidiIn& MidiIn = GetMidiIn();
+    RtMidiOut& MidiOut = GetMidiOut();
+    if (MidiIn.getPortCount() > m_MidiDeviceProfile.GetInputPortNumber() && MidiOut.getPortCount() > m_MidiDeviceProfile.GetOutputPortNumber())
+    {
+        ClosePortsLocked();
+        m_MidiParser.Reset();
+        m_ControlChangeDecoder.Reset();
+
+        // SysEx is parsed and logged, timing and active sensing would only flood the callback
+        MidiIn.ignoreTypes(false, true, true);
+        MidiIn.setCallback(MidiInCallback, this);
+        MidiIn.openPort(m_MidiDeviceProfile.GetInputPortNumber());
+        MidiOut.openPort(m_MidiDeviceProfile.GetOutputPortNumber());
+
+        m_bIsConnected.store(true, std::memory_order_release);
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Successfully opened ports of midi device {}", m_MidiDeviceProfile.Name);
+    }
+    return Result;
+}
+
+void IEMidiDeviceSession::ClosePortsLocked()
+{
+    RtMidiIn& MidiIn = GetMidiIn();
+    if (MidiIn.isPortOpen())
+    {
+        MidiIn.closePort();
+        MidiIn.cancelCallback();
+    }
+
+    RtMidiOut& MidiOut = GetMidiOut();
+    if (MidiOut.isPortOpen())
+    {
+        MidiOut.closePort();
+    }
+
+    m_bIsConnected.store(false, std::memory_order_release);
+}
+
+std::shared_ptr<const IEMidiDispatchTable> IEMidiDeviceSession::GetMidiDispatchTable() const
+{
+    return m_MidiDispatchTable.load(std::memory_order_acquire);
+}
+
+void IEMidiDeviceSession::RefreshMidiDispatchTable()
+{
+    const std::shared_ptr<const IEMidiDispatchTable> PreviousMidiDispatchTable = GetMidiDispatchTable();
+    std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable = std::make_shared<const IEMidiDispatchTable>(m_MidiDeviceProfile, PreviousMidiDispatchTable.get());
+    m_MidiDispatchTable.store(std::move(MidiDispatchTable), std::memory_order_release);
+}
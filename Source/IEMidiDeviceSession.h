@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include "RtMidi.h"
+
+#include "IECore.h"
+
+#include "IEMidiControlChangeDecoder.h"
+#include "IEMidiDispatchTable.h"
+#include "IEMidiOutputQueue.h"
+#include "IEMidiParser.h"
+#include "IEMidiSPSCQueue.h"
+#include "IEMidiTypes.h"
+
+class IEMidiProcessor;
+
+/*
+* One active device: its own input and output ports, its profile and the dispatch table compiled from it.
+* Each session's RtMidi callback is the single producer of its incoming event ring.
+*/
+class IEMidiDeviceSession
+{
+public:
+    IEMidiDeviceSession() = delete;
+    IEMidiDeviceSession(IEMidiProcessor& MidiProcessor, const IEMidiDeviceProfile& MidiDeviceProfile, size_t IncomingMidiEventsCapacity);
+    ~IEMidiDeviceSession();
+
+public:
+    uint32_t GetSessionID() const { return m_SessionID; }
+    IEMidiProcessor& GetMidiProcessor() const { return m_MidiProcessor; }
+    RtMidiIn& GetMidiIn() const { return *m_MidiIn; }
+    RtMidiOut& GetMidiOut() const { return *m_MidiOut; }
+    IEMidiDeviceProfile& GetMidiDeviceProfile() { return m_MidiDeviceProfile; }
+    const IEMidiDeviceProfile& GetMidiDeviceProfile() const { return m_MidiDeviceProfile; }
+
+public:
+    IEResult OpenPorts(RtMidiIn::RtMidiCallback MidiInCallback);
+    void ClosePorts();
+
+    /* The device went away, ports are closed but the profile and dispatch table, with their toggle states, are kept for a reconnect */
+    void Disconnect();
+    IEResult Reconnect(uint32_t InputPortNumber, uint32_t OutputPortNumber, RtMidiIn::RtMidiCallback MidiInCallback);
+    /* Closes the ports for good, a deactivated session is never reconnected */
+    void Deactivate();
+    bool IsConnected() const { return m_bIsConnected.load(std::memory_order_acquire); }
+    IEClock::time_point GetDisconnectTime() const;
+
+    /* Queued for the output scheduler, safe from any thread, nothing is queued while the device is disconnected */
+    IEMidiOutputPushResult PushMidiOutputMessage(const IEMidiMessage& MidiMessage, bool bCoalesce);
+    IEMidiOutputPushResult PushMidiSysExMessage(std::span<const unsigned char> SysExMessage);
+    /* Called by the output scheduler only, sends the next queued message once the device's output interval elapsed */
+    bool SendNextMidiOutputMessage(IEClock::time_point Now, IEClock::time_point& OutNextSendTime);
+
+    std::shared_ptr<const IEMidiDispatchTable> GetMidiDispatchTable() const;
+    void RefreshMidiDispatchTable();
+
+    bool PushIncomingMidiEvent(const IEMidiEvent& MidiEvent) { return m_IncomingMidiEvents.TryPush(MidiEvent); }
+    bool PopIncomingMidiEvent(IEMidiEvent& OutMidiEvent) { return m_IncomingMidiEvents.TryPop(OutMidiEvent); }
+    uint64_t GetDroppedIncomingMidiEventCount() const { return m_IncomingMidiEvents.GetDroppedCount(); }
+
+    /* The next incoming message is flagged as recorded instead of being processed */
+    void SetMidiRecording(bool bRecording) { m_bIsRecordingMidi.store(bRecording, std::memory_order_release); }
+    bool ConsumeMidiRecording() { return m_bIsRecordingMidi.exchange(false, std::memory_order_acq_rel); }
+
+    /* Only used from the RtMidi callback, reset whenever the ports are opened */
+    IEMidiParser& GetMidiParser() { return m_MidiParser; }
+    IEMidiControlChangeDecoder& GetControlChangeDecoder() { return m_ControlChangeDecoder; }
+
+private:
+    IEResult OpenPortsLocked(RtMidiIn::RtMidiCallback MidiInCallback);
+    void ClosePortsLocked();
+
+private:
+    static uint32_t MidiDeviceSessionIDGenerator;
+
+private:
+    const uint32_t m_SessionID;
+    IEMidiProcessor& m_MidiProcessor;
+    std::unique_ptr<RtMidiIn> m_MidiIn;
+    std::unique_ptr<RtMidiOut> m_MidiOut;
+    std::atomic<bool> m_bIsConnected = false;
+    bool m_bIsDeactivated = false;
+    IEClock::time_point m_DisconnectTime = IEClock::time_point();
+    mutable std::mutex m_PortsMutex;
+
+private:
+    IEMidiDeviceProfile m_MidiDeviceProfile;
+    IEMidiSPSCQueue<IEMidiEvent> m_IncomingMidiEvents;
+    std::atomic<bool> m_bIsRecordingMidi = false;
+    IEMidiParser m_MidiParser;
+    IEMidiControlChangeDecoder m_ControlChangeDecoder;
+    IEMidiOutputQueue m_MidiOutputQueue;
+    IEClock::time_point m_NextMidiOutputTime = IEClock::time_point();
+    std::vector<unsigned char> m_MidiOutputBuffer;
+    /* Published whole on every refresh, read without a lock by the input callback and the session threads */
+    std::atomic<std::shared_ptr<const IEMidiDispatchTable>> m_MidiDispatchTable;
+};
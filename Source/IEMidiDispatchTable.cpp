@@ -0,0 +1,405 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include <cmath>
+
+#include "IEMidiDispatchTable.h"
+
+#include "IEMidiControlChangeDecoder.h"
+#include "IEMidiParser.h"
+
+static constexpr float MIDI_RESPONSE_LOGARITHMIC_RANGE_DB = 60.0f;
+static constexpr float MIDI_RESPONSE_EXPONENTIAL_STEEPNESS = 4.0f;
+
+IEMidiDispatchTable::IEMidiDispatchTable(const IEMidiDeviceProfile& MidiDeviceProfile, const IEMidiDispatchTable* PreviousMidiDispatchTable)
+{
+    m_Entries.reserve(MidiDeviceProfile.Properties.size());
+    m_BucketOffsets.assign(MIDI_DISPATCH_KEY_COUNT + 1, 0);
+
+    // (key, entry index) pairs in entry order, a rule lands in every bucket it covers so a lookup is a single bucket however many rules there are
+    std::vector<std::pair<uint32_t, uint32_t>> BucketEntries;
+    std::vector<std::pair<uint32_t, uint32_t>> ParameterEntries;
+    BucketEntries.reserve(MidiDeviceProfile.Properties.size());
+
+    for (const IEMidiDeviceProperty& MidiDeviceProperty : MidiDeviceProfile.Properties)
+    {
+        const IEMidiMessage& MidiMessage = MidiDeviceProperty.MidiMessage;
+        // A 14-bit controller pair is addressed by its MSB controller, only 0-31 have an LSB counterpart
+        const bool bIsHighResControl = MidiDeviceProperty.MidiMessageType == IEMidiMessageType::HighResControlChange;
+        if (MidiMessage.size() >= 2 && IsValidDispatchKey(MidiMessage[0], MidiMessage[1]) && (!bIsHighResControl || MidiMessage[1] < 32) &&
+            MidiDeviceProperty.MidiActionType != IEMidiActionType::None)
+        {
+            const uint32_t EntryIndex = static_cast<uint32_t>(m_Entries.size());
+            IEMidiDispatchEntry& MidiDispatchEntry = m_Entries.emplace_back();
+            MidiDispatchEntry.PropertyRuntimeID = MidiDeviceProperty.RuntimeID;
+            MidiDispatchEntry.MidiMessageType = MidiDeviceProperty.MidiMessageType;
+            MidiDispatchEntry.MidiActionType = MidiDeviceProperty.MidiActionType;
+            MidiDispatchEntry.MidiMessage = MidiMessage;
+            MidiDispatchEntry.ConsoleCommand = MidiDeviceProperty.ConsoleCommand;
+            MidiDispatchEntry.OpenFilePath = MidiDeviceProperty.OpenFilePath;
+            MidiDispatchEntry.bToggle = MidiDeviceProperty.bToggle;
+            MidiDispatchEntry.bCoalesce = (MidiDeviceProperty.bCoalesce || MidiDeviceProfile.bCoalesceControlChanges) &&
+                                          IsContinuousMidiMessageType(MidiDeviceProperty.MidiMessageType) &&
+                                          (MidiDeviceProperty.MidiActionType == IEMidiActionType::Volume ||
+                                           MidiDeviceProperty.MidiActionType == IEMidiActionType::ConsoleCommand);
+            MidiDispatchEntry.ValueMin = MidiDeviceProperty.ValueMin;
+            MidiDispatchEntry.ValueMax = MidiDeviceProperty.ValueMax;
+            MidiDispatchEntry.bPersistentConsoleCommand = MidiDeviceProperty.bPersistentConsoleCommand;
+            MidiDispatchEntry.ConsoleCommandWorkerCount = MidiDeviceProperty.ConsoleCommandWorkerCount;
+            MidiDispatchEntry.ConsoleCommandQueueDepth = MidiDeviceProperty.ConsoleCommandQueueDepth;
+            if (HasResponseCurve(MidiDeviceProperty.MidiMessageType, MidiDeviceProperty.MidiActionType))
+            {
+                CompileResponseTable(MidiDispatchEntry, MidiDeviceProperty);
+            }
+            if (MidiDeviceProperty.MidiActionType == IEMidiActionType::Macro)
+            {
+                MidiDispatchEntry.FirstMacroStepIndex = static_cast<uint32_t>(m_MacroSteps.size());
+                MidiDispatchEntry.MacroStepCount = static_cast<uint32_t>(MidiDeviceProperty.MacroSteps.size());
+                m_MacroSteps.insert(m_MacroSteps.end(), MidiDeviceProperty.MacroSteps.begin(), MidiDeviceProperty.MacroSteps.end());
+            }
+
+            // Channel wildcards span the 16 statuses of the message, ranges only apply to a data1 that addresses a note, controller or program
+            const IEMidiStatusInfo& StatusInfo = IEMidiParser::GetStatusInfo(MidiMessage[0]);
+            const bool bIsParameter = IsParameterMidiMessageType(MidiDeviceProperty.MidiMessageType);
+            const unsigned char FirstStatus = MidiDeviceProperty.bAnyChannel && StatusInfo.bIsChannelMessage ? MidiMessage[0] & 0xF0 : MidiMessage[0];
+            const unsigned char LastStatus = MidiDeviceProperty.bAnyChannel && StatusInfo.bIsChannelMessage ? MidiMessage[0] | 0x0F : MidiMessage[0];
+            const unsigned char MaxData1 = bIsHighResControl ? 31 : 127;
+            const unsigned char LastData1 = StatusInfo.bHasAddressByte && !bIsParameter ?
+                std::max(MidiMessage[1], std::min(MidiDeviceProperty.Data1RangeEnd, MaxData1)) : MidiMessage[1];
+            MidiDispatchEntry.bMatchesSeveralControls = FirstStatus != LastStatus || LastData1 != MidiMessage[1];
+
+            for (uint32_t Status = FirstStatus; Status <= LastStatus; Status++)
+            {
+                if (bIsParameter)
+                {
+                    // Parameter entries are not reachable through a single (status, data1), they only live in the parameter index
+                    const uint16_t ParameterNumber = static_cast<uint16_t>(((MidiMessage[1] & 0x7F) << 7) | (MidiMessage[2] & 0x7F));
+                    ParameterEntries.emplace_back(GetParameterDispatchKey(MidiDeviceProperty.MidiMessageType, static_cast<unsigned char>(Status), ParameterNumber),
+                                                  EntryIndex);
+                    continue;
+                }
+
+                for (uint32_t Data1 = MidiMessage[1]; Data1 <= LastData1; Data1++)
+                {
+                    const uint32_t DispatchKey = GetDispatchKey(static_cast<unsigned char>(Status), static_cast<unsigned char>(Data1));
+                    BucketEntries.emplace_back(DispatchKey, EntryIndex);
+                    m_BucketOffsets[DispatchKey + 1]++;
+                }
+            }
+        }
+    }
+
+    for (size_t KeyIndex = 1; KeyIndex < m_BucketOffsets.size(); KeyIndex++)
+    {
+        m_BucketOffsets[KeyIndex] += m_BucketOffsets[KeyIndex - 1];
+    }
+
+    m_BucketEntryIndices.resize(m_BucketOffsets.back());
+    std::vector<uint32_t> BucketWriteOffsets(m_BucketOffsets.begin(), m_BucketOffsets.end() - 1);
+    for (const std::pair<uint32_t, uint32_t>& BucketEntry : BucketEntries)
+    {
+        m_BucketEntryIndices[BucketWriteOffsets[BucketEntry.first]++] = BucketEntry.second;
+    }
+
+    std::sort(ParameterEntries.begin(), ParameterEntries.end());
+    m_ParameterDispatchKeys.reserve(ParameterEntries.size());
+    m_ParameterEntryIndices.reserve(ParameterEntries.size());
+    for (const std::pair<uint32_t, uint32_t>& ParameterEntry : ParameterEntries)
+    {
+        m_ParameterDispatchKeys.push_back(ParameterEntry.first);
+        m_ParameterEntryIndices.push_back(ParameterEntry.second);
+    }
+
+    std::unordered_map<uint32_t, uint32_t> PreviousEntryIndices;
+    if (PreviousMidiDispatchTable)
+    {
+        PreviousEntryIndices.reserve(PreviousMidiDispatchTable->GetEntryCount());
+        for (uint32_t PreviousEntryIndex = 0; PreviousEntryIndex < PreviousMidiDispatchTable->GetEntryCount(); PreviousEntryIndex++)
+        {
+            PreviousEntryIndices[PreviousMidiDispatchTable->GetEntry(PreviousEntryIndex).PropertyRuntimeID] = PreviousEntryIndex;
+        }
+    }
+
+    m_ToggleStates = std::make_unique<std::atomic<bool>[]>(m_Entries.size());
+    m_FeedbackSlots = std::make_unique<IEMidiFeedbackSlot[]>(m_Entries.size());
+    for (uint32_t EntryIndex = 0; EntryIndex < m_Entries.size(); EntryIndex++)
+    {
+        const std::unordered_map<uint32_t, uint32_t>::const_iterator It = PreviousEntryIndices.find(m_Entries[EntryIndex].PropertyRuntimeID);
+        if (It != PreviousEntryIndices.end())
+        {
+            // A rebuilt entry whose message changed addresses another control, what the old one showed says nothing about it
+            const IEMidiFeedbackSlot& PreviousFeedbackSlot = PreviousMidiDispatchTable->m_FeedbackSlots[It->second];
+            const bool bIsSameControl = PreviousMidiDispatchTable->GetEntry(It->second).MidiMessage == m_Entries[EntryIndex].MidiMessage;
+            m_ToggleStates[EntryIndex].store(PreviousMidiDispatchTable->GetToggleState(It->second), std::memory_order_relaxed);
+            m_FeedbackSlots[EntryIndex].DeviceValue.store(bIsSameControl ? PreviousFeedbackSlot.DeviceValue.load(std::memory_order_relaxed) : -1, std::memory_order_relaxed);
+            m_FeedbackSlots[EntryIndex].LastInputTime.store(PreviousFeedbackSlot.LastInputTime.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    m_CoalescingRateHz = std::max<uint32_t>(MidiDeviceProfile.CoalescingRateHz, 1);
+    m_CoalescingSlots = std::make_unique<IEMidiCoalescingSlot[]>(m_Entries.size());
+    for (uint32_t EntryIndex = 0; EntryIndex < m_Entries.size(); EntryIndex++)
+    {
+        if (m_Entries[EntryIndex].bCoalesce)
+        {
+            m_CoalescedEntryIndices.push_back(EntryIndex);
+        }
+    }
+
+    m_InitialOutputMidiMessages = MidiDeviceProfile.InitialOutputMidiMessages;
+    m_OutputRateHz = std::max<uint32_t>(MidiDeviceProfile.OutputRateHz, 1);
+    m_MidiDeviceName = MidiDeviceProfile.Name;
+}
+
+std::span<const uint32_t> IEMidiDispatchTable::FindEntryIndices(unsigned char Status, unsigned char Data1) const
+{
+    std::span<const uint32_t> EntryIndices;
+    if (!m_BucketOffsets.empty() && IsValidDispatchKey(Status, Data1))
+    {
+        const uint32_t DispatchKey = GetDispatchKey(Status, Data1);
+        const uint32_t BucketBegin = m_BucketOffsets[DispatchKey];
+        const uint32_t BucketEnd = m_BucketOffsets[DispatchKey + 1];
+        EntryIndices = std::span<const uint32_t>(m_BucketEntryIndices.data() + BucketBegin, BucketEnd - BucketBegin);
+    }
+    return EntryIndices;
+}
+
+std::span<const uint32_t> IEMidiDispatchTable::FindParameterEntryIndices(IEMidiMessageType MidiMessageType, unsigned char Status, uint16_t ParameterNumber) const
+{
+    const uint32_t ParameterDispatchKey = GetParameterDispatchKey(MidiMessageType, Status, ParameterNumber);
+    const std::pair<std::vector<uint32_t>::const_iterator, std::vector<uint32_t>::const_iterator> KeyRange =
+        std::equal_range(m_ParameterDispatchKeys.begin(), m_ParameterDispatchKeys.end(), ParameterDispatchKey);
+    const size_t Begin = KeyRange.first - m_ParameterDispatchKeys.begin();
+    return std::span<const uint32_t>(m_ParameterEntryIndices.data() + Begin, KeyRange.second - KeyRange.first);
+}
+
+bool IEMidiDispatchTable::GetToggleState(uint32_t EntryIndex) const
+{
+    return m_ToggleStates[EntryIndex].load(std::memory_order_relaxed);
+}
+
+void IEMidiDispatchTable::SetToggleState(uint32_t EntryIndex, bool bActive) const
+{
+    m_ToggleStates[EntryIndex].store(bActive, std::memory_order_relaxed);
+}
+
+bool IEMidiDispatchTable::StoreCoalescedValue(uint32_t EntryIndex, float Value) const
+{
+    IEMidiCoalescingSlot& CoalescingSlot = m_CoalescingSlots[EntryIndex];
+    CoalescingSlot.Value.store(Value, std::memory_order_relaxed);
+    return CoalescingSlot.bPending.exchange(true, std::memory_order_acq_rel);
+}
+
+bool IEMidiDispatchTable::TakeCoalescedValue(uint32_t EntryIndex, float& OutValue) const
+{
+    IEMidiCoalescingSlot& CoalescingSlot = m_CoalescingSlots[EntryIndex];
+    const bool bPending = CoalescingSlot.bPending.exchange(false, std::memory_order_acq_rel);
+    if (bPending)
+    {
+        OutValue = CoalescingSlot.Value.load(std::memory_order_relaxed);
+    }
+    return bPending;
+}
+
+int IEMidiDispatchTable::FindResponseInputValue(uint32_t EntryIndex, float Value) const
+{
+    const IEMidiDispatchEntry& MidiDispatchEntry = m_Entries[EntryIndex];
+    const std::span<const float> ResponseValues(m_ResponseValues.data() + MidiDispatchEntry.ResponseTableOffset, MidiDispatchEntry.ResponseTableSize);
+    if (ResponseValues.empty())
+    {
+        return -1;
+    }
+
+    size_t InputValue = 0;
+    if (MidiDispatchEntry.bIsResponseMonotonic)
+    {
+        const std::span<const float>::iterator It = ResponseValues.front() <= ResponseValues.back() ?
+            std::lower_bound(ResponseValues.begin(), ResponseValues.end(), Value) :
+            std::lower_bound(ResponseValues.begin(), ResponseValues.end(), Value, std::greater<float>());
+        InputValue = std::min<size_t>(It - ResponseValues.begin(), ResponseValues.size() - 1);
+        if (InputValue > 0 && std::abs(ResponseValues[InputValue - 1] - Value) <= std::abs(ResponseValues[InputValue] - Value))
+        {
+            InputValue--;
+        }
+    }
+    else
+    {
+        // Custom curves may fold back on themselves, the first closest value wins
+        for (size_t ValueIndex = 1; ValueIndex < ResponseValues.size(); ValueIndex++)
+        {
+            if (std::abs(ResponseValues[ValueIndex] - Value) < std::abs(ResponseValues[InputValue] - Value))
+            {
+                InputValue = ValueIndex;
+            }
+        }
+    }
+    return static_cast<int>(InputValue);
+}
+
+int IEMidiDispatchTable::GetDeviceValue(uint32_t EntryIndex) const
+{
+    return m_FeedbackSlots[EntryIndex].DeviceValue.load(std::memory_order_relaxed);
+}
+
+void IEMidiDispatchTable::SetDeviceValue(uint32_t EntryIndex, int DeviceValue) const
+{
+    m_FeedbackSlots[EntryIndex].DeviceValue.store(DeviceValue, std::memory_order_relaxed);
+}
+
+void IEMidiDispatchTable::ResetDeviceValues() const
+{
+    for (uint32_t EntryIndex = 0; EntryIndex < m_Entries.size(); EntryIndex++)
+    {
+        m_FeedbackSlots[EntryIndex].DeviceValue.store(-1, std::memory_order_relaxed);
+    }
+}
+
+void IEMidiDispatchTable::RecordInputValue(uint32_t EntryIndex, int Value, IEClock::time_point InputTime) const
+{
+    IEMidiFeedbackSlot& FeedbackSlot = m_FeedbackSlots[EntryIndex];
+    FeedbackSlot.DeviceValue.store(Value, std::memory_order_relaxed);
+    FeedbackSlot.LastInputTime.store(InputTime.time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+IEClock::time_point IEMidiDispatchTable::GetLastInputTime(uint32_t EntryIndex) const
+{
+    return IEClock::time_point(IEClock::duration(m_FeedbackSlots[EntryIndex].LastInputTime.load(std::memory_order_relaxed)));
+}
+
+bool IEMidiDispatchTable::IsHighResolutionMidiMessageType(IEMidiMessageType MidiMessageType)
+{
+    return MidiMessageType == IEMidiMessageType::HighResControlChange || IsParameterMidiMessageType(MidiMessageType);
+}
+
+bool IEMidiDispatchTable::IsParameterMidiMessageType(IEMidiMessageType MidiMessageType)
+{
+    return MidiMessageType == IEMidiMessageType::NRPN || MidiMessageType == IEMidiMessageType::RPN;
+}
+
+bool IEMidiDispatchTable::IsTriggerMidiMessageType(IEMidiMessageType MidiMessageType)
+{
+    return MidiMessageType == IEMidiMessageType::NoteOnOff || MidiMessageType == IEMidiMessageType::ProgramChange;
+}
+
+bool IEMidiDispatchTable::IsContinuousMidiMessageType(IEMidiMessageType MidiMessageType)
+{
+    return MidiMessageType == IEMidiMessageType::ControlChange || MidiMessageType == IEMidiMessageType::PolyPressure ||
+           MidiMessageType == IEMidiMessageType::ChannelPressure || MidiMessageType == IEMidiMessageType::PitchBend ||
+           IsHighResolutionMidiMessageType(MidiMessageType);
+}
+
+uint32_t IEMidiDispatchTable::GetMaxMidiValue(IEMidiMessageType MidiMessageType)
+{
+    return IsHighResolutionMidiMessageType(MidiMessageType) || MidiMessageType == IEMidiMessageType::PitchBend ? MIDI_14_BIT_MAX_VALUE : 127;
+}
+
+bool IEMidiDispatchTable::HasResponseCurve(IEMidiMessageType MidiMessageType, IEMidiActionType MidiActionType)
+{
+    return MidiActionType == IEMidiActionType::Volume || (MidiActionType == IEMidiActionType::ConsoleCommand && IsContinuousMidiMessageType(MidiMessageType));
+}
+
+bool IEMidiDispatchTable::IsValidDispatchKey(unsigned char Status, unsigned char Data1)
+{
+    return (Status & 0x80) && !(Data1 & 0x80);
+}
+
+uint32_t IEMidiDispatchTable::GetDispatchKey(unsigned char Status, unsigned char Data1)
+{
+    const unsigned char Address = IEMidiParser::GetStatusInfo(Status).bHasAddressByte ? Data1 : 0;
+    return (static_cast<uint32_t>(Status & 0x7F) << 7) | static_cast<uint32_t>(Address);
+}
+
+uint32_t IEMidiDispatchTable::GetParameterDispatchKey(IEMidiMessageType MidiMessageType, unsigned char Status, uint16_t ParameterNumber)
+{
+    return (static_cast<uint32_t>(MidiMessageType) << 18) | (static_cast<uint32_t>(Status & 0x0F) << 14) | (ParameterNumber & 0x3FFF);
+}
+
+float IEMidiDispatchTable::EvaluateResponseCurve(IEMidiResponseCurve ResponseCurve, float Input, std::span<const IEMidiResponseBreakpoint> ResponseBreakpoints)
+{
+    float Output = Input;
+    switch (ResponseCurve)
+    {
+        case IEMidiResponseCurve::Logarithmic:
+        {
+            // Linear in decibels over the range, the bottom of the travel is silence
+            Output = Input > 0.0f ? std::pow(10.0f, MIDI_RESPONSE_LOGARITHMIC_RANGE_DB * (Input - 1.0f) / 20.0f) : 0.0f;
+            break;
+        }
+        case IEMidiResponseCurve::Exponential:
+        {
+            Output = std::expm1(MIDI_RESPONSE_EXPONENTIAL_STEEPNESS * Input) / std::expm1(MIDI_RESPONSE_EXPONENTIAL_STEEPNESS);
+            break;
+        }
+        case IEMidiResponseCurve::SCurve:
+        {
+            Output = Input * Input * (3.0f - 2.0f * Input);
+            break;
+        }
+        case IEMidiResponseCurve::Custom:
+        {
+            // Piecewise linear through breakpoints sorted by input, flat before the first and after the last
+            if (!ResponseBreakpoints.empty())
+            {
+                const std::span<const IEMidiResponseBreakpoint>::iterator It = std::upper_bound(ResponseBreakpoints.begin(), ResponseBreakpoints.end(), Input,
+                    [](float Value, const IEMidiResponseBreakpoint& ResponseBreakpoint) { return Value < ResponseBreakpoint.Input; });
+                if (It == ResponseBreakpoints.begin())
+                {
+                    Output = It->Output;
+                }
+                else if (It == ResponseBreakpoints.end())
+                {
+                    Output = ResponseBreakpoints.back().Output;
+                }
+                else
+                {
+                    const IEMidiResponseBreakpoint& Lower = *(It - 1);
+                    const float InputSpan = It->Input - Lower.Input;
+                    Output = InputSpan > 0.0f ? Lower.Output + (Input - Lower.Input) / InputSpan * (It->Output - Lower.Output) : Lower.Output;
+                }
+            }
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+    return std::clamp(Output, 0.0f, 1.0f);
+}
+
+void IEMidiDispatchTable::CompileResponseTable(IEMidiDispatchEntry& MidiDispatchEntry, const IEMidiDeviceProperty& MidiDeviceProperty)
+{
+    const uint32_t MaxInputValue = GetMaxMidiValue(MidiDispatchEntry.MidiMessageType);
+    // Volume is in [0, 1], console commands keep the scale of a 7-bit value so the default curve passes data2 through unchanged
+    float OutputScale = 1.0f;
+    if (MidiDispatchEntry.MidiActionType == IEMidiActionType::ConsoleCommand)
+    {
+        OutputScale = MaxInputValue == MIDI_14_BIT_MAX_VALUE ? static_cast<float>(MIDI_14_BIT_MAX_VALUE) / 128.0f : 127.0f;
+    }
+
+    std::vector<IEMidiResponseBreakpoint> ResponseBreakpoints = MidiDeviceProperty.ResponseBreakpoints;
+    std::stable_sort(ResponseBreakpoints.begin(), ResponseBreakpoints.end(),
+                     [](const IEMidiResponseBreakpoint& A, const IEMidiResponseBreakpoint& B) { return A.Input < B.Input; });
+
+    const float ResponseMin = std::clamp(MidiDeviceProperty.ResponseMin, 0.0f, 1.0f);
+    const float ResponseMax = std::clamp(MidiDeviceProperty.ResponseMax, 0.0f, 1.0f);
+
+    MidiDispatchEntry.ResponseTableOffset = static_cast<uint32_t>(m_ResponseValues.size());
+    MidiDispatchEntry.ResponseTableSize = MaxInputValue + 1;
+    bool bIsNonDecreasing = true;
+    bool bIsNonIncreasing = true;
+    for (uint32_t InputValue = 0; InputValue <= MaxInputValue; InputValue++)
+    {
+        const float Input = static_cast<float>(InputValue) / static_cast<float>(MaxInputValue);
+        const float Output = EvaluateResponseCurve(MidiDeviceProperty.ResponseCurve, MidiDeviceProperty.bInvertResponse ? 1.0f - Input : Input, ResponseBreakpoints);
+        const float Value = (ResponseMin + (ResponseMax - ResponseMin) * Output) * OutputScale;
+        if (InputValue > 0)
+        {
+            bIsNonDecreasing &= Value >= m_ResponseValues.back();
+            bIsNonIncreasing &= Value <= m_ResponseValues.back();
+        }
+        m_ResponseValues.push_back(Value);
+    }
+    MidiDispatchEntry.bIsResponseMonotonic = bIsNonDecreasing || bIsNonIncreasing;
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include "IECore.h"
+
+#include "IEMidiTypes.h"
+
+// Number of (status, data1) keys, status bytes are 0x80-0xFF and data bytes are 0x00-0x7F
+static constexpr size_t MIDI_DISPATCH_KEY_COUNT = 128 * 128;
+
+struct IEMidiDispatchEntry
+{
+public:
+    uint32_t PropertyRuntimeID = 0;
+    IEMidiMessageType MidiMessageType = IEMidiMessageType::None;
+    IEMidiActionType MidiActionType = IEMidiActionType::None;
+    IEMidiMessage MidiMessage;
+    std::string ConsoleCommand = std::string();
+    std::string OpenFilePath = std::string();
+    bool bToggle = false;
+    bool bCoalesce = false;
+    uint32_t ResponseTableOffset = 0;
+    uint32_t ResponseTableSize = 0;
+    bool bIsResponseMonotonic = false;
+    uint8_t ValueMin = 0;
+    uint8_t ValueMax = 127;
+    /* Channel wildcard or data1 range, such an entry has no single control to mirror state to */
+    bool bMatchesSeveralControls = false;
+    uint32_t FirstMacroStepIndex = 0;
+    uint32_t MacroStepCount = 0;
+    bool bPersistentConsoleCommand = false;
+    uint8_t ConsoleCommandWorkerCount = DEFAULT_CONSOLE_COMMAND_WORKER_COUNT;
+    uint16_t ConsoleCommandQueueDepth = DEFAULT_CONSOLE_COMMAND_QUEUE_DEPTH;
+};
+
+/*
+* Immutable snapshot of a device profile compiled for dispatch.
+* Entries are grouped per (status, data1) key so that an incoming message
+* resolves to all of its bound actions with a single indexed lookup.
+* HighResControlChange entries share the key of their MSB controller, NRPN and RPN entries store the
+* parameter number as data1 (MSB) and data2 (LSB) and are looked up in a separate sorted parameter index.
+* ChannelPressure and PitchBend carry their value in data1, they are keyed by their status alone.
+* Channel wildcard and data1 range rules are expanded into every key they cover when the table is built.
+* Runtime toggle and feedback state lives alongside the entries and is carried over between rebuilds.
+* Continuous entries own a dense table holding the action value for every input value, response curves,
+* range and inversion are evaluated once when the table is built and never on the input path.
+*/
+class IEMidiDispatchTable
+{
+public:
+    IEMidiDispatchTable() = default;
+    IEMidiDispatchTable(const IEMidiDeviceProfile& MidiDeviceProfile, const IEMidiDispatchTable* PreviousMidiDispatchTable = nullptr);
+
+public:
+    std::span<const uint32_t> FindEntryIndices(unsigned char Status, unsigned char Data1) const;
+    std::span<const uint32_t> FindParameterEntryIndices(IEMidiMessageType MidiMessageType, unsigned char Status, uint16_t ParameterNumber) const;
+    const IEMidiDispatchEntry& GetEntry(uint32_t EntryIndex) const { return m_Entries[EntryIndex]; }
+    size_t GetEntryCount() const { return m_Entries.size(); }
+
+    bool GetToggleState(uint32_t EntryIndex) const;
+    void SetToggleState(uint32_t EntryIndex, bool bActive) const;
+
+    /* Latest-value slots of ControlChange entries that are applied at a bounded rate */
+    std::span<const uint32_t> GetCoalescedEntryIndices() const { return m_CoalescedEntryIndices; }
+    uint32_t GetCoalescingRateHz() const { return m_CoalescingRateHz; }
+    bool StoreCoalescedValue(uint32_t EntryIndex, float Value) const;
+    bool TakeCoalescedValue(uint32_t EntryIndex, float& OutValue) const;
+
+    /* Action value of an input value, only valid for entries with a response table */
+    float GetResponseValue(uint32_t EntryIndex, uint32_t InputValue) const
+    {
+        const IEMidiDispatchEntry& MidiDispatchEntry = m_Entries[EntryIndex];
+        return m_ResponseValues[MidiDispatchEntry.ResponseTableOffset + std::min(InputValue, MidiDispatchEntry.ResponseTableSize - 1)];
+    }
+    /* Input value whose action value is closest, used to mirror an action value back to the control, -1 without a response table */
+    int FindResponseInputValue(uint32_t EntryIndex, float Value) const;
+
+    /* Last data2 the device is known to show for an entry, -1 when unknown, used to only send feedback that changes it */
+    int GetDeviceValue(uint32_t EntryIndex) const;
+    void SetDeviceValue(uint32_t EntryIndex, int DeviceValue) const;
+    void ResetDeviceValues() const;
+    /* Input moved the control itself, its position is the device value and feedback holds off while it is being touched */
+    void RecordInputValue(uint32_t EntryIndex, int Value, IEClock::time_point InputTime) const;
+    IEClock::time_point GetLastInputTime(uint32_t EntryIndex) const;
+
+    /* Output side of the profile, read by the output scheduler */
+    std::span<const IEMidiMessage> GetInitialOutputMidiMessages() const { return m_InitialOutputMidiMessages; }
+    uint32_t GetOutputRateHz() const { return m_OutputRateHz; }
+    const std::string& GetMidiDeviceName() const { return m_MidiDeviceName; }
+
+    /* Steps of a Macro entry, owned by the table so a running macro keeps them for as long as it holds the table */
+    std::span<const IEMidiMacroStep> GetMacroSteps(uint32_t EntryIndex) const
+    {
+        const IEMidiDispatchEntry& MidiDispatchEntry = m_Entries[EntryIndex];
+        return std::span<const IEMidiMacroStep>(m_MacroSteps.data() + MidiDispatchEntry.FirstMacroStepIndex, MidiDispatchEntry.MacroStepCount);
+    }
+
+public:
+    /* Types whose 14-bit value is assembled by the control change decoder instead of read from a single message */
+    static bool IsHighResolutionMidiMessageType(IEMidiMessageType MidiMessageType);
+    static bool IsParameterMidiMessageType(IEMidiMessageType MidiMessageType);
+    /* Messages that fire an action when pressed, as opposed to continuous controls whose value is forwarded */
+    static bool IsTriggerMidiMessageType(IEMidiMessageType MidiMessageType);
+    static bool IsContinuousMidiMessageType(IEMidiMessageType MidiMessageType);
+    /* 16383 for 14-bit values, 127 otherwise */
+    static uint32_t GetMaxMidiValue(IEMidiMessageType MidiMessageType);
+    /* Bindings whose action takes a continuous value, those are the ones shaped by a response curve */
+    static bool HasResponseCurve(IEMidiMessageType MidiMessageType, IEMidiActionType MidiActionType);
+
+private:
+    static bool IsValidDispatchKey(unsigned char Status, unsigned char Data1);
+    static uint32_t GetDispatchKey(unsigned char Status, unsigned char Data1);
+    static uint32_t GetParameterDispatchKey(IEMidiMessageType MidiMessageType, unsigned char Status, uint16_t ParameterNumber);
+    static float EvaluateResponseCurve(IEMidiResponseCurve ResponseCurve, float Input, std::span<const IEMidiResponseBreakpoint> ResponseBreakpoints);
+
+private:
+    void CompileResponseTable(IEMidiDispatchEntry& MidiDispatchEntry, const IEMidiDeviceProperty& MidiDeviceProperty);
+
+private:
+    struct IEMidiCoalescingSlot
+    {
+    public:
+        std::atomic<float> Value = 0.0f;
+        std::atomic<bool> bPending = false;
+    };
+
+    struct IEMidiFeedbackSlot
+    {
+    public:
+        std::atomic<int> DeviceValue = -1;
+        std::atomic<IEClock::duration::rep> LastInputTime = 0;
+    };
+
+private:
+    std::vector<IEMidiDispatchEntry> m_Entries;
+    std::vector<uint32_t> m_BucketOffsets;
+    std::vector<uint32_t> m_BucketEntryIndices;
+    std::vector<uint32_t> m_ParameterDispatchKeys;
+    std::vector<uint32_t> m_ParameterEntryIndices;
+    std::vector<float> m_ResponseValues;
+    std::vector<IEMidiMacroStep> m_MacroSteps;
+    std::unique_ptr<std::atomic<bool>[]> m_ToggleStates;
+    std::vector<uint32_t> m_CoalescedEntryIndices;
+    std::unique_ptr<IEMidiCoalescingSlot[]> m_CoalescingSlots;
+    std::unique_ptr<IEMidiFeedbackSlot[]> m_FeedbackSlots;
+    uint32_t m_CoalescingRateHz = DEFAULT_COALESCING_RATE_HZ;
+    std::vector<IEMidiMessage> m_InitialOutputMidiMessages;
+    uint32_t m_OutputRateHz = DEFAULT_OUTPUT_RATE_HZ;
+    std::string m_MidiDeviceName;
+};
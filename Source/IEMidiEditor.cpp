@@ -8,6 +8,18 @@ static constexpr size_t MidiDevicePropertyEditorColumnCount = 7;
 static constexpr size_t MidiDeviceInitialOutputMessageEditorColumnCount = 3;
 static constexpr float InputBoxSizeWidth = 150.0f;
 
+/* Sized from the status byte so a two byte message is not saved with a trailing zero, unknown statuses keep every byte */
+static IEMidiMessage GetEditedMidiMessage(const std::array<int, MIDI_MESSAGE_BYTE_COUNT>& MidiMessageBuf)
+{
+    IEMidiMessage MidiMessage(static_cast<unsigned char>(MidiMessageBuf[0]), static_cast<unsigned char>(MidiMessageBuf[1]),
+                              static_cast<unsigned char>(MidiMessageBuf[2]));
+    if (const size_t MidiMessageSize = IEMidiParser::GetMidiMessageSize(MidiMessage[0]))
+    {
+        MidiMessage.Size = static_cast<uint8_t>(MidiMessageSize);
+    }
+    return MidiMessage;
+}
+
 void IEMidiEditor::DrawMidiDeviceProfileEditor(IEMidiDeviceProfile& MidiDeviceProfile) const
 {
     ImGui::PushFont(ImGui::IEStyle::GetTitleFont());
@@ -18,6 +30,19 @@ void IEMidiEditor::DrawMidiDeviceProfileEditor(IEMidiDeviceProfile& MidiDevicePr
     ImGui::WindowPositionedText(0.02f, 0.2f, "Input Editor");
     ImGui::PopFont();
 
+    bool bPropertiesChanged = false;
+
+    ImGui::SameLine();
+    bPropertiesChanged |= ImGui::Checkbox("Coalesce Control Changes", &MidiDeviceProfile.bCoalesceControlChanges);
+    ImGui::SameLine();
+    int CoalescingRateHz = static_cast<int>(MidiDeviceProfile.CoalescingRateHz);
+    ImGui::SetNextItemWidth(InputBoxSizeWidth * 0.5f);
+    if (ImGui::InputInt("Hz##Coalescing Rate", &CoalescingRateHz, 0))
+    {
+        MidiDeviceProfile.CoalescingRateHz = static_cast<uint32_t>(std::clamp(CoalescingRateHz, 1, 1000));
+        bPropertiesChanged = true;
+    }
+
     ImGui::SetSmartCursorPosXRelative(0.02f);
     if (ImGui::BeginTable("Profile Midi Input Editor", 1))
     {
@@ -27,7 +52,9 @@ void IEMidiEditor::DrawMidiDeviceProfileEditor(IEMidiDeviceProfile& MidiDevicePr
             ImGui::PushID(&*It);
             ImGui::TableNextColumn();
             bool bDeleteRequested = false;
-            DrawMidiDevicePropertyEditor(*It, bDeleteRequested);
+            bool bPropertyChanged = false;
+            DrawMidiDevicePropertyEditor(*It, bDeleteRequested, bPropertyChanged);
+            bPropertiesChanged |= bDeleteRequested || bPropertyChanged;
             It = bDeleteRequested ? MidiDeviceProfile.Properties.erase(It) : It+1;
             ImGui::PopID();
         }
@@ -44,20 +71,37 @@ void IEMidiEditor::DrawMidiDeviceProfileEditor(IEMidiDeviceProfile& MidiDevicePr
         ImGui::EndTable();
     }
 
+    if (bPropertiesChanged && m_MidiDeviceProcessor)
+    {
+        m_MidiDeviceProcessor->RefreshMidiDispatchTable(MidiDeviceProfile.Name);
+    }
+
     ImGui::PushFont(ImGui::IEStyle::GetSubtitleFont());
     ImGui::WindowPositionedText(0.02f, 0.6f, "Output Editor");
     ImGui::PopFont();
 
+    ImGui::SameLine();
+    int OutputRateHz = static_cast<int>(MidiDeviceProfile.OutputRateHz);
+    ImGui::SetNextItemWidth(InputBoxSizeWidth * 0.5f);
+    if (ImGui::InputInt("Messages/s##Output Rate", &OutputRateHz, 0))
+    {
+        MidiDeviceProfile.OutputRateHz = static_cast<uint32_t>(std::clamp(OutputRateHz, 1, 10000));
+        if (m_MidiDeviceProcessor)
+        {
+            m_MidiDeviceProcessor->RefreshMidiDispatchTable(MidiDeviceProfile.Name);
+        }
+    }
+
     ImGui::SetSmartCursorPosXRelative(0.02f);
     if (ImGui::BeginTable("Profile Output Midi Message Editor", 1))
     {
-        for (std::vector<std::vector<unsigned char>>::iterator It = MidiDeviceProfile.InitialOutputMidiMessages.begin();
+        for (std::vector<IEMidiMessage>::iterator It = MidiDeviceProfile.InitialOutputMidiMessages.begin();
             It != MidiDeviceProfile.InitialOutputMidiMessages.end();)
         {
             ImGui::PushID(&*It);
             ImGui::TableNextColumn();
             bool bDeleteRequested = false;
-            DrawInitialOutputMessageEditor(*It, bDeleteRequested);
+            DrawInitialOutputMessageEditor(MidiDeviceProfile.Name, *It, bDeleteRequested);
             It = bDeleteRequested ? MidiDeviceProfile.InitialOutputMidiMessages.erase(It) : It+1;
             ImGui::PopID();
         }
@@ -67,7 +111,7 @@ void IEMidiEditor::DrawMidiDeviceProfileEditor(IEMidiDeviceProfile& MidiDevicePr
         ImGui::PushFont(ImGui::IEStyle::GetSubtitleFont());
         if (ImGui::IEStyle::SquareButton("+"))
         {
-            MidiDeviceProfile.InitialOutputMidiMessages.push_back(std::vector<unsigned char>(MIDI_MESSAGE_BYTE_COUNT));
+            MidiDeviceProfile.InitialOutputMidiMessages.push_back(IEMidiMessage());
         }
         ImGui::PopFont();
 
@@ -75,14 +119,21 @@ void IEMidiEditor::DrawMidiDeviceProfileEditor(IEMidiDeviceProfile& MidiDevicePr
     }
 }
 
-void IEMidiEditor::DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDeviceProperty, bool& bDeleteRequested) const
+void IEMidiEditor::DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDeviceProperty, bool& bDeleteRequested, bool& bPropertyChanged) const
 {
     if (ImGui::BeginTable("Midi Property Editor", MidiDevicePropertyEditorColumnCount, ImGuiTableFlags_Hideable | ImGuiTableFlags_SizingFixedFit))
     {
         static const char MessageTypesStringArray[static_cast<int>(IEMidiMessageType::Count)][std::size("-Select Message Type")] =
         {   "-Select Message Type",
             "NoteOnOff",
-            "ControlChange" };
+            "ControlChange",
+            "HighResControlChange",
+            "NRPN",
+            "RPN",
+            "PolyPressure",
+            "ProgramChange",
+            "ChannelPressure",
+            "PitchBend" };
         ImGui::TableNextColumn();
         ImGui::SetNextItemWidth(ImGui::CalcTextSize("-Select Message Type").x * 1.3f);
         if (ImGui::BeginCombo("##1", MessageTypesStringArray[static_cast<int>(MidiDeviceProperty.MidiMessageType)]))
@@ -92,16 +143,22 @@ void IEMidiEditor::DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDevice
                 if (ImGui::Selectable(MessageTypesStringArray[i]))
                 {
                     MidiDeviceProperty.MidiMessageType = static_cast<IEMidiMessageType>(i);
+                    bPropertyChanged = true;
                 }
             }
 
             ImGui::EndCombo();
         }
 
-        if (MidiDeviceProperty.MidiMessageType == IEMidiMessageType::NoteOnOff)
+        if (IEMidiDispatchTable::IsTriggerMidiMessageType(MidiDeviceProperty.MidiMessageType))
+        {
+            ImGui::SameLine();
+            bPropertyChanged |= ImGui::Checkbox("Toggle", &MidiDeviceProperty.bToggle);
+        }
+        else if (IEMidiDispatchTable::IsContinuousMidiMessageType(MidiDeviceProperty.MidiMessageType))
         {
             ImGui::SameLine();
-            ImGui::Checkbox("Toggle", &MidiDeviceProperty.bToggle);
+            bPropertyChanged |= ImGui::Checkbox("Coalesce", &MidiDeviceProperty.bCoalesce);
         }
 
         static const char ActionTypesStringArray[static_cast<int>(IEMidiActionType::Count)][std::size("-Select Action Type")] =
@@ -109,7 +166,8 @@ void IEMidiEditor::DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDevice
             "Volume",
             "Mute",
             "Console Command",
-            "Open File" };
+            "Open File",
+            "Macro" };
         ImGui::TableNextColumn();
         ImGui::SetNextItemWidth(ImGui::CalcTextSize("-Select Action Type").x * 1.3f);
         if (ImGui::BeginCombo("##2", ActionTypesStringArray[static_cast<int>(MidiDeviceProperty.MidiActionType)]))
@@ -119,6 +177,7 @@ void IEMidiEditor::DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDevice
                 if (ImGui::Selectable(ActionTypesStringArray[i]))
                 {
                     MidiDeviceProperty.MidiActionType = static_cast<IEMidiActionType>(i);
+                    bPropertyChanged = true;
                 }
             }
 
@@ -135,7 +194,7 @@ void IEMidiEditor::DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDevice
                 std::strncpy(Buffer, MidiDeviceProperty.ConsoleCommand.c_str(), sizeof(Buffer) - 1);
                 Buffer[sizeof(Buffer) - 1] = '\0';
                 ImGui::SetNextItemWidth(InputBoxSizeWidth);
-                ImGui::InputText("##Input Console Command", Buffer, std::size(Buffer));
+                bPropertyChanged |= ImGui::InputText("##Input Console Command", Buffer, std::size(Buffer));
                 MidiDeviceProperty.ConsoleCommand = Buffer;
                 ImGui::TableNextColumn();
                 ImGui::TableSetColumnEnabled(-1, false);
@@ -144,7 +203,11 @@ void IEMidiEditor::DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDevice
             }
             case IEMidiActionType::OpenFile:
             {
-                MidiDeviceProperty.MidiMessageType = IEMidiMessageType::NoteOnOff;
+                if (!IEMidiDispatchTable::IsTriggerMidiMessageType(MidiDeviceProperty.MidiMessageType))
+                {
+                    MidiDeviceProperty.MidiMessageType = IEMidiMessageType::NoteOnOff;
+                    bPropertyChanged = true;
+                }
 
                 ImGui::TableNextColumn();
                 ImGui::TableSetColumnEnabled(-1, false);
@@ -155,11 +218,30 @@ void IEMidiEditor::DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDevice
                 std::strncpy(Buffer, MidiDeviceProperty.OpenFilePath.c_str(), sizeof(Buffer) - 1);
                 Buffer[sizeof(Buffer) - 1] = '\0';
                 ImGui::SetNextItemWidth(InputBoxSizeWidth);
-                ImGui::InputText("##Input Open File Path", Buffer, std::size(Buffer));
+                bPropertyChanged |= ImGui::InputText("##Input Open File Path", Buffer, std::size(Buffer));
                 MidiDeviceProperty.OpenFilePath = Buffer;
 
                 ImGui::SameLine();
+                const std::string PreviousOpenFilePath = MidiDeviceProperty.OpenFilePath;
                 ImGui::FileFinder("Find File", 3, MidiDeviceProperty.OpenFilePath);
+                bPropertyChanged |= PreviousOpenFilePath != MidiDeviceProperty.OpenFilePath;
+                break;
+            }
+            case IEMidiActionType::Macro:
+            {
+                if (!IEMidiDispatchTable::IsTriggerMidiMessageType(MidiDeviceProperty.MidiMessageType))
+                {
+                    MidiDeviceProperty.MidiMessageType = IEMidiMessageType::NoteOnOff;
+                    bPropertyChanged = true;
+                }
+
+                ImGui::TableNextColumn();
+                ImGui::TableSetColumnEnabled(-1, false);
+                MidiDeviceProperty.ConsoleCommand.clear();
+
+                ImGui::TableNextColumn();
+                ImGui::TableSetColumnEnabled(-1, false);
+                MidiDeviceProperty.OpenFilePath.clear();
                 break;
             }
             default:
@@ -185,6 +267,7 @@ void IEMidiEditor::DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDevice
             if (ImGui::Selectable("Record Midi", MidiDeviceProperty.bIsRecording, ImGuiSelectableFlags_AllowOverlap, ImVec2(0.f, 0.f), true))
             {
                 MidiDeviceProperty.bIsRecording = true;
+                m_MidiDeviceProcessor->SetMidiRecording(MidiDeviceProperty.MidiDeviceName, true);
             }
 
             ImGui::GetWindowDrawList()->ChannelsSetCurrent(0);
@@ -209,9 +292,44 @@ void IEMidiEditor::DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDevice
         ImGui::TableNextColumn();
         std::array<int, MIDI_MESSAGE_BYTE_COUNT> MidiMessageBuf = { MidiDeviceProperty.MidiMessage[0], MidiDeviceProperty.MidiMessage[1], MidiDeviceProperty.MidiMessage[2] };
         ImGui::SetNextItemWidth(InputBoxSizeWidth);
-        ImGui::InputInt3("##Input Midi Message", MidiMessageBuf.data());
-        MidiDeviceProperty.MidiMessage.resize(MIDI_MESSAGE_BYTE_COUNT);
-        std::copy(MidiMessageBuf.begin(), MidiMessageBuf.end(), MidiDeviceProperty.MidiMessage.begin());
+        const bool bMidiMessageChanged = ImGui::InputInt3("##Input Midi Message", MidiMessageBuf.data());
+        if (ImGui::IsItemHovered())
+        {
+            switch (MidiDeviceProperty.MidiMessageType)
+            {
+                case IEMidiMessageType::HighResControlChange:
+                {
+                    ImGui::SetTooltip("Status, MSB controller (0-31), unused");
+                    break;
+                }
+                case IEMidiMessageType::NRPN:
+                case IEMidiMessageType::RPN:
+                {
+                    ImGui::SetTooltip("Status, parameter MSB, parameter LSB");
+                    break;
+                }
+                case IEMidiMessageType::ProgramChange:
+                {
+                    ImGui::SetTooltip("Status, program, unused");
+                    break;
+                }
+                case IEMidiMessageType::ChannelPressure:
+                case IEMidiMessageType::PitchBend:
+                {
+                    ImGui::SetTooltip("Status, unused, unused");
+                    break;
+                }
+                default:
+                {
+                    break;
+                }
+            }
+        }
+        if (bMidiMessageChanged)
+        {
+            MidiDeviceProperty.MidiMessage = GetEditedMidiMessage(MidiMessageBuf);
+            bPropertyChanged = true;
+        }
 
         ImGui::TableNextColumn();
         static const char Delete[] = "Delete";
@@ -221,24 +339,263 @@ void IEMidiEditor::DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDevice
 
         ImGui::EndTable();
     }
+
+    if (MidiDeviceProperty.MidiMessageType != IEMidiMessageType::None && ImGui::TreeNode("Matching"))
+    {
+        bPropertyChanged |= ImGui::Checkbox("Any Channel", &MidiDeviceProperty.bAnyChannel);
+
+        ImGui::SameLine();
+        int Data1RangeEnd = MidiDeviceProperty.Data1RangeEnd;
+        ImGui::SetNextItemWidth(InputBoxSizeWidth * 0.5f);
+        if (ImGui::InputInt("Data1 Range End", &Data1RangeEnd, 0))
+        {
+            MidiDeviceProperty.Data1RangeEnd = static_cast<uint8_t>(std::clamp(Data1RangeEnd, 0, 127));
+            bPropertyChanged = true;
+        }
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Matches every data1 from the message's up to this one, ignored when not above it");
+        }
+
+        ImGui::SameLine();
+        std::array<int, 2> ValueThresholdBuf = { MidiDeviceProperty.ValueMin, MidiDeviceProperty.ValueMax };
+        ImGui::SetNextItemWidth(InputBoxSizeWidth);
+        if (ImGui::InputInt2("Value Range", ValueThresholdBuf.data()))
+        {
+            MidiDeviceProperty.ValueMin = static_cast<uint8_t>(std::clamp(ValueThresholdBuf[0], 0, 127));
+            MidiDeviceProperty.ValueMax = static_cast<uint8_t>(std::clamp(ValueThresholdBuf[1], static_cast<int>(MidiDeviceProperty.ValueMin), 127));
+            bPropertyChanged = true;
+        }
+
+        ImGui::TreePop();
+    }
+
+    if (MidiDeviceProperty.MidiActionType == IEMidiActionType::ConsoleCommand && IEMidiConsoleCommandRunner::IsSupported() &&
+        ImGui::TreeNode("Command Runner"))
+    {
+        bPropertyChanged |= ImGui::Checkbox("Persistent", &MidiDeviceProperty.bPersistentConsoleCommand);
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Keeps the command running and writes one value per line to its standard input");
+        }
+
+        ImGui::SameLine();
+        int ConsoleCommandWorkerCount = MidiDeviceProperty.ConsoleCommandWorkerCount;
+        ImGui::SetNextItemWidth(InputBoxSizeWidth * 0.5f);
+        if (ImGui::InputInt("Workers", &ConsoleCommandWorkerCount, 0))
+        {
+            MidiDeviceProperty.ConsoleCommandWorkerCount = static_cast<uint8_t>(std::clamp<int>(ConsoleCommandWorkerCount, 1, MAX_CONSOLE_COMMAND_WORKER_COUNT));
+            bPropertyChanged = true;
+        }
+
+        ImGui::SameLine();
+        int ConsoleCommandQueueDepth = MidiDeviceProperty.ConsoleCommandQueueDepth;
+        ImGui::SetNextItemWidth(InputBoxSizeWidth * 0.5f);
+        if (ImGui::InputInt("Queue Depth", &ConsoleCommandQueueDepth, 0))
+        {
+            MidiDeviceProperty.ConsoleCommandQueueDepth = static_cast<uint16_t>(std::clamp(ConsoleCommandQueueDepth, 1, 4096));
+            bPropertyChanged = true;
+        }
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Values waiting for a busy command, the oldest is dropped beyond this");
+        }
+
+        ImGui::TreePop();
+    }
+
+    if (IEMidiDispatchTable::HasResponseCurve(MidiDeviceProperty.MidiMessageType, MidiDeviceProperty.MidiActionType) && ImGui::TreeNode("Response Curve"))
+    {
+        static const char ResponseCurvesStringArray[static_cast<int>(IEMidiResponseCurve::Count)][std::size("Logarithmic")] =
+        {   "Linear",
+            "Logarithmic",
+            "Exponential",
+            "S-Curve",
+            "Custom" };
+        ImGui::SetNextItemWidth(ImGui::CalcTextSize("Logarithmic").x * 1.5f);
+        if (ImGui::BeginCombo("##Response Curve", ResponseCurvesStringArray[static_cast<int>(MidiDeviceProperty.ResponseCurve)]))
+        {
+            for (int i = 0; i < std::size(ResponseCurvesStringArray); i++)
+            {
+                if (ImGui::Selectable(ResponseCurvesStringArray[i]))
+                {
+                    MidiDeviceProperty.ResponseCurve = static_cast<IEMidiResponseCurve>(i);
+                    bPropertyChanged = true;
+                }
+            }
+
+            ImGui::EndCombo();
+        }
+
+        ImGui::SameLine();
+        bPropertyChanged |= ImGui::Checkbox("Invert", &MidiDeviceProperty.bInvertResponse);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(InputBoxSizeWidth);
+        bPropertyChanged |= ImGui::SliderFloat("Min##Response Min", &MidiDeviceProperty.ResponseMin, 0.0f, 1.0f);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(InputBoxSizeWidth);
+        bPropertyChanged |= ImGui::SliderFloat("Max##Response Max", &MidiDeviceProperty.ResponseMax, 0.0f, 1.0f);
+
+        if (MidiDeviceProperty.ResponseCurve == IEMidiResponseCurve::Custom)
+        {
+            for (std::vector<IEMidiResponseBreakpoint>::iterator It = MidiDeviceProperty.ResponseBreakpoints.begin();
+                It != MidiDeviceProperty.ResponseBreakpoints.end();)
+            {
+                ImGui::PushID(&*It);
+                std::array<float, 2> ResponseBreakpointBuf = { It->Input, It->Output };
+                ImGui::SetNextItemWidth(InputBoxSizeWidth * 2.0f);
+                if (ImGui::SliderFloat2("Input, Output##Response Breakpoint", ResponseBreakpointBuf.data(), 0.0f, 1.0f))
+                {
+                    It->Input = ResponseBreakpointBuf[0];
+                    It->Output = ResponseBreakpointBuf[1];
+                    bPropertyChanged = true;
+                }
+                ImGui::SameLine();
+                const bool bDeleteBreakpointRequested = ImGui::IEStyle::RedButton("Delete");
+                bPropertyChanged |= bDeleteBreakpointRequested;
+                ImGui::PopID();
+                It = bDeleteBreakpointRequested ? MidiDeviceProperty.ResponseBreakpoints.erase(It) : It+1;
+            }
+
+            if (ImGui::Button("Add Breakpoint"))
+            {
+                const IEMidiResponseBreakpoint ResponseBreakpoint = MidiDeviceProperty.ResponseBreakpoints.empty() ?
+                    IEMidiResponseBreakpoint() : IEMidiResponseBreakpoint{ 1.0f, 1.0f };
+                MidiDeviceProperty.ResponseBreakpoints.push_back(ResponseBreakpoint);
+                bPropertyChanged = true;
+            }
+        }
+
+        ImGui::TreePop();
+    }
+
+    if (MidiDeviceProperty.MidiActionType != IEMidiActionType::Macro)
+    {
+        MidiDeviceProperty.MacroSteps.clear();
+    }
+    else if (ImGui::TreeNode("Macro Steps"))
+    {
+        static const char MacroStepTypesStringArray[static_cast<int>(IEMidiMacroStepType::Count)][std::size("Console Command")] =
+        {   "Delay",
+            "Volume",
+            "Volume Ramp",
+            "Mute",
+            "Console Command",
+            "Midi Output" };
+        for (std::vector<IEMidiMacroStep>::iterator It = MidiDeviceProperty.MacroSteps.begin(); It != MidiDeviceProperty.MacroSteps.end();)
+        {
+            ImGui::PushID(&*It);
+            ImGui::SetNextItemWidth(ImGui::CalcTextSize("Console Command").x * 1.3f);
+            if (ImGui::BeginCombo("##Macro Step Type", MacroStepTypesStringArray[static_cast<int>(It->MacroStepType)]))
+            {
+                for (int i = 0; i < std::size(MacroStepTypesStringArray); i++)
+                {
+                    if (ImGui::Selectable(MacroStepTypesStringArray[i]))
+                    {
+                        It->MacroStepType = static_cast<IEMidiMacroStepType>(i);
+                        bPropertyChanged = true;
+                    }
+                }
+
+                ImGui::EndCombo();
+            }
+
+            ImGui::SameLine();
+            switch (It->MacroStepType)
+            {
+                case IEMidiMacroStepType::Volume:
+                case IEMidiMacroStepType::VolumeRamp:
+                {
+                    ImGui::SetNextItemWidth(InputBoxSizeWidth);
+                    bPropertyChanged |= ImGui::SliderFloat("Volume##Macro Step Value", &It->Value, 0.0f, 1.0f);
+                    break;
+                }
+                case IEMidiMacroStepType::Mute:
+                {
+                    bool bMute = It->Value != 0.0f;
+                    if (ImGui::Checkbox("Mute##Macro Step Value", &bMute))
+                    {
+                        It->Value = bMute ? 1.0f : 0.0f;
+                        bPropertyChanged = true;
+                    }
+                    break;
+                }
+                case IEMidiMacroStepType::ConsoleCommand:
+                {
+                    char Buffer[256] = {0};
+                    std::strncpy(Buffer, It->ConsoleCommand.c_str(), sizeof(Buffer) - 1);
+                    Buffer[sizeof(Buffer) - 1] = '\0';
+                    ImGui::SetNextItemWidth(InputBoxSizeWidth);
+                    bPropertyChanged |= ImGui::InputText("##Macro Step Console Command", Buffer, std::size(Buffer));
+                    It->ConsoleCommand = Buffer;
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(InputBoxSizeWidth * 0.5f);
+                    bPropertyChanged |= ImGui::InputFloat("Value##Macro Step Value", &It->Value);
+                    break;
+                }
+                case IEMidiMacroStepType::MidiOutput:
+                {
+                    std::array<int, MIDI_MESSAGE_BYTE_COUNT> MacroStepMidiMessageBuf = { It->MidiMessage[0], It->MidiMessage[1], It->MidiMessage[2] };
+                    ImGui::SetNextItemWidth(InputBoxSizeWidth);
+                    if (ImGui::InputInt3("##Macro Step Midi Message", MacroStepMidiMessageBuf.data()))
+                    {
+                        It->MidiMessage = GetEditedMidiMessage(MacroStepMidiMessageBuf);
+                        bPropertyChanged = true;
+                    }
+                    break;
+                }
+                default:
+                {
+                    break;
+                }
+            }
+
+            if (It->MacroStepType == IEMidiMacroStepType::Delay || It->MacroStepType == IEMidiMacroStepType::VolumeRamp)
+            {
+                ImGui::SameLine();
+                int DurationMs = static_cast<int>(It->DurationMs);
+                ImGui::SetNextItemWidth(InputBoxSizeWidth * 0.5f);
+                if (ImGui::InputInt("Ms##Macro Step Duration", &DurationMs, 0))
+                {
+                    It->DurationMs = static_cast<uint32_t>(std::max(DurationMs, 0));
+                    bPropertyChanged = true;
+                }
+            }
+
+            ImGui::SameLine();
+            const bool bDeleteMacroStepRequested = ImGui::IEStyle::RedButton("Delete");
+            bPropertyChanged |= bDeleteMacroStepRequested;
+            ImGui::PopID();
+            It = bDeleteMacroStepRequested ? MidiDeviceProperty.MacroSteps.erase(It) : It+1;
+        }
+
+        if (ImGui::Button("Add Step"))
+        {
+            MidiDeviceProperty.MacroSteps.emplace_back();
+            bPropertyChanged = true;
+        }
+
+        ImGui::TreePop();
+    }
 }
 
-void IEMidiEditor::DrawInitialOutputMessageEditor(std::vector<unsigned char>& MidiDeviceInitialOutputMidiMessage, bool& bDeleteRequested) const
+void IEMidiEditor::DrawInitialOutputMessageEditor(const std::string& MidiDeviceName, IEMidiMessage& MidiDeviceInitialOutputMidiMessage, bool& bDeleteRequested) const
 {
     if (ImGui::BeginTable("Profile Midi Output Editor", MidiDeviceInitialOutputMessageEditorColumnCount, ImGuiTableFlags_SizingFixedFit))
     {
         ImGui::TableNextColumn();
         if (ImGui::Button("Send Midi Out"))
         {
-            m_MidiDeviceProcessor->SendMidiOutputMessage(MidiDeviceInitialOutputMidiMessage);
+            m_MidiDeviceProcessor->SendMidiOutputMessage(MidiDeviceName, MidiDeviceInitialOutputMidiMessage);
         }
 
         ImGui::TableNextColumn();
         std::array<int, MIDI_MESSAGE_BYTE_COUNT> InitialOutputMidiMessageBuf = { MidiDeviceInitialOutputMidiMessage[0], MidiDeviceInitialOutputMidiMessage[1], MidiDeviceInitialOutputMidiMessage[2] };
         ImGui::SetNextItemWidth(InputBoxSizeWidth);
-        ImGui::InputInt3("##Input Midi Message", InitialOutputMidiMessageBuf.data());
-        MidiDeviceInitialOutputMidiMessage.resize(MIDI_MESSAGE_BYTE_COUNT);
-        std::copy(InitialOutputMidiMessageBuf.begin(), InitialOutputMidiMessageBuf.end(), MidiDeviceInitialOutputMidiMessage.begin());
+        if (ImGui::InputInt3("##Input Midi Message", InitialOutputMidiMessageBuf.data()))
+        {
+            MidiDeviceInitialOutputMidiMessage = GetEditedMidiMessage(InitialOutputMidiMessageBuf);
+        }
 
         ImGui::TableNextColumn();
         static const char Delete[] = "Delete";
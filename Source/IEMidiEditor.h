@@ -21,8 +21,8 @@ public:
     void DrawMidiDeviceProfileEditor(IEMidiDeviceProfile& MidiDeviceProfile) const;
 
 private:
-    void DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDeviceProperty, bool& bDeleteRequested) const;
-    void DrawInitialOutputMessageEditor(std::vector<unsigned char>& MidiDeviceInitialOutputMidiMessage, bool& bDeleteRequested) const;
+    void DrawMidiDevicePropertyEditor(IEMidiDeviceProperty& MidiDeviceProperty, bool& bDeleteRequested, bool& bPropertyChanged) const;
+    void DrawInitialOutputMessageEditor(const std::string& MidiDeviceName, IEMidiMessage& MidiDeviceInitialOutputMidiMessage, bool& bDeleteRequested) const;
 
 private:
     std::shared_ptr<IEMidiProcessor> m_MidiDeviceProcessor;
@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiLatencyMonitor.h"
+
+#include <bit>
+
+void IEMidiLatencyHistogram::Record(uint64_t DurationNs)
+{
+    m_BucketCounts[GetBucketIndex(DurationNs)].fetch_add(1, std::memory_order_relaxed);
+    m_SampleCount.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t MaxNs = m_MaxNs.load(std::memory_order_relaxed);
+    while (DurationNs > MaxNs && !m_MaxNs.compare_exchange_weak(MaxNs, DurationNs, std::memory_order_relaxed));
+}
+
+void IEMidiLatencyHistogram::Reset()
+{
+    for (std::atomic<uint64_t>& BucketCount : m_BucketCounts)
+    {
+        BucketCount.store(0, std::memory_order_relaxed);
+    }
+    m_SampleCount.store(0, std::memory_order_relaxed);
+    m_MaxNs.store(0, std::memory_order_relaxed);
+}
+
+IEMidiLatencySummary IEMidiLatencyHistogram::GetSummary() const
+{
+    IEMidiLatencySummary LatencySummary;
+    LatencySummary.SampleCount = m_SampleCount.load(std::memory_order_relaxed);
+    LatencySummary.MaxNs = m_MaxNs.load(std::memory_order_relaxed);
+
+    if (LatencySummary.SampleCount > 0)
+    {
+        const uint64_t P50Rank = (LatencySummary.SampleCount * 50 + 99) / 100;
+        const uint64_t P99Rank = (LatencySummary.SampleCount * 99 + 99) / 100;
+
+        uint64_t CumulativeCount = 0;
+        for (size_t BucketIndex = 0; BucketIndex < BUCKET_COUNT && CumulativeCount < P99Rank; BucketIndex++)
+        {
+            const uint64_t BucketCount = m_BucketCounts[BucketIndex].load(std::memory_order_relaxed);
+            if (BucketCount > 0)
+            {
+                const uint64_t PreviousCumulativeCount = CumulativeCount;
+                CumulativeCount += BucketCount;
+
+                const uint64_t BucketUpperBoundNs = std::min(GetBucketUpperBoundNs(BucketIndex), LatencySummary.MaxNs);
+                if (PreviousCumulativeCount < P50Rank && CumulativeCount >= P50Rank)
+                {
+                    LatencySummary.P50Ns = BucketUpperBoundNs;
+                }
+                if (CumulativeCount >= P99Rank)
+                {
+                    LatencySummary.P99Ns = BucketUpperBoundNs;
+                }
+            }
+        }
+    }
+    return LatencySummary;
+}
+
+size_t IEMidiLatencyHistogram::GetBucketIndex(uint64_t DurationNs)
+{
+    size_t BucketIndex = 0;
+    if (DurationNs < SUB_BUCKET_COUNT)
+    {
+        BucketIndex = static_cast<size_t>(DurationNs);
+    }
+    else
+    {
+        const size_t MostSignificantBit = std::bit_width(DurationNs) - 1;
+        if (MostSignificantBit >= TRACKABLE_BITS)
+        {
+            BucketIndex = BUCKET_COUNT - 1;
+        }
+        else
+        {
+            const size_t Magnitude = MostSignificantBit - SUB_BUCKET_BITS + 1;
+            const size_t SubBucketIndex = (DurationNs >> (MostSignificantBit - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1);
+            BucketIndex = Magnitude * SUB_BUCKET_COUNT + SubBucketIndex;
+        }
+    }
+    return BucketIndex;
+}
+
+uint64_t IEMidiLatencyHistogram::GetBucketUpperBoundNs(size_t BucketIndex)
+{
+    uint64_t BucketUpperBoundNs = BucketIndex;
+    const size_t Magnitude = BucketIndex / SUB_BUCKET_COUNT;
+    if (Magnitude > 0)
+    {
+        const size_t MostSignificantBit = Magnitude + SUB_BUCKET_BITS - 1;
+        const uint64_t SubBucketIndex = BucketIndex & (SUB_BUCKET_COUNT - 1);
+        const uint64_t BucketLowerBoundNs = (uint64_t(1) << MostSignificantBit) | (SubBucketIndex << (MostSignificantBit - SUB_BUCKET_BITS));
+        BucketUpperBoundNs = BucketLowerBoundNs + (uint64_t(1) << (MostSignificantBit - SUB_BUCKET_BITS)) - 1;
+    }
+    return BucketUpperBoundNs;
+}
+
+void IEMidiLatencyMonitor::RecordLatency(IEMidiActionType MidiActionType, const IEMidiLatencyTimestamps& LatencyTimestamps)
+{
+    const size_t ActionTypeIndex = static_cast<size_t>(MidiActionType);
+    if (ActionTypeIndex < ACTION_TYPE_COUNT)
+    {
+        const auto GetDurationNs = [](IEClock::time_point StartTime, IEClock::time_point EndTime) -> uint64_t
+        {
+            const int64_t DurationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(EndTime - StartTime).count();
+            return DurationNs > 0 ? static_cast<uint64_t>(DurationNs) : 0;
+        };
+
+        std::array<IEMidiLatencyHistogram, STAGE_COUNT>& StageHistograms = m_Histograms[ActionTypeIndex];
+
+        // Tasks that do not originate from a single message (coalesced values) only carry action timestamps
+        if (LatencyTimestamps.ArrivalTime != IEClock::time_point())
+        {
+            StageHistograms[static_cast<size_t>(IEMidiLatencyStage::Dispatch)].Record(GetDurationNs(LatencyTimestamps.ArrivalTime, LatencyTimestamps.DispatchTime));
+            StageHistograms[static_cast<size_t>(IEMidiLatencyStage::Total)].Record(GetDurationNs(LatencyTimestamps.ArrivalTime, LatencyTimestamps.ActionEndTime));
+        }
+        StageHistograms[static_cast<size_t>(IEMidiLatencyStage::Queue)].Record(GetDurationNs(LatencyTimestamps.DispatchTime, LatencyTimestamps.ActionStartTime));
+        StageHistograms[static_cast<size_t>(IEMidiLatencyStage::Execute)].Record(GetDurationNs(LatencyTimestamps.ActionStartTime, LatencyTimestamps.ActionEndTime));
+    }
+}
+
+void IEMidiLatencyMonitor::Reset()
+{
+    for (std::array<IEMidiLatencyHistogram, STAGE_COUNT>& StageHistograms : m_Histograms)
+    {
+        for (IEMidiLatencyHistogram& LatencyHistogram : StageHistograms)
+        {
+            LatencyHistogram.Reset();
+        }
+    }
+}
+
+IEMidiLatencySummary IEMidiLatencyMonitor::GetLatencySummary(IEMidiActionType MidiActionType, IEMidiLatencyStage LatencyStage) const
+{
+    IEMidiLatencySummary LatencySummary;
+
+    const size_t ActionTypeIndex = static_cast<size_t>(MidiActionType);
+    const size_t StageIndex = static_cast<size_t>(LatencyStage);
+    if (ActionTypeIndex < ACTION_TYPE_COUNT && StageIndex < STAGE_COUNT)
+    {
+        LatencySummary = m_Histograms[ActionTypeIndex][StageIndex].GetSummary();
+    }
+    return LatencySummary;
+}
+
+IEResult IEMidiLatencyMonitor::ExportLatencyReport(const std::filesystem::path& ReportFilePath) const
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to export latency report");
+
+    static constexpr const char* ActionTypeNames[ACTION_TYPE_COUNT] = { "None", "Volume", "Mute", "ConsoleCommand", "OpenFile", "Macro" };
+    static constexpr const char* StageNames[STAGE_COUNT] = { "Dispatch", "Queue", "Execute", "Total" };
+
+    if (std::FILE* const ReportFile = std::fopen(ReportFilePath.string().c_str(), "w"))
+    {
+        std::fprintf(ReportFile, "ActionType,Stage,Samples,P50Ns,P99Ns,MaxNs\n");
+        for (size_t ActionTypeIndex = 0; ActionTypeIndex < ACTION_TYPE_COUNT; ActionTypeIndex++)
+        {
+            for (size_t StageIndex = 0; StageIndex < STAGE_COUNT; StageIndex++)
+            {
+                const IEMidiLatencySummary LatencySummary = m_Histograms[ActionTypeIndex][StageIndex].GetSummary();
+                if (LatencySummary.SampleCount > 0)
+                {
+                    std::fprintf(ReportFile, "%s,%s,%llu,%llu,%llu,%llu\n", ActionTypeNames[ActionTypeIndex], StageNames[StageIndex],
+                        static_cast<unsigned long long>(LatencySummary.SampleCount),
+                        static_cast<unsigned long long>(LatencySummary.P50Ns),
+                        static_cast<unsigned long long>(LatencySummary.P99Ns),
+                        static_cast<unsigned long long>(LatencySummary.MaxNs));
+                }
+            }
+        }
+        std::fclose(ReportFile);
+
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Successfully exported latency report to {}", ReportFilePath.string());
+    }
+    return Result;
+}
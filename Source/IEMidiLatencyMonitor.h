@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include "IECore.h"
+
+#include "IEMidiTypes.h"
+
+enum class IEMidiLatencyStage : uint8_t
+{
+    Dispatch,
+    Queue,
+    Execute,
+    Total,
+
+    Count,
+};
+
+struct IEMidiLatencySummary
+{
+public:
+    uint64_t SampleCount = 0;
+    uint64_t P50Ns = 0;
+    uint64_t P99Ns = 0;
+    uint64_t MaxNs = 0;
+};
+
+/*
+* HDR-style histogram of nanosecond durations.
+* Buckets are log-linear, each power of two is split into SUB_BUCKET_COUNT linear buckets,
+* which keeps the relative error of any reported value under 1/SUB_BUCKET_COUNT.
+* Durations past 2^TRACKABLE_BITS ns (~18 minutes) land in the last bucket.
+* Recording is a single relaxed atomic increment and is safe from any thread.
+*/
+class IEMidiLatencyHistogram
+{
+public:
+    void Record(uint64_t DurationNs);
+    void Reset();
+    IEMidiLatencySummary GetSummary() const;
+
+private:
+    static size_t GetBucketIndex(uint64_t DurationNs);
+    static uint64_t GetBucketUpperBoundNs(size_t BucketIndex);
+
+private:
+    static constexpr size_t SUB_BUCKET_BITS = 5;
+    static constexpr size_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr size_t TRACKABLE_BITS = 40;
+    static constexpr size_t MAGNITUDE_COUNT = TRACKABLE_BITS - SUB_BUCKET_BITS + 1;
+    static constexpr size_t BUCKET_COUNT = MAGNITUDE_COUNT * SUB_BUCKET_COUNT;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_BucketCounts = {};
+    std::atomic<uint64_t> m_SampleCount = 0;
+    std::atomic<uint64_t> m_MaxNs = 0;
+};
+
+struct IEMidiLatencyTimestamps
+{
+public:
+    IEClock::time_point ArrivalTime = IEClock::time_point();
+    IEClock::time_point DispatchTime = IEClock::time_point();
+    IEClock::time_point ActionStartTime = IEClock::time_point();
+    IEClock::time_point ActionEndTime = IEClock::time_point();
+};
+
+/*
+* Per action type latency histograms of every stage a message goes through:
+* arrival in the RtMidi callback, dispatch match, action start and action end.
+*/
+class IEMidiLatencyMonitor
+{
+public:
+    void RecordLatency(IEMidiActionType MidiActionType, const IEMidiLatencyTimestamps& LatencyTimestamps);
+    void Reset();
+
+    IEMidiLatencySummary GetLatencySummary(IEMidiActionType MidiActionType, IEMidiLatencyStage LatencyStage) const;
+    IEResult ExportLatencyReport(const std::filesystem::path& ReportFilePath) const;
+
+private:
+    static constexpr size_t ACTION_TYPE_COUNT = static_cast<size_t>(IEMidiActionType::Count);
+    static constexpr size_t STAGE_COUNT = static_cast<size_t>(IEMidiLatencyStage::Count);
+
+private:
+    std::array<std::array<IEMidiLatencyHistogram, STAGE_COUNT>, ACTION_TYPE_COUNT> m_Histograms;
+};
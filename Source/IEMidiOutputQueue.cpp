@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiOutputQueue.h"
+
+#include "IEMidiParser.h"
+
+IEMidiOutputPushResult IEMidiOutputQueue::Push(const IEMidiMessage& MidiMessage, bool bCoalesce)
+{
+    std::scoped_lock OutputQueueLock(m_Mutex);
+    if (bCoalesce)
+    {
+        const std::unordered_map<uint16_t, uint64_t>::const_iterator It = m_PendingItemSequenceNumbers.find(GetMidiOutputAddress(MidiMessage));
+        if (It != m_PendingItemSequenceNumbers.end())
+        {
+            m_Items[It->second - m_FrontSequenceNumber].MidiMessage = MidiMessage;
+            return IEMidiOutputPushResult::Merged;
+        }
+    }
+
+    if (m_Items.size() >= MIDI_OUTPUT_QUEUE_CAPACITY)
+    {
+        return IEMidiOutputPushResult::Dropped;
+    }
+
+    if (bCoalesce)
+    {
+        m_PendingItemSequenceNumbers.emplace(GetMidiOutputAddress(MidiMessage), m_FrontSequenceNumber + m_Items.size());
+    }
+
+    IEMidiOutputItem& MidiOutputItem = m_Items.emplace_back();
+    MidiOutputItem.MidiMessage = MidiMessage;
+    MidiOutputItem.bCoalesced = bCoalesce;
+    return IEMidiOutputPushResult::Queued;
+}
+
+IEMidiOutputPushResult IEMidiOutputQueue::Push(std::span<const unsigned char> SysExMessage)
+{
+    std::scoped_lock OutputQueueLock(m_Mutex);
+    if (m_Items.size() >= MIDI_OUTPUT_QUEUE_CAPACITY)
+    {
+        return IEMidiOutputPushResult::Dropped;
+    }
+
+    IEMidiOutputItem& MidiOutputItem = m_Items.emplace_back();
+    MidiOutputItem.SysExMessage.assign(SysExMessage.begin(), SysExMessage.end());
+    return IEMidiOutputPushResult::Queued;
+}
+
+bool IEMidiOutputQueue::Pop(std::vector<unsigned char>& OutMidiMessage)
+{
+    std::scoped_lock OutputQueueLock(m_Mutex);
+    if (m_Items.empty())
+    {
+        return false;
+    }
+
+    IEMidiOutputItem& MidiOutputItem = m_Items.front();
+    if (MidiOutputItem.SysExMessage.empty())
+    {
+        OutMidiMessage.assign(MidiOutputItem.MidiMessage.begin(), MidiOutputItem.MidiMessage.end());
+    }
+    else
+    {
+        OutMidiMessage.swap(MidiOutputItem.SysExMessage);
+    }
+
+    if (MidiOutputItem.bCoalesced)
+    {
+        m_PendingItemSequenceNumbers.erase(GetMidiOutputAddress(MidiOutputItem.MidiMessage));
+    }
+
+    m_Items.pop_front();
+    m_FrontSequenceNumber++;
+    return true;
+}
+
+bool IEMidiOutputQueue::IsEmpty() const
+{
+    std::scoped_lock OutputQueueLock(m_Mutex);
+    return m_Items.empty();
+}
+
+void IEMidiOutputQueue::Clear()
+{
+    std::scoped_lock OutputQueueLock(m_Mutex);
+    m_FrontSequenceNumber += m_Items.size();
+    m_Items.clear();
+    m_PendingItemSequenceNumbers.clear();
+}
+
+uint16_t IEMidiOutputQueue::GetMidiOutputAddress(const IEMidiMessage& MidiMessage)
+{
+    // Channel pressure and pitch bend carry their value in data1, a newer value replaces an older one of the same channel
+    const unsigned char Address = IEMidiParser::GetStatusInfo(MidiMessage[0]).bHasAddressByte ? MidiMessage[1] : 0;
+    return static_cast<uint16_t>((MidiMessage[0] << 8) | Address);
+}
\ No newline at end of file
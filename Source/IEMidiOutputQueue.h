@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include "IECore.h"
+
+#include "IEMidiTypes.h"
+
+static constexpr size_t MIDI_OUTPUT_QUEUE_CAPACITY = 1024;
+
+enum class IEMidiOutputPushResult : uint8_t
+{
+    Queued,
+    Merged,
+    Dropped,
+};
+
+/*
+* Pending output of one device, drained by the output scheduler at the device's pace.
+* Coalesced messages are keyed by their (status, data1) address: a message whose address is already pending
+* overwrites the pending value in place and keeps its position, so a burst of LED or fader updates collapses to its last value.
+* SysEx and messages pushed without coalescing keep their order. Producers only hold the lock for the push, never for the port.
+*/
+class IEMidiOutputQueue
+{
+public:
+    IEMidiOutputPushResult Push(const IEMidiMessage& MidiMessage, bool bCoalesce);
+    IEMidiOutputPushResult Push(std::span<const unsigned char> SysExMessage);
+    bool Pop(std::vector<unsigned char>& OutMidiMessage);
+    bool IsEmpty() const;
+    void Clear();
+
+private:
+    static uint16_t GetMidiOutputAddress(const IEMidiMessage& MidiMessage);
+
+private:
+    struct IEMidiOutputItem
+    {
+    public:
+        IEMidiMessage MidiMessage;
+        std::vector<unsigned char> SysExMessage;
+        bool bCoalesced = false;
+    };
+
+private:
+    std::deque<IEMidiOutputItem> m_Items;
+    std::unordered_map<uint16_t, uint64_t> m_PendingItemSequenceNumbers;
+    uint64_t m_FrontSequenceNumber = 0;
+    mutable std::mutex m_Mutex;
+};
\ No newline at end of file
@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiParser.h"
+
+static constexpr unsigned char SYSEX_START_STATUS = 0xF0;
+static constexpr unsigned char SYSEX_END_STATUS = 0xF7;
+
+static constexpr std::array<IEMidiStatusInfo, 256> MakeMidiStatusTable()
+{
+    // Kind, data byte count, channel message, real time, address byte
+    constexpr std::array<IEMidiStatusInfo, 7> ChannelStatusInfos =
+    {{
+        { IEMidiMessageKind::NoteOff, 2, true, false, true },
+        { IEMidiMessageKind::NoteOn, 2, true, false, true },
+        { IEMidiMessageKind::PolyPressure, 2, true, false, true },
+        { IEMidiMessageKind::ControlChange, 2, true, false, true },
+        { IEMidiMessageKind::ProgramChange, 1, true, false, true },
+        { IEMidiMessageKind::ChannelPressure, 1, true, false, false },
+        { IEMidiMessageKind::PitchBend, 2, true, false, false },
+    }};
+
+    constexpr std::array<IEMidiStatusInfo, 16> SystemStatusInfos =
+    {{
+        { IEMidiMessageKind::SysEx, 0, false, false, false },
+        { IEMidiMessageKind::TimeCode, 1, false, false, false },
+        { IEMidiMessageKind::SongPosition, 2, false, false, false },
+        { IEMidiMessageKind::SongSelect, 1, false, false, false },
+        { IEMidiMessageKind::Undefined, 0, false, false, false },
+        { IEMidiMessageKind::Undefined, 0, false, false, false },
+        { IEMidiMessageKind::TuneRequest, 0, false, false, false },
+        { IEMidiMessageKind::SysEx, 0, false, false, false },
+        { IEMidiMessageKind::Clock, 0, false, true, false },
+        { IEMidiMessageKind::Undefined, 0, false, true, false },
+        { IEMidiMessageKind::Start, 0, false, true, false },
+        { IEMidiMessageKind::Continue, 0, false, true, false },
+        { IEMidiMessageKind::Stop, 0, false, true, false },
+        { IEMidiMessageKind::Undefined, 0, false, true, false },
+        { IEMidiMessageKind::ActiveSensing, 0, false, true, false },
+        { IEMidiMessageKind::Reset, 0, false, true, false },
+    }};
+
+    std::array<IEMidiStatusInfo, 256> MidiStatusTable = {};
+    for (size_t Status = 0x80; Status < 0xF0; Status++)
+    {
+        MidiStatusTable[Status] = ChannelStatusInfos[(Status >> 4) - 0x8];
+    }
+    for (size_t Status = 0xF0; Status <= 0xFF; Status++)
+    {
+        MidiStatusTable[Status] = SystemStatusInfos[Status - 0xF0];
+    }
+    return MidiStatusTable;
+}
+
+static constexpr std::array<IEMidiStatusInfo, 256> MIDI_STATUS_TABLE = MakeMidiStatusTable();
+
+bool IEMidiParser::Parse(unsigned char Byte, IEMidiParsedMessage& OutParsedMessage)
+{
+    const IEMidiStatusInfo& StatusInfo = MIDI_STATUS_TABLE[Byte];
+    if (StatusInfo.bIsRealTime)
+    {
+        OutParsedMessage.MidiMessageKind = StatusInfo.MidiMessageKind;
+        OutParsedMessage.MidiMessage = IEMidiMessage(std::span<const unsigned char>(&Byte, 1));
+        OutParsedMessage.SysExMessage = std::span<const unsigned char>();
+        OutParsedMessage.bIsSysExTruncated = false;
+        return StatusInfo.MidiMessageKind != IEMidiMessageKind::Undefined;
+    }
+
+    if (StatusInfo.MidiMessageKind == IEMidiMessageKind::None)
+    {
+        if (m_bIsInSysEx)
+        {
+            if (m_SysExSize < m_SysExBuffer.size())
+            {
+                m_SysExBuffer[m_SysExSize++] = Byte;
+            }
+            else
+            {
+                m_bIsSysExTruncated = true;
+            }
+            return false;
+        }
+
+        // Without a status to attach to, e.g. after a system common message, data bytes are dropped
+        if (m_Status == 0)
+        {
+            return false;
+        }
+
+        m_MidiMessage[++m_DataByteCount] = Byte;
+        if (m_DataByteCount < MIDI_STATUS_TABLE[m_Status].DataByteCount)
+        {
+            return false;
+        }
+
+        OutParsedMessage.MidiMessageKind = MIDI_STATUS_TABLE[m_Status].MidiMessageKind;
+        OutParsedMessage.MidiMessage = m_MidiMessage;
+        OutParsedMessage.MidiMessage.Size = static_cast<uint8_t>(m_DataByteCount + 1);
+        OutParsedMessage.SysExMessage = std::span<const unsigned char>();
+        OutParsedMessage.bIsSysExTruncated = false;
+        m_DataByteCount = 0;
+        m_Status = m_RunningStatus;
+        return true;
+    }
+
+    // Any other status byte ends a SysEx, only an end of SysEx completes it
+    if (m_bIsInSysEx)
+    {
+        m_bIsInSysEx = false;
+        if (Byte == SYSEX_END_STATUS)
+        {
+            // A truncated SysEx still ends with its end byte
+            if (m_SysExSize == m_SysExBuffer.size())
+            {
+                m_SysExSize--;
+                m_bIsSysExTruncated = true;
+            }
+            m_SysExBuffer[m_SysExSize++] = Byte;
+
+            OutParsedMessage.MidiMessageKind = IEMidiMessageKind::SysEx;
+            OutParsedMessage.MidiMessage = IEMidiMessage(std::span<const unsigned char>(m_SysExBuffer.data(), m_SysExSize));
+            OutParsedMessage.SysExMessage = std::span<const unsigned char>(m_SysExBuffer.data(), m_SysExSize);
+            OutParsedMessage.bIsSysExTruncated = m_bIsSysExTruncated;
+            return true;
+        }
+    }
+
+    m_DataByteCount = 0;
+    m_RunningStatus = StatusInfo.bIsChannelMessage ? Byte : 0;
+    m_Status = StatusInfo.DataByteCount > 0 ? Byte : 0;
+    m_MidiMessage = IEMidiMessage(Byte, 0, 0);
+
+    if (Byte == SYSEX_START_STATUS)
+    {
+        m_SysExBuffer[0] = Byte;
+        m_SysExSize = 1;
+        m_bIsInSysEx = true;
+        m_bIsSysExTruncated = false;
+        return false;
+    }
+
+    // Tune request is the only complete message without data bytes, a stray end of SysEx or an undefined status only cancels running status
+    if (StatusInfo.MidiMessageKind == IEMidiMessageKind::TuneRequest)
+    {
+        OutParsedMessage.MidiMessageKind = StatusInfo.MidiMessageKind;
+        OutParsedMessage.MidiMessage = IEMidiMessage(std::span<const unsigned char>(&Byte, 1));
+        OutParsedMessage.SysExMessage = std::span<const unsigned char>();
+        OutParsedMessage.bIsSysExTruncated = false;
+        return true;
+    }
+    return false;
+}
+
+void IEMidiParser::Reset()
+{
+    m_Status = 0;
+    m_RunningStatus = 0;
+    m_DataByteCount = 0;
+    m_SysExSize = 0;
+    m_bIsInSysEx = false;
+    m_bIsSysExTruncated = false;
+}
+
+const IEMidiStatusInfo& IEMidiParser::GetStatusInfo(unsigned char Status)
+{
+    return MIDI_STATUS_TABLE[Status];
+}
+
+size_t IEMidiParser::GetMidiMessageSize(unsigned char Status)
+{
+    const IEMidiStatusInfo& StatusInfo = MIDI_STATUS_TABLE[Status];
+    const bool bStartsMessage = StatusInfo.MidiMessageKind != IEMidiMessageKind::None && StatusInfo.MidiMessageKind != IEMidiMessageKind::SysEx &&
+                                StatusInfo.MidiMessageKind != IEMidiMessageKind::Undefined;
+    return bStartsMessage ? StatusInfo.DataByteCount + 1 : 0;
+}
\ No newline at end of file
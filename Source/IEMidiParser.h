@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include "IECore.h"
+
+#include "IEMidiTypes.h"
+
+static constexpr size_t MIDI_SYSEX_BUFFER_BYTE_COUNT = 1024;
+
+/* Every MIDI 1.0 message, channel voice messages first, then system common and system real time */
+enum class IEMidiMessageKind : uint8_t
+{
+    None,
+    NoteOff,
+    NoteOn,
+    PolyPressure,
+    ControlChange,
+    ProgramChange,
+    ChannelPressure,
+    PitchBend,
+    SysEx,
+    TimeCode,
+    SongPosition,
+    SongSelect,
+    TuneRequest,
+    Clock,
+    Start,
+    Continue,
+    Stop,
+    ActiveSensing,
+    Reset,
+    Undefined,
+
+    Count,
+};
+
+/* What a status byte announces, data bytes (0x00-0x7F) map to None */
+struct IEMidiStatusInfo
+{
+public:
+    IEMidiMessageKind MidiMessageKind = IEMidiMessageKind::None;
+    uint8_t DataByteCount = 0;
+    bool bIsChannelMessage = false;
+    bool bIsRealTime = false;
+    /* Channel messages whose first data byte selects a note, controller or program rather than carrying the value */
+    bool bHasAddressByte = false;
+};
+
+/* A complete message, SysEx bytes point into the parser and are only valid until the next byte is parsed */
+struct IEMidiParsedMessage
+{
+public:
+    IEMidiMessageKind MidiMessageKind = IEMidiMessageKind::None;
+    IEMidiMessage MidiMessage;
+    std::span<const unsigned char> SysExMessage;
+    bool bIsSysExTruncated = false;
+};
+
+/*
+* Streaming MIDI 1.0 byte parser driven by a table indexed by status byte.
+* Running status is resolved so every channel message comes out with its status byte, system common messages cancel it
+* and real time bytes are passed through wherever they appear without disturbing the message they interrupt.
+* SysEx is assembled across calls into a fixed buffer, bytes past its capacity are dropped and the message is flagged truncated.
+* The parser never allocates, it is only touched by the RtMidi callback of one session.
+*/
+class IEMidiParser
+{
+public:
+    /* Returns true when Byte completes a message */
+    bool Parse(unsigned char Byte, IEMidiParsedMessage& OutParsedMessage);
+    void Reset();
+
+public:
+    static const IEMidiStatusInfo& GetStatusInfo(unsigned char Status);
+    /* Size of a complete non SysEx message starting with Status, 0 when Status does not start one */
+    static size_t GetMidiMessageSize(unsigned char Status);
+
+private:
+    unsigned char m_Status = 0;
+    unsigned char m_RunningStatus = 0;
+    uint8_t m_DataByteCount = 0;
+    IEMidiMessage m_MidiMessage;
+    std::array<unsigned char, MIDI_SYSEX_BUFFER_BYTE_COUNT> m_SysExBuffer = {};
+    size_t m_SysExSize = 0;
+    bool m_bIsInSysEx = false;
+    bool m_bIsSysExTruncated = false;
+};
\ No newline at end of file
@@ -2,196 +2,401 @@
 // Copyright © Interactive Echoes. All rights reserved.
 // Author: mozahzah
 
+#include <cmath>
+
 #include "IEMidiProcessor.h"
 
-IEResult IEMidiProcessor::ProcessMidiInputMessage(const std::vector<unsigned char>& MidiMessage)
+IEMidiProcessor::~IEMidiProcessor()
+{
+    StopMidiStateFeedback();
+    StopSessionSupervisor();
+
+    // Macros submit actions and queue output, they stop before the sessions they write to
+    {
+        std::scoped_lock MacroSchedulerLock(m_MacroSchedulerMutex);
+        m_bIsMacroSchedulerStopping = true;
+    }
+    m_MacroSchedulerConditionVariable.notify_all();
+    if (m_MacroScheduler.joinable())
+    {
+        m_MacroScheduler.join();
+    }
+
+    DeactivateAllMidiDeviceProfiles();
+
+    {
+        std::scoped_lock CoalescingLock(m_CoalescingMutex);
+        m_bIsCoalescingStopping = true;
+    }
+    m_CoalescingConditionVariable.notify_all();
+    if (m_CoalescingWorker.joinable())
+    {
+        m_CoalescingWorker.join();
+    }
+
+    {
+        std::scoped_lock OutputSchedulerLock(m_OutputSchedulerMutex);
+        m_bIsOutputSchedulerStopping = true;
+    }
+    m_OutputSchedulerConditionVariable.notify_all();
+    if (m_OutputScheduler.joinable())
+    {
+        m_OutputScheduler.join();
+    }
+}
+
+/* Value a message carries for an entry of a given type, triggers read as pressed when it is not zero */
+static int GetMidiInputValue(IEMidiMessageType MidiMessageType, const IEMidiMessage& MidiMessage)
+{
+    switch (MidiMessageType)
+    {
+        case IEMidiMessageType::ProgramChange:
+        {
+            return 127;
+        }
+        case IEMidiMessageType::ChannelPressure:
+        {
+            return MidiMessage[1];
+        }
+        case IEMidiMessageType::PitchBend:
+        {
+            return ((MidiMessage[2] & 0x7F) << 7) | (MidiMessage[1] & 0x7F);
+        }
+        default:
+        {
+            return MidiMessage[2];
+        }
+    }
+}
+
+/* Thresholds are on the 7 most significant bits of a value, a trigger release always passes so a held trigger is never left on */
+static bool IsWithinValueThreshold(const IEMidiDispatchEntry& MidiDispatchEntry, int Value)
+{
+    const int CoarseValue = IEMidiDispatchTable::GetMaxMidiValue(MidiDispatchEntry.MidiMessageType) > 127 ? Value >> 7 : Value;
+    return (CoarseValue >= MidiDispatchEntry.ValueMin && CoarseValue <= MidiDispatchEntry.ValueMax) ||
+           (Value == 0 && IEMidiDispatchTable::IsTriggerMidiMessageType(MidiDispatchEntry.MidiMessageType));
+}
+
+IEResult IEMidiProcessor::ProcessMidiInputMessage(const std::shared_ptr<const IEMidiDispatchTable>& MidiDispatchTable, const IEMidiMessage& MidiMessage,
+                                                  IEClock::time_point ArrivalTime)
 {
     IEResult Result(IEResult::Type::Fail, "Failed to process Midi");
+    bool bDroppedActionTask = false;
 
-    if (IEAssert(MidiMessage.size() >= 3))
+    // Only complete channel messages are bound, system messages only reach the logger
+    const IEMidiStatusInfo& StatusInfo = IEMidiParser::GetStatusInfo(MidiMessage[0]);
+    if (StatusInfo.bIsChannelMessage && MidiMessage.size() > StatusInfo.DataByteCount)
     {
-        if (m_ActiveMidiDeviceProfile.has_value())
+        if (MidiDispatchTable)
         {
-            for (IEMidiDeviceProperty& ActiveMidiDeviceProperty : m_ActiveMidiDeviceProfile->Properties)
+            IEMidiActionExecutor& MidiActionExecutor = GetMidiActionExecutor();
+            const std::span<const uint32_t> EntryIndices = MidiDispatchTable->FindEntryIndices(MidiMessage[0], MidiMessage[1]);
+            const IEClock::time_point DispatchTime = IEClock::now();
+            for (const uint32_t EntryIndex : EntryIndices)
             {
-                if (ActiveMidiDeviceProperty.MidiMessage.size() >= 3 &&
-                    ActiveMidiDeviceProperty.MidiMessage[0] == MidiMessage[0] &&
-                    ActiveMidiDeviceProperty.MidiMessage[1] == MidiMessage[1])
+                const IEMidiDispatchEntry& MidiDispatchEntry = MidiDispatchTable->GetEntry(EntryIndex);
+                if ((MidiDispatchEntry.MidiActionType != IEMidiActionType::Macro && !MidiActionExecutor.HasAction(MidiDispatchEntry.MidiActionType)) ||
+                    IEMidiDispatchTable::IsHighResolutionMidiMessageType(MidiDispatchEntry.MidiMessageType))
+                {
+                    continue;
+                }
+
+                const int Value = GetMidiInputValue(MidiDispatchEntry.MidiMessageType, MidiMessage);
+                if (!IsWithinValueThreshold(MidiDispatchEntry, Value))
+                {
+                    continue;
+                }
+
+                const bool bIsTrigger = IEMidiDispatchTable::IsTriggerMidiMessageType(MidiDispatchEntry.MidiMessageType);
+                const bool bOn = Value != 0;
+                MidiDispatchTable->RecordInputValue(EntryIndex, Value, ArrivalTime);
+
+                Result.Type = IEResult::Type::Success;
+
+                IEMidiActionTask MidiActionTask;
+                MidiActionTask.MidiActionType = MidiDispatchEntry.MidiActionType;
+                bool bSubmitTask = false;
+
+                switch (MidiDispatchEntry.MidiActionType)
                 {
-                    switch (ActiveMidiDeviceProperty.MidiActionType)
+                    case IEMidiActionType::Volume:
+                    {
+                        MidiActionTask.Value = MidiDispatchTable->GetResponseValue(EntryIndex, Value);
+                        bSubmitTask = true;
+                        break;
+                    }
+                    case IEMidiActionType::Mute:
                     {
-                        case IEMidiActionType::Volume:
+                        if (bIsTrigger)
                         {
-                            if (m_VolumeAction)
+                            if (MidiDispatchEntry.bToggle)
                             {
-                                Result.Type = IEResult::Type::Success;
-
-                                const float Value = static_cast<float>(MidiMessage[2]);
-                                m_VolumeAction->SetVolume(Value/127.0f);
+                                MidiActionTask.bToggle = true;
+                                bSubmitTask = bOn;
                             }
-                            break;
-                        }
-                        case IEMidiActionType::Mute:
-                        {
-                            if (m_MuteAction)
+                            else
                             {
-                                Result.Type = IEResult::Type::Success;
-
-                                if (ActiveMidiDeviceProperty.MidiMessageType == IEMidiMessageType::NoteOnOff)
-                                {
-                                    if (ActiveMidiDeviceProperty.bToggle)
-                                    {
-                                        const bool bOn = static_cast<unsigned int>(MidiMessage[2]) != 0;
-                                        if (bOn)
-                                        {
-                                            if (m_MuteAction->GetMute())
-                                            {
-                                                m_MuteAction->SetMute(false);
-                                            }
-                                            else
-                                            {
-                                                m_MuteAction->SetMute(true);
-                                            }
-                                        }
-                                    }
-                                    else
-                                    {
-                                        const bool bMute = static_cast<bool>(MidiMessage[2]);
-                                        m_MuteAction->SetMute(bMute);
-                                    }
-                                }
+                                MidiActionTask.Value = bOn ? 1.0f : 0.0f;
+                                bSubmitTask = true;
                             }
-                            break;
                         }
-                        case IEMidiActionType::ConsoleCommand:
+                        break;
+                    }
+                    case IEMidiActionType::ConsoleCommand:
+                    {
+                        if (bIsTrigger)
                         {
-                            if (m_ConsoleCommandAction)
+                            if (MidiDispatchEntry.bToggle)
                             {
-                                Result.Type = IEResult::Type::Success;
-
-                                switch (ActiveMidiDeviceProperty.MidiMessageType)
+                                if (bOn)
                                 {
-                                    case IEMidiMessageType::NoteOnOff:
-                                    {
-                                        if (ActiveMidiDeviceProperty.bToggle)
-                                        {
-                                            const bool bOn = static_cast<unsigned int>(MidiMessage[2]) != 0;
-                                            if (bOn)
-                                            {
-                                                if (ActiveMidiDeviceProperty.bIsConsoleCommandActive)
-                                                {
-                                                    m_ConsoleCommandAction->ExecuteConsoleCommand(ActiveMidiDeviceProperty.ConsoleCommand, 0.0f);
-                                                    ActiveMidiDeviceProperty.bIsConsoleCommandActive = false;
-                                                }
-                                                else
-                                                {
-                                                    m_ConsoleCommandAction->ExecuteConsoleCommand(ActiveMidiDeviceProperty.ConsoleCommand, 1.0f);
-                                                    ActiveMidiDeviceProperty.bIsConsoleCommandActive = true;
-                                                }
-                                            }
-                                        }
-                                        else
-                                        {
-                                            m_ConsoleCommandAction->ExecuteConsoleCommand(ActiveMidiDeviceProperty.ConsoleCommand, 1.0f);
-                                        }
-                                        break;
-                                    }
-                                    case IEMidiMessageType::ControlChange:
-                                    {
-                                        const float Value = static_cast<float>(MidiMessage[2]);
-                                        m_ConsoleCommandAction->ExecuteConsoleCommand(ActiveMidiDeviceProperty.ConsoleCommand, Value);
-                                        break;
-                                    }
-                                    default:
-                                    {
-                                        break;
-                                    }
+                                    const bool bWasActive = MidiDispatchTable->GetToggleState(EntryIndex);
+                                    MidiDispatchTable->SetToggleState(EntryIndex, !bWasActive);
+                                    MidiActionTask.Value = bWasActive ? 0.0f : 1.0f;
+                                    bSubmitTask = true;
                                 }
                             }
-                            break;
-                        }
-                        case IEMidiActionType::OpenFile:
-                        {
-                            if (m_OpenFileAction)
+                            else
                             {
-                                Result.Type = IEResult::Type::Success;
-
-                                if (ActiveMidiDeviceProperty.MidiMessageType == IEMidiMessageType::NoteOnOff)
-                                {
-                                    const bool bOn = static_cast<unsigned int>(MidiMessage[2]) != 0;
-                                    if (bOn)
-                                    {
-                                        m_OpenFileAction->OpenFile(ActiveMidiDeviceProperty.OpenFilePath);
-                                    }
-                                }
+                                MidiActionTask.Value = 1.0f;
+                                bSubmitTask = true;
                             }
-                            break;
                         }
-                        default:
+                        else if (IEMidiDispatchTable::IsContinuousMidiMessageType(MidiDispatchEntry.MidiMessageType))
+                        {
+                            MidiActionTask.Value = MidiDispatchTable->GetResponseValue(EntryIndex, Value);
+                            bSubmitTask = true;
+                        }
+                        break;
+                    }
+                    case IEMidiActionType::OpenFile:
+                    {
+                        bSubmitTask = bIsTrigger && bOn;
+                        break;
+                    }
+                    case IEMidiActionType::Macro:
+                    {
+                        if (bIsTrigger && bOn)
                         {
-                            break;
+                            bDroppedActionTask |= !PushMidiMacroTrigger(MidiDispatchTable, EntryIndex);
                         }
+                        break;
+                    }
+                    default:
+                    {
+                        break;
                     }
                 }
+
+                if (bSubmitTask)
+                {
+                    bDroppedActionTask |= !SubmitMidiActionTask(MidiDispatchTable, EntryIndex, std::move(MidiActionTask), ArrivalTime, DispatchTime);
+                }
             }
         }
     }
-    if (Result.Type == IEResult::Type::Success)
+    if (bDroppedActionTask)
+    {
+        Result.Type = IEResult::Type::Fail;
+        Result.Message = std::string("Failed to process Midi, action queue is full");
+    }
+    else if (Result.Type == IEResult::Type::Success)
     {
         Result.Message = std::string("Successfully processed Midi");
     }
     return Result;
 }
 
-IEResult IEMidiProcessor::SendMidiOutputMessage(const std::vector<unsigned char>& MidiMessage)
+IEResult IEMidiProcessor::ProcessMidiDecodedControl(const std::shared_ptr<const IEMidiDispatchTable>& MidiDispatchTable, const IEMidiDecodedControl& MidiDecodedControl,
+                                                    IEClock::time_point ArrivalTime)
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to process high resolution Midi");
+    bool bDroppedActionTask = false;
+
+    if (MidiDispatchTable)
+    {
+        IEMidiActionExecutor& MidiActionExecutor = GetMidiActionExecutor();
+        const std::span<const uint32_t> EntryIndices = MidiDecodedControl.MidiMessageType == IEMidiMessageType::HighResControlChange ?
+            MidiDispatchTable->FindEntryIndices(MidiDecodedControl.Status, static_cast<unsigned char>(MidiDecodedControl.Number)) :
+            MidiDispatchTable->FindParameterEntryIndices(MidiDecodedControl.MidiMessageType, MidiDecodedControl.Status, MidiDecodedControl.Number);
+        const IEClock::time_point DispatchTime = IEClock::now();
+        for (const uint32_t EntryIndex : EntryIndices)
+        {
+            const IEMidiDispatchEntry& MidiDispatchEntry = MidiDispatchTable->GetEntry(EntryIndex);
+            if (MidiDispatchEntry.MidiMessageType != MidiDecodedControl.MidiMessageType || !MidiActionExecutor.HasAction(MidiDispatchEntry.MidiActionType) ||
+                !IsWithinValueThreshold(MidiDispatchEntry, MidiDecodedControl.Value))
+            {
+                continue;
+            }
+
+            Result.Type = IEResult::Type::Success;
+            MidiDispatchTable->RecordInputValue(EntryIndex, MidiDecodedControl.Value, ArrivalTime);
+
+            // Values keep the scale of their 7-bit counterparts, volume in [0, 1] and console commands in [0, 128)
+            if (!IEMidiDispatchTable::HasResponseCurve(MidiDispatchEntry.MidiMessageType, MidiDispatchEntry.MidiActionType))
+            {
+                continue;
+            }
+            IEMidiActionTask MidiActionTask;
+            MidiActionTask.MidiActionType = MidiDispatchEntry.MidiActionType;
+            MidiActionTask.Value = MidiDispatchTable->GetResponseValue(EntryIndex, MidiDecodedControl.Value);
+
+            bDroppedActionTask |= !SubmitMidiActionTask(MidiDispatchTable, EntryIndex, std::move(MidiActionTask), ArrivalTime, DispatchTime);
+        }
+    }
+
+    if (bDroppedActionTask)
+    {
+        Result.Type = IEResult::Type::Fail;
+        Result.Message = std::string("Failed to process high resolution Midi, action queue is full");
+    }
+    else if (Result.Type == IEResult::Type::Success)
+    {
+        Result.Message = std::string("Successfully processed high resolution Midi");
+    }
+    return Result;
+}
+
+bool IEMidiProcessor::SubmitMidiActionTask(const std::shared_ptr<const IEMidiDispatchTable>& MidiDispatchTable, uint32_t EntryIndex, IEMidiActionTask&& MidiActionTask,
+                                           IEClock::time_point ArrivalTime, IEClock::time_point DispatchTime)
+{
+    if (MidiDispatchTable->GetEntry(EntryIndex).bCoalesce)
+    {
+        m_CoalescingReceivedCount.fetch_add(1, std::memory_order_relaxed);
+        if (MidiDispatchTable->StoreCoalescedValue(EntryIndex, MidiActionTask.Value))
+        {
+            m_CoalescingMergedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            {
+                std::scoped_lock CoalescingLock(m_CoalescingMutex);
+                m_bHasPendingCoalescedValues = true;
+            }
+            m_CoalescingConditionVariable.notify_one();
+        }
+        return true;
+    }
+
+    MidiActionTask.LatencyTimestamps.ArrivalTime = ArrivalTime;
+    MidiActionTask.LatencyTimestamps.DispatchTime = DispatchTime;
+    MidiActionTask.MidiDispatchTable = MidiDispatchTable;
+    MidiActionTask.EntryIndex = EntryIndex;
+    return GetMidiActionExecutor().SubmitActionTask(std::move(MidiActionTask));
+}
+
+IEResult IEMidiProcessor::SendMidiOutputMessage(const std::string& MidiDeviceName, const IEMidiMessage& MidiMessage, bool bCoalesce)
 {
-    IEResult Result(IEResult::Type::Fail, "Failed to send midi output message");
-    if (IEAssert(MidiMessage.size() >= 3))
+    IEResult Result(IEResult::Type::Fail, "Failed to queue midi output message");
+    const size_t MidiMessageSize = IEMidiParser::GetMidiMessageSize(MidiMessage[0]);
+    if (MidiMessageSize > 0 && MidiMessage.size() >= MidiMessageSize)
     {
-        if (m_ActiveMidiDeviceProfile)
+        const std::shared_ptr<IEMidiDeviceSession> MidiDeviceSession = FindMidiDeviceSession(MidiDeviceName);
+        if (MidiDeviceSession && CountMidiOutputPush(MidiDeviceSession->PushMidiOutputMessage(MidiMessage, bCoalesce)))
         {
-            GetMidiOut().sendMessage(&MidiMessage);
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::string("Successfully queued midi output message");
+        }
+    }
+    return Result;
+}
 
+IEResult IEMidiProcessor::SendMidiSysExMessage(const std::string& MidiDeviceName, std::span<const unsigned char> SysExMessage)
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to queue midi sysex message");
+    if (IEAssert(SysExMessage.size() >= 2 && SysExMessage.front() == 0xF0 && SysExMessage.back() == 0xF7))
+    {
+        const std::shared_ptr<IEMidiDeviceSession> MidiDeviceSession = FindMidiDeviceSession(MidiDeviceName);
+        if (MidiDeviceSession && CountMidiOutputPush(MidiDeviceSession->PushMidiSysExMessage(SysExMessage)))
+        {
             Result.Type = IEResult::Type::Success;
-            Result.Message = std::string("Successfully sent midi output message");
+            Result.Message = std::string("Successfully queued midi sysex message");
         }
     }
     return Result;
 }
 
+IEResult IEMidiProcessor::SendInitialOutputMidiMessages(const std::string& MidiDeviceName)
+{
+    IEResult Result(IEResult::Type::Fail, std::format("Failed to queue initial output messages of midi device {}", MidiDeviceName));
+    const std::shared_ptr<IEMidiDeviceSession> MidiDeviceSession = FindMidiDeviceSession(MidiDeviceName);
+    if (const std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable = MidiDeviceSession ? MidiDeviceSession->GetMidiDispatchTable() : nullptr)
+    {
+        // Initialization sequences may address the same (status, data1) more than once, every message is kept
+        bool bQueuedAll = true;
+        for (const IEMidiMessage& MidiMessage : MidiDispatchTable->GetInitialOutputMidiMessages())
+        {
+            bQueuedAll &= CountMidiOutputPush(MidiDeviceSession->PushMidiOutputMessage(MidiMessage, false));
+        }
+
+        if (bQueuedAll)
+        {
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::format("Successfully queued initial output messages of midi device {}", MidiDeviceName);
+        }
+    }
+    return Result;
+}
+
+IEMidiOutputStats IEMidiProcessor::GetMidiOutputStats() const
+{
+    IEMidiOutputStats MidiOutputStats;
+    MidiOutputStats.QueuedCount = m_MidiOutputQueuedCount.load(std::memory_order_relaxed);
+    MidiOutputStats.MergedCount = m_MidiOutputMergedCount.load(std::memory_order_relaxed);
+    MidiOutputStats.SentCount = m_MidiOutputSentCount.load(std::memory_order_relaxed);
+    MidiOutputStats.DroppedCount = m_MidiOutputDroppedCount.load(std::memory_order_relaxed);
+    return MidiOutputStats;
+}
+
+IEMidiCoalescingStats IEMidiProcessor::GetMidiCoalescingStats() const
+{
+    IEMidiCoalescingStats MidiCoalescingStats;
+    MidiCoalescingStats.ReceivedCount = m_CoalescingReceivedCount.load(std::memory_order_relaxed);
+    MidiCoalescingStats.MergedCount = m_CoalescingMergedCount.load(std::memory_order_relaxed);
+    MidiCoalescingStats.AppliedCount = m_CoalescingAppliedCount.load(std::memory_order_relaxed);
+    return MidiCoalescingStats;
+}
+
 std::vector<std::string> IEMidiProcessor::GetAvailableMidiDevices() const
 {
     std::vector<std::string> AvailableMidiDevices;
-
-    RtMidiIn& MidiIn = GetMidiIn();
-    for (int InputPortNumber = 0; InputPortNumber < MidiIn.getPortCount(); InputPortNumber++)
+    for (IEMidiDeviceEntry& MidiDeviceEntry : GetMidiDeviceRegistry().GetMidiDevices())
     {
-        const std::string MidiDeviceName = GetSanitizedMidiDeviceName(MidiIn.getPortName(InputPortNumber), InputPortNumber);
-        AvailableMidiDevices.emplace_back(MidiDeviceName);
+        AvailableMidiDevices.emplace_back(std::move(MidiDeviceEntry.Name));
     }
     return AvailableMidiDevices;
 }
 
-IEMidiDeviceProfile& IEMidiProcessor::GetActiveMidiDeviceProfile()
+IEMidiDeviceProfile& IEMidiProcessor::GetActiveMidiDeviceProfile(const std::string& MidiDeviceName)
 {
-    if (!m_ActiveMidiDeviceProfile.has_value())
+    const std::shared_ptr<IEMidiDeviceSession> MidiDeviceSession = FindMidiDeviceSession(MidiDeviceName);
+    if (!MidiDeviceSession)
     {
-        IELOG_ERROR("No active midi device profile");
+        IELOG_ERROR("No active midi device profile %s", MidiDeviceName.c_str());
         abort();
     }
 
-    return m_ActiveMidiDeviceProfile.value();
+    return MidiDeviceSession->GetMidiDeviceProfile();
 }
 
-const IEMidiDeviceProfile& IEMidiProcessor::GetActiveMidiDeviceProfile() const
+const IEMidiDeviceProfile& IEMidiProcessor::GetActiveMidiDeviceProfile(const std::string& MidiDeviceName) const
 {
-    if (!m_ActiveMidiDeviceProfile.has_value())
+    const std::shared_ptr<IEMidiDeviceSession> MidiDeviceSession = FindMidiDeviceSession(MidiDeviceName);
+    if (!MidiDeviceSession)
     {
-        IELOG_ERROR("No active midi device profile");
+        IELOG_ERROR("No active midi device profile %s", MidiDeviceName.c_str());
         abort();
     }
 
-    return m_ActiveMidiDeviceProfile.value();
+    return MidiDeviceSession->GetMidiDeviceProfile();
+}
+
+void IEMidiProcessor::RefreshMidiDispatchTable(const std::string& MidiDeviceName)
+{
+    if (const std::shared_ptr<IEMidiDeviceSession> MidiDeviceSession = FindMidiDeviceSession(MidiDeviceName))
+    {
+        MidiDeviceSession->RefreshMidiDispatchTable();
+    }
 }
 
 IEResult IEMidiProcessor::ActivateMidiDeviceProfile(const std::string& MidiDeviceName)
@@ -199,123 +404,820 @@ IEResult IEMidiProcessor::ActivateMidiDeviceProfile(const std::string& MidiDevic
     IEResult Result(IEResult::Type::Fail);
     Result.Message = std::format("Failed to activate midi device profile {}", MidiDeviceName);
 
-    RtMidiIn& MidiIn = GetMidiIn();
-    for (int InputPortNumber = 0; InputPortNumber < MidiIn.getPortCount(); InputPortNumber++)
+    if (HasActiveMidiDeviceProfile(MidiDeviceName))
     {
-        const std::string& MidiDeviceName = GetSanitizedMidiDeviceName(MidiIn.getPortName(InputPortNumber), InputPortNumber);
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Midi device profile {} is already active", MidiDeviceName);
+        return Result;
+    }
 
-        RtMidiOut& MidiOut = GetMidiOut();
-        for (int OutputPortNumber = 0; OutputPortNumber < MidiOut.getPortCount(); OutputPortNumber++)
+    IEMidiDeviceEntry MidiDeviceEntry;
+    if (GetMidiDeviceRegistry().FindMidiDevice(MidiDeviceName, MidiDeviceEntry) && MidiDeviceEntry.OutputPortNumber >= 0)
+    {
+        const IEMidiDeviceProfile MidiDeviceProfile(MidiDeviceName, MidiDeviceEntry.InputPortNumber, MidiDeviceEntry.OutputPortNumber);
+        const std::shared_ptr<IEMidiDeviceSession> MidiDeviceSession = std::make_shared<IEMidiDeviceSession>(*this, MidiDeviceProfile, m_IncomingMidiEventsCapacity);
+        MidiDeviceSession->GetMidiIn().setErrorCallback(&IEMidiProcessor::OnRtMidiErrorCallback);
+        MidiDeviceSession->GetMidiOut().setErrorCallback(&IEMidiProcessor::OnRtMidiErrorCallback);
+
+        if (MidiDeviceSession->OpenPorts(&IEMidiProcessor::OnRtMidiCallback))
         {
-            const std::string& MidiDeviceNameOut = GetSanitizedMidiDeviceName(MidiOut.getPortName(OutputPortNumber), InputPortNumber);
-            if (MidiDeviceNameOut.find(MidiDeviceName) != std::string::npos)
-            {
-                m_ActiveMidiDeviceProfile = IEMidiDeviceProfile(MidiDeviceName, InputPortNumber, OutputPortNumber);
+            std::scoped_lock MidiDeviceSessionsLock(m_MidiDeviceSessionsMutex);
+            m_MidiDeviceSessions.push_back(MidiDeviceSession);
+
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::format("Successfully activated midi device profile {}", MidiDeviceName);
+        }
+    }
+    
+    return Result;
+}
+
+void IEMidiProcessor::DeactivateMidiDeviceProfile(const std::string& MidiDeviceName)
+{
+    std::shared_ptr<IEMidiDeviceSession> MidiDeviceSession;
+    {
+        std::scoped_lock MidiDeviceSessionsLock(m_MidiDeviceSessionsMutex);
+        const std::vector<std::shared_ptr<IEMidiDeviceSession>>::iterator It = std::find_if(m_MidiDeviceSessions.begin(), m_MidiDeviceSessions.end(),
+            [&MidiDeviceName](const std::shared_ptr<IEMidiDeviceSession>& Session) { return Session->GetMidiDeviceProfile().Name == MidiDeviceName; });
+        if (It != m_MidiDeviceSessions.end())
+        {
+            MidiDeviceSession = *It;
+            m_MidiDeviceSessions.erase(It);
+        }
+    }
+
+    if (MidiDeviceSession)
+    {
+        MidiDeviceSession->Deactivate();
+    }
+}
+
+void IEMidiProcessor::DeactivateAllMidiDeviceProfiles()
+{
+    std::vector<std::shared_ptr<IEMidiDeviceSession>> MidiDeviceSessions;
+    {
+        std::scoped_lock MidiDeviceSessionsLock(m_MidiDeviceSessionsMutex);
+        MidiDeviceSessions.swap(m_MidiDeviceSessions);
+    }
+
+    for (const std::shared_ptr<IEMidiDeviceSession>& MidiDeviceSession : MidiDeviceSessions)
+    {
+        MidiDeviceSession->Deactivate();
+    }
+}
+
+bool IEMidiProcessor::HasActiveMidiDeviceProfile(const std::string& MidiDeviceName) const
+{
+    return FindMidiDeviceSession(MidiDeviceName) != nullptr;
+}
 
-                if (MidiIn.isPortOpen())
+std::vector<std::shared_ptr<IEMidiDeviceSession>> IEMidiProcessor::GetMidiDeviceSessions() const
+{
+    std::scoped_lock MidiDeviceSessionsLock(m_MidiDeviceSessionsMutex);
+    return m_MidiDeviceSessions;
+}
+
+std::shared_ptr<IEMidiDeviceSession> IEMidiProcessor::FindMidiDeviceSession(const std::string& MidiDeviceName) const
+{
+    std::scoped_lock MidiDeviceSessionsLock(m_MidiDeviceSessionsMutex);
+    for (const std::shared_ptr<IEMidiDeviceSession>& MidiDeviceSession : m_MidiDeviceSessions)
+    {
+        if (MidiDeviceSession->GetMidiDeviceProfile().Name == MidiDeviceName)
+        {
+            return MidiDeviceSession;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<IEMidiDeviceSession> IEMidiProcessor::FindMidiDeviceSession(uint32_t SessionID) const
+{
+    std::scoped_lock MidiDeviceSessionsLock(m_MidiDeviceSessionsMutex);
+    for (const std::shared_ptr<IEMidiDeviceSession>& MidiDeviceSession : m_MidiDeviceSessions)
+    {
+        if (MidiDeviceSession->GetSessionID() == SessionID)
+        {
+            return MidiDeviceSession;
+        }
+    }
+    return nullptr;
+}
+
+bool IEMidiProcessor::PopIncomingMidiEvent(IEMidiEvent& OutMidiEvent)
+{
+    std::scoped_lock MidiDeviceSessionsLock(m_MidiDeviceSessionsMutex);
+    for (size_t SessionOffset = 0; SessionOffset < m_MidiDeviceSessions.size(); SessionOffset++)
+    {
+        const size_t SessionIndex = (m_NextIncomingMidiSessionIndex + SessionOffset) % m_MidiDeviceSessions.size();
+        if (m_MidiDeviceSessions[SessionIndex]->PopIncomingMidiEvent(OutMidiEvent))
+        {
+            m_NextIncomingMidiSessionIndex = SessionIndex + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t IEMidiProcessor::GetDroppedIncomingMidiEventCount() const
+{
+    uint64_t DroppedIncomingMidiEventCount = 0;
+    for (const std::shared_ptr<IEMidiDeviceSession>& MidiDeviceSession : GetMidiDeviceSessions())
+    {
+        DroppedIncomingMidiEventCount += MidiDeviceSession->GetDroppedIncomingMidiEventCount();
+    }
+    return DroppedIncomingMidiEventCount;
+}
+
+void IEMidiProcessor::SetMidiRecording(const std::string& MidiDeviceName, bool bRecording)
+{
+    if (const std::shared_ptr<IEMidiDeviceSession> MidiDeviceSession = FindMidiDeviceSession(MidiDeviceName))
+    {
+        MidiDeviceSession->SetMidiRecording(bRecording);
+    }
+}
+
+void IEMidiProcessor::OnRtMidiCallback(double TimeStamp, std::vector<unsigned char>* Message, void* UserData)
+{
+    const IEClock::time_point ArrivalTime = IEClock::now();
+    if (Message && UserData)
+    {
+        if (IEMidiDeviceSession* const MidiDeviceSession = reinterpret_cast<IEMidiDeviceSession*>(UserData))
+        {
+            IEMidiProcessor& MidiProcessor = MidiDeviceSession->GetMidiProcessor();
+            const std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable = MidiDeviceSession->GetMidiDispatchTable();
+            IEMidiParser& MidiParser = MidiDeviceSession->GetMidiParser();
+
+            // A callback may carry several messages, or part of a SysEx that continues in the next one
+            IEMidiParsedMessage MidiParsedMessage;
+            for (const unsigned char Byte : *Message)
+            {
+                if (!MidiParser.Parse(Byte, MidiParsedMessage))
                 {
-                    MidiIn.cancelCallback();
-                    MidiIn.closePort();
+                    continue;
                 }
-                MidiIn.setCallback(&IEMidiProcessor::OnRtMidiCallback, this);
-                
-                MidiIn.openPort(m_ActiveMidiDeviceProfile->GetInputPortNumber());
 
-                if (MidiOut.isPortOpen())
+                // Only channel messages can be bound, a system message never completes a recording
+                const bool bIsChannelMessage = IEMidiParser::GetStatusInfo(MidiParsedMessage.MidiMessage[0]).bIsChannelMessage;
+                const bool bIncludeProcess = !(bIsChannelMessage && MidiDeviceSession->ConsumeMidiRecording());
+
+                IEMidiEvent MidiEvent;
+                MidiEvent.TimeStamp = TimeStamp;
+                MidiEvent.MidiMessage = MidiParsedMessage.MidiMessage;
+                MidiEvent.MidiDeviceSessionID = MidiDeviceSession->GetSessionID();
+                MidiEvent.bRecorded = !bIncludeProcess;
+                MidiDeviceSession->PushIncomingMidiEvent(MidiEvent);
+
+                if (bIsChannelMessage && bIncludeProcess)
                 {
-                    MidiOut.closePort();
+                    MidiProcessor.ProcessMidiInputMessage(MidiDispatchTable, MidiParsedMessage.MidiMessage, ArrivalTime);
+
+                    IEMidiDecodedControl MidiDecodedControl;
+                    if (MidiDeviceSession->GetControlChangeDecoder().Decode(MidiParsedMessage.MidiMessage, MidiDecodedControl))
+                    {
+                        MidiProcessor.ProcessMidiDecodedControl(MidiDispatchTable, MidiDecodedControl, ArrivalTime);
+                    }
                 }
-                MidiOut.openPort(m_ActiveMidiDeviceProfile->GetOutputPortNumber());
+            }
+        }
+    }
+}
 
-                for (const std::vector<unsigned char>& MidiMessage : m_ActiveMidiDeviceProfile->InitialOutputMidiMessages)
+void IEMidiProcessor::OnRtMidiErrorCallback(RtMidiError::Type RtMidiErrorType, const std::string& ErrorText, void* UserData)
+{
+    IELOG_ERROR("%s", ErrorText.c_str());
+}
+
+void IEMidiProcessor::RunMidiCoalescing()
+{
+    while (true)
+    {
+        {
+            std::unique_lock CoalescingLock(m_CoalescingMutex);
+            m_CoalescingConditionVariable.wait(CoalescingLock, [this]() { return m_bIsCoalescingStopping || m_bHasPendingCoalescedValues; });
+            if (m_bIsCoalescingStopping)
+            {
+                break;
+            }
+            m_bHasPendingCoalescedValues = false;
+        }
+
+        uint32_t CoalescingRateHz = 1;
+        for (const std::shared_ptr<IEMidiDeviceSession>& MidiDeviceSession : GetMidiDeviceSessions())
+        {
+            if (const std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable = MidiDeviceSession->GetMidiDispatchTable())
+            {
+                if (!MidiDispatchTable->GetCoalescedEntryIndices().empty())
                 {
-                    MidiOut.sendMessage(&MidiMessage);
+                    CoalescingRateHz = std::max(CoalescingRateHz, MidiDispatchTable->GetCoalescingRateHz());
                 }
+            }
+        }
+        const std::chrono::nanoseconds FlushPeriod = std::chrono::nanoseconds(std::nano::den / CoalescingRateHz);
+        FlushCoalescedMidiValues();
 
-                Result.Type = IEResult::Type::Success;
-                Result.Message = std::format("Successfully activated midi device profile {}", MidiDeviceName);
+        // Values arriving during the flush period keep merging into their slot until the next flush
+        std::unique_lock CoalescingLock(m_CoalescingMutex);
+        m_CoalescingConditionVariable.wait_for(CoalescingLock, FlushPeriod, [this]() { return m_bIsCoalescingStopping; });
+    }
+}
 
-                break;
+void IEMidiProcessor::FlushCoalescedMidiValues()
+{
+    IEMidiActionExecutor& MidiActionExecutor = GetMidiActionExecutor();
+    for (const std::shared_ptr<IEMidiDeviceSession>& MidiDeviceSession : GetMidiDeviceSessions())
+    {
+        if (const std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable = MidiDeviceSession->GetMidiDispatchTable())
+        {
+            for (const uint32_t EntryIndex : MidiDispatchTable->GetCoalescedEntryIndices())
+            {
+                IEMidiActionTask MidiActionTask;
+                if (MidiDispatchTable->TakeCoalescedValue(EntryIndex, MidiActionTask.Value))
+                {
+                    MidiActionTask.MidiActionType = MidiDispatchTable->GetEntry(EntryIndex).MidiActionType;
+                    MidiActionTask.MidiDispatchTable = MidiDispatchTable;
+                    MidiActionTask.EntryIndex = EntryIndex;
+                    MidiActionTask.LatencyTimestamps.DispatchTime = IEClock::now();
+                    if (MidiActionExecutor.SubmitActionTask(std::move(MidiActionTask)))
+                    {
+                        m_CoalescingAppliedCount.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
             }
         }
     }
-    
-    return Result;
 }
 
-void IEMidiProcessor::DeactivateMidiDeviceProfile()
+void IEMidiProcessor::StartSessionSupervisor()
 {
-    RtMidiIn& MidiIn = GetMidiIn();
-    if (MidiIn.isPortOpen())
+    if (!m_SessionSupervisor.joinable())
     {
-        MidiIn.closePort();
-        MidiIn.cancelCallback();
+        m_bIsSessionSupervisorStopping.store(false);
+        m_SessionSupervisor = std::thread(&IEMidiProcessor::RunSessionSupervisor, this);
     }
-    
-    RtMidiOut& MidiOut = GetMidiOut();
-    if (MidiOut.isPortOpen())
+}
+
+void IEMidiProcessor::StopSessionSupervisor()
+{
+    m_bIsSessionSupervisorStopping.store(true);
+    GetMidiDeviceRegistry().WakeMidiDevicesChangedWaiters();
+    if (m_SessionSupervisor.joinable())
     {
-        MidiOut.closePort();
+        m_SessionSupervisor.join();
     }
+}
 
-    m_ActiveMidiDeviceProfile.reset();
+IEMidiReconnectStats IEMidiProcessor::GetReconnectStats() const
+{
+    IEMidiReconnectStats ReconnectStats;
+    ReconnectStats.DisconnectCount = m_DisconnectCount.load(std::memory_order_relaxed);
+    ReconnectStats.ReconnectCount = m_ReconnectCount.load(std::memory_order_relaxed);
+    ReconnectStats.FailedReconnectCount = m_FailedReconnectCount.load(std::memory_order_relaxed);
+    ReconnectStats.ReconnectLatencySummary = m_ReconnectLatencyHistogram.GetSummary();
+    return ReconnectStats;
 }
 
-bool IEMidiProcessor::HasActiveMidiDeviceProfile() const
+void IEMidiProcessor::RunSessionSupervisor()
 {
-    return m_ActiveMidiDeviceProfile.has_value();
+    IEMidiDeviceRegistry& MidiDeviceRegistry = GetMidiDeviceRegistry();
+    while (!m_bIsSessionSupervisorStopping.load())
+    {
+        // Read the count before supervising so that a change announced meanwhile wakes the next wait right away
+        const uint64_t ChangeCount = MidiDeviceRegistry.GetChangeCount();
+        SuperviseMidiDeviceSessions();
+
+        // Without announcements the registry only notices changes when read, the wake interval drives its poll
+        MidiDeviceRegistry.WaitForMidiDevicesChanged(ChangeCount, SESSION_SUPERVISOR_WAKE_INTERVAL);
+    }
 }
 
-void IEMidiProcessor::OnRtMidiCallback(double TimeStamp, std::vector<unsigned char>* Message, void* UserData)
+void IEMidiProcessor::SuperviseMidiDeviceSessions()
 {
-    if (Message && UserData)
+    const std::vector<std::shared_ptr<IEMidiDeviceSession>> MidiDeviceSessions = GetMidiDeviceSessions();
+    if (MidiDeviceSessions.empty())
     {
-        const std::vector<unsigned char>& MidiMessage = *Message;
-        if (IEMidiProcessor* const MidiProcessor = reinterpret_cast<IEMidiProcessor*>(UserData))
+        return;
+    }
+
+    IEMidiDeviceRegistry& MidiDeviceRegistry = GetMidiDeviceRegistry();
+    const std::vector<IEMidiDeviceEntry> MidiDevices = MidiDeviceRegistry.GetMidiDevices();
+    for (const std::shared_ptr<IEMidiDeviceSession>& MidiDeviceSession : MidiDeviceSessions)
+    {
+        const std::string& MidiDeviceName = MidiDeviceSession->GetMidiDeviceProfile().Name;
+        const std::vector<IEMidiDeviceEntry>::const_iterator It = std::find_if(MidiDevices.begin(), MidiDevices.end(),
+            [&MidiDeviceName](const IEMidiDeviceEntry& MidiDeviceEntry) { return MidiDeviceEntry.Name == MidiDeviceName; });
+        const bool bIsMidiDevicePresent = It != MidiDevices.end() && It->OutputPortNumber >= 0;
+
+        if (MidiDeviceSession->IsConnected() && !bIsMidiDevicePresent)
         {
-            bool bIncludeProcess = true;
-            if (MidiProcessor->m_ActiveMidiDeviceProfile)
+            MidiDeviceSession->Disconnect();
+            m_DisconnectCount.fetch_add(1, std::memory_order_relaxed);
+            IELOG_ERROR("Midi device %s disconnected, waiting for it to come back", MidiDeviceName.c_str());
+        }
+        else if (!MidiDeviceSession->IsConnected() && bIsMidiDevicePresent)
+        {
+            const IEResult Result = MidiDeviceSession->Reconnect(It->InputPortNumber, It->OutputPortNumber, &IEMidiProcessor::OnRtMidiCallback);
+            if (Result)
             {
-                for (IEMidiDeviceProperty& MidiDeviceProperty : MidiProcessor->m_ActiveMidiDeviceProfile->Properties)
+                // A power cycled device comes back showing nothing, everything it mirrors is sent again
+                SendInitialOutputMidiMessages(MidiDeviceName);
+                if (const std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable = MidiDeviceSession->GetMidiDispatchTable())
                 {
-                    if (MidiDeviceProperty.bIsRecording)
-                    {
-                        MidiDeviceProperty.MidiMessage = MidiMessage;
-                        MidiDeviceProperty.bIsRecording = false;
-                        bIncludeProcess = false;
-                    }
+                    MidiDispatchTable->ResetDeviceValues();
                 }
+                ForceMidiStateFeedback(MidiDeviceSession->GetSessionID());
+
+                const IEClock::time_point DetectionTime = std::max(MidiDeviceRegistry.GetLastChangeTime(), MidiDeviceSession->GetDisconnectTime());
+                const IEClock::duration ReconnectLatency = IEClock::now() - DetectionTime;
+                m_ReconnectLatencyHistogram.Record(static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(ReconnectLatency).count())));
+                m_ReconnectCount.fetch_add(1, std::memory_order_relaxed);
+                IELOG_SUCCESS("Midi device %s reconnected in %.3f ms", MidiDeviceName.c_str(),
+                    std::chrono::duration<double, std::milli>(ReconnectLatency).count());
+            }
+            else
+            {
+                // Ports can be listed before they accept connections, the next wake tries again
+                m_FailedReconnectCount.fetch_add(1, std::memory_order_relaxed);
+                MidiDeviceRegistry.Invalidate();
+            }
+        }
+    }
+}
+
+void IEMidiProcessor::StartMidiStateFeedback()
+{
+    if (!m_StateFeedbackWorker.joinable())
+    {
+        {
+            std::scoped_lock StateFeedbackLock(m_StateFeedbackMutex);
+            m_bIsStateFeedbackStopping = false;
+        }
+        m_StateFeedbackWorker = std::thread(&IEMidiProcessor::RunMidiStateFeedback, this);
+    }
+}
+
+void IEMidiProcessor::StopMidiStateFeedback()
+{
+    {
+        std::scoped_lock StateFeedbackLock(m_StateFeedbackMutex);
+        m_bIsStateFeedbackStopping = true;
+    }
+    m_StateFeedbackConditionVariable.notify_all();
+    if (m_StateFeedbackWorker.joinable())
+    {
+        m_StateFeedbackWorker.join();
+    }
+}
+
+IEMidiFeedbackStats IEMidiProcessor::GetMidiFeedbackStats() const
+{
+    IEMidiFeedbackStats MidiFeedbackStats;
+    MidiFeedbackStats.SentCount = m_FeedbackSentCount.load(std::memory_order_relaxed);
+    MidiFeedbackStats.SuppressedEchoCount = m_FeedbackSuppressedEchoCount.load(std::memory_order_relaxed);
+    return MidiFeedbackStats;
+}
+
+void IEMidiProcessor::RunMidiStateFeedback()
+{
+    // Sessions are only sent feedback from here so the backends and device values are read by one thread
+    std::vector<uint32_t> ForcedSessionIDs;
+    while (true)
+    {
+        for (const std::shared_ptr<IEMidiDeviceSession>& MidiDeviceSession : GetMidiDeviceSessions())
+        {
+            if (MidiDeviceSession->IsConnected())
+            {
+                const bool bForce = std::find(ForcedSessionIDs.begin(), ForcedSessionIDs.end(), MidiDeviceSession->GetSessionID()) != ForcedSessionIDs.end();
+                SendMidiStateFeedback(*MidiDeviceSession, bForce);
             }
+        }
+
+        std::unique_lock StateFeedbackLock(m_StateFeedbackMutex);
+        m_StateFeedbackConditionVariable.wait_for(StateFeedbackLock, MIDI_FEEDBACK_POLL_INTERVAL,
+            [this]() { return m_bIsStateFeedbackStopping || !m_ForcedStateFeedbackSessionIDs.empty(); });
+        if (m_bIsStateFeedbackStopping)
+        {
+            break;
+        }
+        ForcedSessionIDs.clear();
+        ForcedSessionIDs.swap(m_ForcedStateFeedbackSessionIDs);
+    }
+}
+
+void IEMidiProcessor::ForceMidiStateFeedback(uint32_t MidiDeviceSessionID)
+{
+    {
+        std::scoped_lock StateFeedbackLock(m_StateFeedbackMutex);
+        m_ForcedStateFeedbackSessionIDs.push_back(MidiDeviceSessionID);
+    }
+    m_StateFeedbackConditionVariable.notify_all();
+}
+
+void IEMidiProcessor::SendMidiStateFeedback(IEMidiDeviceSession& MidiDeviceSession, bool bForce)
+{
+    const std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable = MidiDeviceSession.GetMidiDispatchTable();
+    if (!MidiDispatchTable)
+    {
+        return;
+    }
+
+    const IEMidiActionExecutor& MidiActionExecutor = GetMidiActionExecutor();
+    const IEClock::time_point Now = IEClock::now();
+    float Volume = -1.0f;
+    int MuteValue = -1;
+    for (uint32_t EntryIndex = 0; EntryIndex < MidiDispatchTable->GetEntryCount(); EntryIndex++)
+    {
+        // The backends are only queried when an entry mirrors them, at most once per pass
+        const IEMidiDispatchEntry& MidiDispatchEntry = MidiDispatchTable->GetEntry(EntryIndex);
+        if (MidiDispatchEntry.bMatchesSeveralControls)
+        {
+            continue;
+        }
 
-            if (MidiProcessor->m_IncomingMidiMessages.size() == INCOMING_MIDI_MESSAGES_SIZE)
+        const int MaxValue = static_cast<int>(IEMidiDispatchTable::GetMaxMidiValue(MidiDispatchEntry.MidiMessageType));
+        int FeedbackValue = -1;
+        if (MidiDispatchEntry.MidiActionType == IEMidiActionType::Volume &&
+            IEMidiDispatchTable::IsContinuousMidiMessageType(MidiDispatchEntry.MidiMessageType) && MidiActionExecutor.HasAction(IEMidiActionType::Volume))
+        {
+            if (Volume < 0.0f)
             {
-                MidiProcessor->m_IncomingMidiMessages.pop_back();
+                Volume = std::clamp(MidiActionExecutor.GetVolume(), 0.0f, 1.0f);
             }
+            FeedbackValue = MidiDispatchTable->FindResponseInputValue(EntryIndex, Volume);
+        }
+        else if (MidiDispatchEntry.MidiActionType == IEMidiActionType::Mute && MidiDispatchEntry.MidiMessageType == IEMidiMessageType::NoteOnOff &&
+                 MidiActionExecutor.HasAction(IEMidiActionType::Mute))
+        {
+            if (MuteValue < 0)
+            {
+                MuteValue = MidiActionExecutor.GetMute() ? 127 : 0;
+            }
+            FeedbackValue = MuteValue;
+        }
+        else if (MidiDispatchEntry.MidiActionType == IEMidiActionType::ConsoleCommand && MidiDispatchEntry.MidiMessageType == IEMidiMessageType::NoteOnOff &&
+                 MidiDispatchEntry.bToggle)
+        {
+            FeedbackValue = MidiDispatchTable->GetToggleState(EntryIndex) ? 127 : 0;
+        }
 
-            MidiProcessor->m_IncomingMidiMessages.push_front(MidiMessage);
+        const int DeviceValue = MidiDispatchTable->GetDeviceValue(EntryIndex);
+        if (FeedbackValue < 0 || FeedbackValue == DeviceValue)
+        {
+            continue;
+        }
 
-            if (bIncludeProcess)
+        if (!bForce)
+        {
+            // A motor fader that is being moved would be pulled back by its own echo, and the volume it set comes back rounded
+            const bool bIsBeingTouched = Now - MidiDispatchTable->GetLastInputTime(EntryIndex) < MIDI_FEEDBACK_ECHO_HOLDOFF;
+            const bool bIsRoundedEcho = MidiDispatchEntry.MidiActionType == IEMidiActionType::Volume && DeviceValue >= 0 &&
+                                        std::abs(FeedbackValue - DeviceValue) <= MIDI_FEEDBACK_VOLUME_TOLERANCE * MaxValue / 127;
+            if (bIsBeingTouched || bIsRoundedEcho)
             {
-                MidiProcessor->ProcessMidiInputMessage(MidiMessage);
+                m_FeedbackSuppressedEchoCount.fetch_add(1, std::memory_order_relaxed);
+                continue;
             }
         }
+
+        if (PushMidiFeedbackValue(MidiDeviceSession, MidiDispatchEntry, FeedbackValue))
+        {
+            MidiDispatchTable->SetDeviceValue(EntryIndex, FeedbackValue);
+            m_FeedbackSentCount.fetch_add(1, std::memory_order_relaxed);
+        }
     }
 }
 
-void IEMidiProcessor::OnRtMidiErrorCallback(RtMidiError::Type RtMidiErrorType, const std::string& ErrorText, void* UserData)
+bool IEMidiProcessor::PushMidiFeedbackValue(IEMidiDeviceSession& MidiDeviceSession, const IEMidiDispatchEntry& MidiDispatchEntry, int FeedbackValue)
 {
-    IELOG_ERROR("%s", ErrorText.c_str());
+    const IEMidiMessage& MidiMessage = MidiDispatchEntry.MidiMessage;
+    const unsigned char ValueMSB = static_cast<unsigned char>((FeedbackValue >> 7) & 0x7F);
+    const unsigned char ValueLSB = static_cast<unsigned char>(FeedbackValue & 0x7F);
+    switch (MidiDispatchEntry.MidiMessageType)
+    {
+        case IEMidiMessageType::HighResControlChange:
+        {
+            // MSB and LSB have their own addresses, a newer pair overwrites both in place and keeps them in order
+            bool bQueued = CountMidiOutputPush(MidiDeviceSession.PushMidiOutputMessage(IEMidiMessage(MidiMessage[0], MidiMessage[1], ValueMSB), true));
+            bQueued &= CountMidiOutputPush(MidiDeviceSession.PushMidiOutputMessage(IEMidiMessage(MidiMessage[0], MidiMessage[1] + 32, ValueLSB), true));
+            return bQueued;
+        }
+        case IEMidiMessageType::NRPN:
+        case IEMidiMessageType::RPN:
+        {
+            // The select and data entry controllers are shared by every parameter, they are never merged with another parameter's sequence
+            const bool bIsNRPN = MidiDispatchEntry.MidiMessageType == IEMidiMessageType::NRPN;
+            bool bQueued = CountMidiOutputPush(MidiDeviceSession.PushMidiOutputMessage(IEMidiMessage(MidiMessage[0], bIsNRPN ? 99 : 101, MidiMessage[1]), false));
+            bQueued &= CountMidiOutputPush(MidiDeviceSession.PushMidiOutputMessage(IEMidiMessage(MidiMessage[0], bIsNRPN ? 98 : 100, MidiMessage[2]), false));
+            bQueued &= CountMidiOutputPush(MidiDeviceSession.PushMidiOutputMessage(IEMidiMessage(MidiMessage[0], 6, ValueMSB), false));
+            bQueued &= CountMidiOutputPush(MidiDeviceSession.PushMidiOutputMessage(IEMidiMessage(MidiMessage[0], 38, ValueLSB), false));
+            return bQueued;
+        }
+        case IEMidiMessageType::ChannelPressure:
+        {
+            return CountMidiOutputPush(MidiDeviceSession.PushMidiOutputMessage(IEMidiMessage(MidiMessage[0], static_cast<unsigned char>(FeedbackValue), 0), true));
+        }
+        case IEMidiMessageType::PitchBend:
+        {
+            return CountMidiOutputPush(MidiDeviceSession.PushMidiOutputMessage(IEMidiMessage(MidiMessage[0], ValueLSB, ValueMSB), true));
+        }
+        default:
+        {
+            return CountMidiOutputPush(MidiDeviceSession.PushMidiOutputMessage(IEMidiMessage(MidiMessage[0], MidiMessage[1], static_cast<unsigned char>(FeedbackValue)), true));
+        }
+    }
 }
 
-std::string IEMidiProcessor::GetSanitizedMidiDeviceName(const std::string& MidiDeviceName, uint32_t InputPortNumber) const
+void IEMidiProcessor::RunMidiOutputScheduler()
 {
-    std::string SanitizedMidiDeviceName = MidiDeviceName;
+    IEClock::time_point NextSendTime = IEClock::time_point::max();
+    while (true)
+    {
+        {
+            std::unique_lock OutputSchedulerLock(m_OutputSchedulerMutex);
+            const auto IsWakeRequested = [this]() { return m_bIsOutputSchedulerStopping || m_bHasPendingMidiOutput; };
+            if (NextSendTime == IEClock::time_point::max())
+            {
+                m_OutputSchedulerConditionVariable.wait(OutputSchedulerLock, IsWakeRequested);
+            }
+            else
+            {
+                m_OutputSchedulerConditionVariable.wait_until(OutputSchedulerLock, NextSendTime, IsWakeRequested);
+            }
 
-    const std::string NumericSuffix = std::to_string(InputPortNumber);
-    const size_t NumericSuffixIndex = MidiDeviceName.find(NumericSuffix);
-    if (NumericSuffixIndex != std::string::npos)
+            if (m_bIsOutputSchedulerStopping)
+            {
+                break;
+            }
+            m_bHasPendingMidiOutput = false;
+        }
+
+        NextSendTime = SendDueMidiOutputMessages();
+    }
+}
+
+IEClock::time_point IEMidiProcessor::SendDueMidiOutputMessages()
+{
+    // One message per device per pass, each device is paced on its own so a slow one never holds back the others
+    IEClock::time_point NextSendTime = IEClock::time_point::max();
+    for (const std::shared_ptr<IEMidiDeviceSession>& MidiDeviceSession : GetMidiDeviceSessions())
+    {
+        IEClock::time_point SessionNextSendTime = IEClock::time_point::max();
+        if (MidiDeviceSession->SendNextMidiOutputMessage(IEClock::now(), SessionNextSendTime))
+        {
+            m_MidiOutputSentCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        NextSendTime = std::min(NextSendTime, SessionNextSendTime);
+    }
+    return NextSendTime;
+}
+
+bool IEMidiProcessor::CountMidiOutputPush(IEMidiOutputPushResult MidiOutputPushResult)
+{
+    switch (MidiOutputPushResult)
+    {
+        case IEMidiOutputPushResult::Queued:
+        {
+            m_MidiOutputQueuedCount.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::scoped_lock OutputSchedulerLock(m_OutputSchedulerMutex);
+                m_bHasPendingMidiOutput = true;
+            }
+            m_OutputSchedulerConditionVariable.notify_one();
+            return true;
+        }
+        case IEMidiOutputPushResult::Merged:
+        {
+            m_MidiOutputMergedCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        default:
+        {
+            m_MidiOutputDroppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+}
+
+IEMidiMacroStats IEMidiProcessor::GetMidiMacroStats() const
+{
+    IEMidiMacroStats MidiMacroStats;
+    MidiMacroStats.StartedCount = m_MacroStartedCount.load(std::memory_order_relaxed);
+    MidiMacroStats.CancelledCount = m_MacroCancelledCount.load(std::memory_order_relaxed);
+    MidiMacroStats.CompletedCount = m_MacroCompletedCount.load(std::memory_order_relaxed);
+    MidiMacroStats.DroppedTriggerCount = m_MacroDroppedTriggerCount.load(std::memory_order_relaxed);
+    return MidiMacroStats;
+}
+
+bool IEMidiProcessor::PushMidiMacroTrigger(const std::shared_ptr<const IEMidiDispatchTable>& MidiDispatchTable, uint32_t EntryIndex)
+{
+    bool bPushed = false;
+    {
+        std::scoped_lock MacroSchedulerLock(m_MacroSchedulerMutex);
+        if (m_PendingMidiMacroTriggers.size() < MIDI_MACRO_TRIGGER_CAPACITY)
+        {
+            IEMidiMacroTrigger& MidiMacroTrigger = m_PendingMidiMacroTriggers.emplace_back();
+            MidiMacroTrigger.MidiDispatchTable = MidiDispatchTable;
+            MidiMacroTrigger.EntryIndex = EntryIndex;
+            bPushed = true;
+        }
+    }
+
+    if (bPushed)
+    {
+        m_MacroSchedulerConditionVariable.notify_one();
+    }
+    else
     {
-        SanitizedMidiDeviceName.erase(NumericSuffixIndex - 1, NumericSuffix.length() + 1);
+        m_MacroDroppedTriggerCount.fetch_add(1, std::memory_order_relaxed);
     }
-    return SanitizedMidiDeviceName;
+    return bPushed;
+}
+
+void IEMidiProcessor::RunMidiMacroScheduler()
+{
+    std::vector<IEMidiMacroTrigger> MidiMacroTriggers;
+    std::vector<uint64_t> ExpiredMidiMacroRunIDs;
+    MidiMacroTriggers.reserve(MIDI_MACRO_TRIGGER_CAPACITY);
+    {
+        std::scoped_lock MacroSchedulerLock(m_MacroSchedulerMutex);
+        m_PendingMidiMacroTriggers.reserve(MIDI_MACRO_TRIGGER_CAPACITY);
+    }
+
+    uint64_t NextWakeTick = std::numeric_limits<uint64_t>::max();
+    while (true)
+    {
+        {
+            std::unique_lock MacroSchedulerLock(m_MacroSchedulerMutex);
+            const auto IsWakeRequested = [this]() { return m_bIsMacroSchedulerStopping || !m_PendingMidiMacroTriggers.empty(); };
+            if (NextWakeTick == std::numeric_limits<uint64_t>::max())
+            {
+                m_MacroSchedulerConditionVariable.wait(MacroSchedulerLock, IsWakeRequested);
+            }
+            else
+            {
+                m_MacroSchedulerConditionVariable.wait_until(MacroSchedulerLock, m_MacroSchedulerStartTime + std::chrono::milliseconds(NextWakeTick), IsWakeRequested);
+            }
+
+            if (m_bIsMacroSchedulerStopping)
+            {
+                break;
+            }
+            MidiMacroTriggers.swap(m_PendingMidiMacroTriggers);
+        }
+
+        // Triggers come after the wheel moved so new runs count from now, a run cancelled by one of them leaves its expired timer unmatched
+        m_MacroTimerWheel.Advance(GetMidiMacroTick(), ExpiredMidiMacroRunIDs);
+        for (const IEMidiMacroTrigger& MidiMacroTrigger : MidiMacroTriggers)
+        {
+            StartOrCancelMidiMacro(MidiMacroTrigger);
+        }
+
+        for (const uint64_t MidiMacroRunID : ExpiredMidiMacroRunIDs)
+        {
+            const std::unordered_map<uint64_t, IEMidiMacroRun>::iterator It = m_MidiMacroRuns.find(MidiMacroRunID);
+            if (It != m_MidiMacroRuns.end() && RunMidiMacroSteps(MidiMacroRunID, It->second))
+            {
+                m_MidiMacroRunIDs.erase(It->second.MidiDispatchTable->GetEntry(It->second.EntryIndex).PropertyRuntimeID);
+                m_MidiMacroRuns.erase(It);
+                m_MacroCompletedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        MidiMacroTriggers.clear();
+        ExpiredMidiMacroRunIDs.clear();
+        NextWakeTick = m_MacroTimerWheel.GetNextWakeTick();
+    }
+}
+
+void IEMidiProcessor::StartOrCancelMidiMacro(const IEMidiMacroTrigger& MidiMacroTrigger)
+{
+    // Runs are tracked per property, a press on a rebuilt table still cancels the run started from the previous one
+    const uint32_t PropertyRuntimeID = MidiMacroTrigger.MidiDispatchTable->GetEntry(MidiMacroTrigger.EntryIndex).PropertyRuntimeID;
+    const std::unordered_map<uint32_t, uint64_t>::iterator It = m_MidiMacroRunIDs.find(PropertyRuntimeID);
+    if (It != m_MidiMacroRunIDs.end())
+    {
+        m_MidiMacroRuns.erase(It->second);
+        m_MidiMacroRunIDs.erase(It);
+        m_MacroCancelledCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const uint64_t MidiMacroRunID = m_NextMidiMacroRunID++;
+    IEMidiMacroRun MidiMacroRun;
+    MidiMacroRun.MidiDispatchTable = MidiMacroTrigger.MidiDispatchTable;
+    MidiMacroRun.EntryIndex = MidiMacroTrigger.EntryIndex;
+    MidiMacroRun.WakeTick = m_MacroTimerWheel.GetCurrentTick();
+    m_MacroStartedCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (RunMidiMacroSteps(MidiMacroRunID, MidiMacroRun))
+    {
+        m_MacroCompletedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        m_MidiMacroRuns.emplace(MidiMacroRunID, std::move(MidiMacroRun));
+        m_MidiMacroRunIDs.emplace(PropertyRuntimeID, MidiMacroRunID);
+    }
+}
+
+bool IEMidiProcessor::RunMidiMacroSteps(uint64_t MidiMacroRunID, IEMidiMacroRun& MidiMacroRun)
+{
+    const std::span<const IEMidiMacroStep> MacroSteps = MidiMacroRun.MidiDispatchTable->GetMacroSteps(MidiMacroRun.EntryIndex);
+    while (MidiMacroRun.StepIndex < MacroSteps.size())
+    {
+        // Wake ticks follow the schedule rather than when the scheduler woke up, a late wake never stretches the macro
+        const IEMidiMacroStep& MacroStep = MacroSteps[MidiMacroRun.StepIndex];
+        uint64_t NextWakeTick = MidiMacroRun.WakeTick;
+        switch (MacroStep.MacroStepType)
+        {
+            case IEMidiMacroStepType::Delay:
+            {
+                NextWakeTick += MacroStep.DurationMs;
+                MidiMacroRun.StepIndex++;
+                break;
+            }
+            case IEMidiMacroStepType::VolumeRamp:
+            {
+                const uint32_t RampStepCount = std::max<uint32_t>((MacroStep.DurationMs + MIDI_MACRO_RAMP_INTERVAL_MS - 1) / MIDI_MACRO_RAMP_INTERVAL_MS, 1);
+                if (!MidiMacroRun.bIsRamping)
+                {
+                    const IEMidiActionExecutor& MidiActionExecutor = GetMidiActionExecutor();
+                    MidiMacroRun.bIsRamping = true;
+                    MidiMacroRun.RampStepIndex = 0;
+                    MidiMacroRun.RampStartTick = MidiMacroRun.WakeTick;
+                    MidiMacroRun.RampStartValue = MidiActionExecutor.HasAction(IEMidiActionType::Volume) ? MidiActionExecutor.GetVolume() : 0.0f;
+                }
+                else
+                {
+                    MidiMacroRun.RampStepIndex++;
+                    const float RampProgress = static_cast<float>(MidiMacroRun.RampStepIndex) / RampStepCount;
+                    SubmitMidiMacroActionTask(MidiMacroRun, IEMidiActionType::Volume, std::lerp(MidiMacroRun.RampStartValue, MacroStep.Value, RampProgress));
+                }
+
+                if (MidiMacroRun.RampStepIndex < RampStepCount)
+                {
+                    NextWakeTick = MidiMacroRun.RampStartTick + static_cast<uint64_t>(MacroStep.DurationMs) * (MidiMacroRun.RampStepIndex + 1) / RampStepCount;
+                }
+                else
+                {
+                    MidiMacroRun.bIsRamping = false;
+                    MidiMacroRun.StepIndex++;
+                }
+                break;
+            }
+            case IEMidiMacroStepType::Volume:
+            {
+                SubmitMidiMacroActionTask(MidiMacroRun, IEMidiActionType::Volume, std::clamp(MacroStep.Value, 0.0f, 1.0f));
+                MidiMacroRun.StepIndex++;
+                break;
+            }
+            case IEMidiMacroStepType::Mute:
+            {
+                SubmitMidiMacroActionTask(MidiMacroRun, IEMidiActionType::Mute, MacroStep.Value != 0.0f ? 1.0f : 0.0f);
+                MidiMacroRun.StepIndex++;
+                break;
+            }
+            case IEMidiMacroStepType::ConsoleCommand:
+            {
+                SubmitMidiMacroActionTask(MidiMacroRun, IEMidiActionType::ConsoleCommand, MacroStep.Value);
+                MidiMacroRun.StepIndex++;
+                break;
+            }
+            case IEMidiMacroStepType::MidiOutput:
+            {
+                SendMidiOutputMessage(MidiMacroRun.MidiDispatchTable->GetMidiDeviceName(), MacroStep.MidiMessage, false);
+                MidiMacroRun.StepIndex++;
+                break;
+            }
+            default:
+            {
+                MidiMacroRun.StepIndex++;
+                break;
+            }
+        }
+
+        MidiMacroRun.WakeTick = NextWakeTick;
+        if (NextWakeTick > m_MacroTimerWheel.GetCurrentTick())
+        {
+            m_MacroTimerWheel.Schedule(NextWakeTick, MidiMacroRunID);
+            return false;
+        }
+    }
+    return true;
+}
+
+void IEMidiProcessor::SubmitMidiMacroActionTask(const IEMidiMacroRun& MidiMacroRun, IEMidiActionType MidiActionType, float Value)
+{
+    IEMidiActionTask MidiActionTask;
+    MidiActionTask.MidiActionType = MidiActionType;
+    MidiActionTask.MidiDispatchTable = MidiMacroRun.MidiDispatchTable;
+    MidiActionTask.EntryIndex = MidiMacroRun.EntryIndex;
+    MidiActionTask.MacroStepIndex = static_cast<int32_t>(MidiMacroRun.StepIndex);
+    MidiActionTask.Value = Value;
+    MidiActionTask.LatencyTimestamps.DispatchTime = IEClock::now();
+    GetMidiActionExecutor().SubmitActionTask(std::move(MidiActionTask));
+}
+
+uint64_t IEMidiProcessor::GetMidiMacroTick() const
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(IEClock::now() - m_MacroSchedulerStartTime).count());
 }
\ No newline at end of file
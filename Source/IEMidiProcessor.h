@@ -9,60 +9,283 @@
 #include "IEActions.h"
 #include "IECore.h"
 
+#include "IEMidiActionExecutor.h"
+#include "IEMidiControlChangeDecoder.h"
+#include "IEMidiDeviceRegistry.h"
+#include "IEMidiDeviceSession.h"
+#include "IEMidiDispatchTable.h"
+#include "IEMidiLatencyMonitor.h"
+#include "IEMidiParser.h"
+#include "IEMidiTimerWheel.h"
 #include "IEMidiTypes.h"
 
-static constexpr size_t INCOMING_MIDI_MESSAGES_SIZE = 20;
+static constexpr size_t DEFAULT_INCOMING_MIDI_EVENTS_CAPACITY = 256;
+static constexpr std::chrono::milliseconds SESSION_SUPERVISOR_WAKE_INTERVAL = std::chrono::milliseconds(250);
+static constexpr std::chrono::milliseconds MIDI_FEEDBACK_POLL_INTERVAL = std::chrono::milliseconds(50);
+static constexpr std::chrono::milliseconds MIDI_FEEDBACK_ECHO_HOLDOFF = std::chrono::milliseconds(300);
+static constexpr int MIDI_FEEDBACK_VOLUME_TOLERANCE = 1;
+static constexpr size_t MIDI_MACRO_TRIGGER_CAPACITY = 64;
+static constexpr uint32_t MIDI_MACRO_RAMP_INTERVAL_MS = 20;
+
+struct IEMidiCoalescingStats
+{
+public:
+    uint64_t ReceivedCount = 0;
+    uint64_t MergedCount = 0;
+    uint64_t AppliedCount = 0;
+};
+
+struct IEMidiOutputStats
+{
+public:
+    uint64_t QueuedCount = 0;
+    uint64_t MergedCount = 0;
+    uint64_t SentCount = 0;
+    uint64_t DroppedCount = 0;
+};
+
+struct IEMidiFeedbackStats
+{
+public:
+    uint64_t SentCount = 0;
+    uint64_t SuppressedEchoCount = 0;
+};
+
+struct IEMidiMacroStats
+{
+public:
+    uint64_t StartedCount = 0;
+    uint64_t CancelledCount = 0;
+    uint64_t CompletedCount = 0;
+    uint64_t DroppedTriggerCount = 0;
+};
+
+/* Reconnect latency runs from the port announcement, or the disconnect when it came later, to the reopened ports */
+struct IEMidiReconnectStats
+{
+public:
+    uint64_t DisconnectCount = 0;
+    uint64_t ReconnectCount = 0;
+    uint64_t FailedReconnectCount = 0;
+    IEMidiLatencySummary ReconnectLatencySummary;
+};
 
 class IEMidiProcessor
 {
 public:
-    IEMidiProcessor() :
+    IEMidiProcessor(size_t IncomingMidiEventsCapacity = DEFAULT_INCOMING_MIDI_EVENTS_CAPACITY,
+                    std::unique_ptr<IEMidiActionExecutor> MidiActionExecutor = nullptr) :
         m_MidiIn(std::make_unique<RtMidiIn>()),
         m_MidiOut(std::make_unique<RtMidiOut>()),
-        m_VolumeAction(IEAction::GetVolumeAction()),
-        m_MuteAction(IEAction::GetMuteAction()),
-        m_ConsoleCommandAction(IEAction::GetConsoleCommandAction()),
-        m_OpenFileAction(IEAction::GetOpenFileAction())
+        m_MidiDeviceRegistry(std::make_unique<IEMidiDeviceRegistry>(*m_MidiIn, *m_MidiOut)),
+        m_IncomingMidiEventsCapacity(IncomingMidiEventsCapacity),
+        m_MidiActionExecutor(MidiActionExecutor ? std::move(MidiActionExecutor) :
+                                                  std::make_unique<IEMidiActionExecutor>(IEAction::GetVolumeAction(),
+                                                                                         IEAction::GetMuteAction(),
+                                                                                         IEAction::GetConsoleCommandAction(),
+                                                                                         IEAction::GetOpenFileAction()))
     {
         m_MidiIn->setErrorCallback(&IEMidiProcessor::OnRtMidiErrorCallback);
         m_MidiOut->setErrorCallback(&IEMidiProcessor::OnRtMidiErrorCallback);
-        m_IncomingMidiMessages.resize(INCOMING_MIDI_MESSAGES_SIZE);
+        m_CoalescingWorker = std::thread(&IEMidiProcessor::RunMidiCoalescing, this);
+        m_OutputScheduler = std::thread(&IEMidiProcessor::RunMidiOutputScheduler, this);
+        m_MacroScheduler = std::thread(&IEMidiProcessor::RunMidiMacroScheduler, this);
     };
+    ~IEMidiProcessor();
 
 public:
+    /* Ports used for enumeration only, each session opens its own */
     RtMidiIn& GetMidiIn() const { return *m_MidiIn; }
     RtMidiOut& GetMidiOut() const { return *m_MidiOut; }
+    IEMidiDeviceRegistry& GetMidiDeviceRegistry() const { return *m_MidiDeviceRegistry; }
+    IEMidiActionExecutor& GetMidiActionExecutor() const { return *m_MidiActionExecutor; }
     
 public:
-    IEResult ProcessMidiInputMessage(const std::vector<unsigned char>& MidiMessage);
-    IEResult SendMidiOutputMessage(const std::vector<unsigned char>& MidiMessage);
+    IEResult ProcessMidiInputMessage(const std::shared_ptr<const IEMidiDispatchTable>& MidiDispatchTable, const IEMidiMessage& MidiMessage,
+                                     IEClock::time_point ArrivalTime = IEClock::now());
+    /* 14-bit controls assembled by a session's decoder, dispatched to HighResControlChange, NRPN and RPN entries */
+    IEResult ProcessMidiDecodedControl(const std::shared_ptr<const IEMidiDispatchTable>& MidiDispatchTable, const IEMidiDecodedControl& MidiDecodedControl,
+                                       IEClock::time_point ArrivalTime = IEClock::now());
+
+    /*
+    * Output is queued and written by the output scheduler at the pace of the device's Output Rate Hz, callers never wait on the port.
+    * Coalesced messages only keep the last pending value of their (status, data1) address.
+    */
+    IEResult SendMidiOutputMessage(const std::string& MidiDeviceName, const IEMidiMessage& MidiMessage, bool bCoalesce = true);
+    IEResult SendMidiSysExMessage(const std::string& MidiDeviceName, std::span<const unsigned char> SysExMessage);
+    IEResult SendInitialOutputMidiMessages(const std::string& MidiDeviceName);
+    IEMidiOutputStats GetMidiOutputStats() const;
 
+    /* Read from the device registry, ports are only enumerated again once they changed */
     std::vector<std::string> GetAvailableMidiDevices() const;
     IEResult ActivateMidiDeviceProfile(const std::string& MidiDeviceName);
-    void DeactivateMidiDeviceProfile();
-    bool HasActiveMidiDeviceProfile() const;
-    IEMidiDeviceProfile& GetActiveMidiDeviceProfile();
-    const IEMidiDeviceProfile& GetActiveMidiDeviceProfile() const;
-    const std::deque<std::vector<unsigned char>>& GetIncomingMidiMessages() const { return m_IncomingMidiMessages; }
+    void DeactivateMidiDeviceProfile(const std::string& MidiDeviceName);
+    void DeactivateAllMidiDeviceProfiles();
+    bool HasActiveMidiDeviceProfile(const std::string& MidiDeviceName) const;
+    IEMidiDeviceProfile& GetActiveMidiDeviceProfile(const std::string& MidiDeviceName);
+    const IEMidiDeviceProfile& GetActiveMidiDeviceProfile(const std::string& MidiDeviceName) const;
+    void RefreshMidiDispatchTable(const std::string& MidiDeviceName);
+
+    /* Active sessions, added and removed from the UI thread only */
+    std::vector<std::shared_ptr<IEMidiDeviceSession>> GetMidiDeviceSessions() const;
+    std::shared_ptr<IEMidiDeviceSession> FindMidiDeviceSession(const std::string& MidiDeviceName) const;
+    std::shared_ptr<IEMidiDeviceSession> FindMidiDeviceSession(uint32_t SessionID) const;
+
+    /* Consumer side of every session's incoming event ring, must only be called from a single thread */
+    bool PopIncomingMidiEvent(IEMidiEvent& OutMidiEvent);
+    uint64_t GetDroppedIncomingMidiEventCount() const;
+
+    IEMidiCoalescingStats GetMidiCoalescingStats() const;
+
+    /* The next incoming message of the device is flagged as recorded instead of being processed */
+    void SetMidiRecording(const std::string& MidiDeviceName, bool bRecording);
+
+    /*
+    * Active sessions outlive their device: when it is unplugged the session is disconnected and when it comes back
+    * the same session, with its dispatch table and toggle states, reopens the ports and sends its state back out.
+    */
+    void StartSessionSupervisor();
+    void StopSessionSupervisor();
+    IEMidiReconnectStats GetReconnectStats() const;
+
+    /*
+    * Mirrors volume, mute and console command toggle state back to the bound controls, so LEDs and motor faders follow changes
+    * made outside the device. The backends are polled and only values that differ from what the device shows are sent.
+    * A control that received input within the echo holdoff is left alone, and a volume within one step of the fader is not sent back.
+    */
+    void StartMidiStateFeedback();
+    void StopMidiStateFeedback();
+    IEMidiFeedbackStats GetMidiFeedbackStats() const;
+
+    /*
+    * Macro entries start their steps on a press and a second press while they run cancels them, any number of macros run at once.
+    * Steps are run by the macro scheduler, delays and volume ramps wait on a millisecond timer wheel instead of a sleeping thread.
+    */
+    IEMidiMacroStats GetMidiMacroStats() const;
+
+private:
+    struct IEMidiMacroTrigger
+    {
+    public:
+        std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable;
+        uint32_t EntryIndex = 0;
+    };
+
+    struct IEMidiMacroRun
+    {
+    public:
+        std::shared_ptr<const IEMidiDispatchTable> MidiDispatchTable;
+        uint32_t EntryIndex = 0;
+        uint32_t StepIndex = 0;
+        uint64_t WakeTick = 0;
+        bool bIsRamping = false;
+        uint32_t RampStepIndex = 0;
+        uint64_t RampStartTick = 0;
+        float RampStartValue = 0.0f;
+    };
 
 private:
     static void OnRtMidiCallback(double TimeStamp, std::vector<unsigned char>* Message, void* UserData);
     static void OnRtMidiErrorCallback(RtMidiError::Type RtMidiErrorType, const std::string& ErrorText, void* UserData);
 
 private:
-    std::string GetSanitizedMidiDeviceName(const std::string& MidiDeviceName, uint32_t InputPortNumber) const;
+    bool SubmitMidiActionTask(const std::shared_ptr<const IEMidiDispatchTable>& MidiDispatchTable, uint32_t EntryIndex, IEMidiActionTask&& MidiActionTask,
+                              IEClock::time_point ArrivalTime, IEClock::time_point DispatchTime);
+
+private:
+    void RunMidiCoalescing();
+    void FlushCoalescedMidiValues();
+
+private:
+    void RunSessionSupervisor();
+    void SuperviseMidiDeviceSessions();
+    void RunMidiStateFeedback();
+    /* Has the feedback worker send every mirrored value of the session on its next pass, echo suppression aside */
+    void ForceMidiStateFeedback(uint32_t MidiDeviceSessionID);
+    void SendMidiStateFeedback(IEMidiDeviceSession& MidiDeviceSession, bool bForce);
+    bool PushMidiFeedbackValue(IEMidiDeviceSession& MidiDeviceSession, const IEMidiDispatchEntry& MidiDispatchEntry, int FeedbackValue);
+
+private:
+    void RunMidiOutputScheduler();
+    IEClock::time_point SendDueMidiOutputMessages();
+    bool CountMidiOutputPush(IEMidiOutputPushResult MidiOutputPushResult);
+
+private:
+    bool PushMidiMacroTrigger(const std::shared_ptr<const IEMidiDispatchTable>& MidiDispatchTable, uint32_t EntryIndex);
+    void RunMidiMacroScheduler();
+    void StartOrCancelMidiMacro(const IEMidiMacroTrigger& MidiMacroTrigger);
+    bool RunMidiMacroSteps(uint64_t MidiMacroRunID, IEMidiMacroRun& MidiMacroRun);
+    void SubmitMidiMacroActionTask(const IEMidiMacroRun& MidiMacroRun, IEMidiActionType MidiActionType, float Value);
+    uint64_t GetMidiMacroTick() const;
 
 private:
     std::unique_ptr<RtMidiIn> m_MidiIn;
     std::unique_ptr<RtMidiOut> m_MidiOut;
+    std::unique_ptr<IEMidiDeviceRegistry> m_MidiDeviceRegistry;
+
+private:
+    std::vector<std::shared_ptr<IEMidiDeviceSession>> m_MidiDeviceSessions;
+    mutable std::mutex m_MidiDeviceSessionsMutex;
+    size_t m_IncomingMidiEventsCapacity = DEFAULT_INCOMING_MIDI_EVENTS_CAPACITY;
+    size_t m_NextIncomingMidiSessionIndex = 0;
+
+private:
+    std::unique_ptr<IEMidiActionExecutor> m_MidiActionExecutor;
+
+private:
+    std::thread m_CoalescingWorker;
+    std::mutex m_CoalescingMutex;
+    std::condition_variable m_CoalescingConditionVariable;
+    bool m_bHasPendingCoalescedValues = false;
+    bool m_bIsCoalescingStopping = false;
+    std::atomic<uint64_t> m_CoalescingReceivedCount = 0;
+    std::atomic<uint64_t> m_CoalescingMergedCount = 0;
+    std::atomic<uint64_t> m_CoalescingAppliedCount = 0;
+
+private:
+    std::thread m_SessionSupervisor;
+    std::atomic<bool> m_bIsSessionSupervisorStopping = false;
+    std::atomic<uint64_t> m_DisconnectCount = 0;
+    std::atomic<uint64_t> m_ReconnectCount = 0;
+    std::atomic<uint64_t> m_FailedReconnectCount = 0;
+    IEMidiLatencyHistogram m_ReconnectLatencyHistogram;
+
+private:
+    std::thread m_StateFeedbackWorker;
+    std::mutex m_StateFeedbackMutex;
+    std::condition_variable m_StateFeedbackConditionVariable;
+    bool m_bIsStateFeedbackStopping = false;
+    std::vector<uint32_t> m_ForcedStateFeedbackSessionIDs;
+    std::atomic<uint64_t> m_FeedbackSentCount = 0;
+    std::atomic<uint64_t> m_FeedbackSuppressedEchoCount = 0;
+
+private:
+    std::thread m_OutputScheduler;
+    std::mutex m_OutputSchedulerMutex;
+    std::condition_variable m_OutputSchedulerConditionVariable;
+    bool m_bHasPendingMidiOutput = false;
+    bool m_bIsOutputSchedulerStopping = false;
+    std::atomic<uint64_t> m_MidiOutputQueuedCount = 0;
+    std::atomic<uint64_t> m_MidiOutputMergedCount = 0;
+    std::atomic<uint64_t> m_MidiOutputSentCount = 0;
+    std::atomic<uint64_t> m_MidiOutputDroppedCount = 0;
 
 private:
-    std::optional<IEMidiDeviceProfile> m_ActiveMidiDeviceProfile;
-    std::deque<std::vector<unsigned char>> m_IncomingMidiMessages;
+    std::thread m_MacroScheduler;
+    std::mutex m_MacroSchedulerMutex;
+    std::condition_variable m_MacroSchedulerConditionVariable;
+    std::vector<IEMidiMacroTrigger> m_PendingMidiMacroTriggers;
+    bool m_bIsMacroSchedulerStopping = false;
+    std::atomic<uint64_t> m_MacroStartedCount = 0;
+    std::atomic<uint64_t> m_MacroCancelledCount = 0;
+    std::atomic<uint64_t> m_MacroCompletedCount = 0;
+    std::atomic<uint64_t> m_MacroDroppedTriggerCount = 0;
 
 private:
-    std::unique_ptr<IEAction_Volume> m_VolumeAction;
-    std::unique_ptr<IEAction_Mute> m_MuteAction;
-    std::unique_ptr<IEAction_ConsoleCommand> m_ConsoleCommandAction;
-    std::unique_ptr<IEAction_OpenFile> m_OpenFileAction;
+    /* Owned by the macro scheduler thread, runs are keyed by a never reused ID so a timer left behind by a cancelled run finds nothing */
+    IEMidiTimerWheel m_MacroTimerWheel;
+    std::unordered_map<uint64_t, IEMidiMacroRun> m_MidiMacroRuns;
+    std::unordered_map<uint32_t, uint64_t> m_MidiMacroRunIDs;
+    uint64_t m_NextMidiMacroRunID = 1;
+    const IEClock::time_point m_MacroSchedulerStartTime = IEClock::now();
 };
\ No newline at end of file
@@ -4,296 +4,1378 @@
 
 #include "IEMidiProfileManager.h"
 
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
 #include "ryml.hpp"
 #include "ryml_std.hpp"
 
 uint32_t IEMidiDeviceProperty::MidiDevicePropertyIDGenerator = 0;
 
 static constexpr char IEMIDI_PROFILES_FILENAME[] = "profiles.yaml";
+static constexpr char IEMIDI_PROFILE_SNAPSHOT_FILENAME[] = "profiles.bin";
+static constexpr char IEMIDI_PROFILE_SHARDS_FOLDER_NAME[] = "profiles";
+static constexpr char IEMIDI_PROFILE_INDEX_FILENAME[] = "index.yaml";
+static constexpr char IEMIDI_PROFILE_INDEX_LOCK_FILENAME[] = "index.lock";
+static constexpr char YAML_FILE_EXTENSION[] = ".yaml";
+static constexpr char TEMP_FILE_EXTENSION[] = ".tmp";
+static constexpr char MIDI_PROFILE_SHARD_FILE_KEY_NAME[] = "File";
+static constexpr char MIDI_PROFILE_HASH_KEY_NAME[] = "Hash";
 static constexpr char MIDI_PROFILE_PROPERTIES_NODE_NAME[] = "Properties";
 static constexpr char MIDI_MESSAGE_TYPE_KEY_NAME[] = "Midi Message Type";
 static constexpr char MIDI_TOGGLE_KEY_NAME[] = "Toogle";
+static constexpr char MIDI_COALESCE_KEY_NAME[] = "Coalesce";
 static constexpr char MIDI_ACTION_TYPE_KEY_NAME[] = "Midi Action Type";
 static constexpr char CONSOLE_COMMAND_KEY_NAME[] = "Console Command";
 static constexpr char OPEN_FILE_PATH_KEY_NAME[] = "Open File Path";
 static constexpr char MIDI_MESSAGE_KEY_NAME[] = "Midi Message";
+static constexpr char RESPONSE_CURVE_KEY_NAME[] = "Response Curve";
+static constexpr char INVERT_RESPONSE_KEY_NAME[] = "Invert Response";
+static constexpr char RESPONSE_MIN_KEY_NAME[] = "Response Min";
+static constexpr char RESPONSE_MAX_KEY_NAME[] = "Response Max";
+static constexpr char RESPONSE_BREAKPOINTS_KEY_NAME[] = "Response Breakpoints";
+static constexpr char ANY_CHANNEL_KEY_NAME[] = "Any Channel";
+static constexpr char DATA1_RANGE_END_KEY_NAME[] = "Data1 Range End";
+static constexpr char VALUE_MIN_KEY_NAME[] = "Value Min";
+static constexpr char VALUE_MAX_KEY_NAME[] = "Value Max";
+static constexpr char MACRO_STEPS_KEY_NAME[] = "Macro Steps";
+static constexpr char PERSISTENT_CONSOLE_COMMAND_KEY_NAME[] = "Persistent Console Command";
+static constexpr char CONSOLE_COMMAND_WORKER_COUNT_KEY_NAME[] = "Console Command Worker Count";
+static constexpr char CONSOLE_COMMAND_QUEUE_DEPTH_KEY_NAME[] = "Console Command Queue Depth";
+static constexpr char MACRO_STEP_TYPE_KEY_NAME[] = "Step Type";
+static constexpr char MACRO_STEP_VALUE_KEY_NAME[] = "Value";
+static constexpr char MACRO_STEP_DURATION_MS_KEY_NAME[] = "Duration Ms";
 static constexpr char INITIAL_OUTPUT_MIDI_MESSAGES_KEY_NAME[] = "Initial Output Midi Messages";
+static constexpr char COALESCE_CONTROL_CHANGES_KEY_NAME[] = "Coalesce Control Changes";
+static constexpr char COALESCING_RATE_HZ_KEY_NAME[] = "Coalescing Rate Hz";
+static constexpr char OUTPUT_RATE_HZ_KEY_NAME[] = "Output Rate Hz";
 
 static constexpr uint32_t INITIAL_TREE_NODE_COUNT = 30;
 static constexpr uint32_t INITIAL_TREE_ARENA_CHAR_COUNT = 2048;
+static constexpr size_t MAX_SHARD_FILE_STEM_LENGTH = 48;
+
+static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+static constexpr int PROFILES_WATCHER_POLL_TIMEOUT_MS = 250;
+static constexpr std::chrono::milliseconds PROFILES_WATCHER_SETTLE_DURATION = std::chrono::milliseconds(50);
+
+struct IEMidiProfileManager::IEMidiProfilesDocument
+{
+public:
+    ryml::Tree MidiProfilesTree;
+};
+
+static void write(ryml::NodeRef* MidiMessageNode, const IEMidiMessage& MidiMessage)
+{
+    *MidiMessageNode |= ryml::SEQ;
+    for (const unsigned char Byte : MidiMessage)
+    {
+        MidiMessageNode->append_child() << Byte;
+    }
+}
+
+static bool read(const ryml::ConstNodeRef& MidiMessageNode, IEMidiMessage* MidiMessage)
+{
+    *MidiMessage = IEMidiMessage();
+    MidiMessage->Size = static_cast<uint8_t>(std::min<size_t>(MidiMessageNode.num_children(), MIDI_MESSAGE_BYTE_COUNT));
+    for (int ChildPos = 0; ChildPos < MidiMessage->Size; ChildPos++)
+    {
+        MidiMessageNode.at(ChildPos) >> MidiMessage->Bytes[ChildPos];
+    }
+    return true;
+}
+
+static void write(ryml::NodeRef* ResponseBreakpointNode, const IEMidiResponseBreakpoint& ResponseBreakpoint)
+{
+    *ResponseBreakpointNode |= ryml::SEQ;
+    ResponseBreakpointNode->append_child() << ResponseBreakpoint.Input;
+    ResponseBreakpointNode->append_child() << ResponseBreakpoint.Output;
+}
+
+static bool read(const ryml::ConstNodeRef& ResponseBreakpointNode, IEMidiResponseBreakpoint* ResponseBreakpoint)
+{
+    *ResponseBreakpoint = IEMidiResponseBreakpoint();
+    if (ResponseBreakpointNode.num_children() >= 2)
+    {
+        ResponseBreakpointNode.at(0) >> ResponseBreakpoint->Input;
+        ResponseBreakpointNode.at(1) >> ResponseBreakpoint->Output;
+    }
+    return true;
+}
+
+static void write(ryml::NodeRef* MacroStepNode, const IEMidiMacroStep& MacroStep)
+{
+    *MacroStepNode |= ryml::MAP;
+    (*MacroStepNode)[MACRO_STEP_TYPE_KEY_NAME] << static_cast<uint8_t>(MacroStep.MacroStepType);
+    (*MacroStepNode)[MACRO_STEP_VALUE_KEY_NAME] << MacroStep.Value;
+    (*MacroStepNode)[MACRO_STEP_DURATION_MS_KEY_NAME] << MacroStep.DurationMs;
+    (*MacroStepNode)[CONSOLE_COMMAND_KEY_NAME] << MacroStep.ConsoleCommand;
+    (*MacroStepNode)[MIDI_MESSAGE_KEY_NAME] << MacroStep.MidiMessage;
+}
+
+static bool read(const ryml::ConstNodeRef& MacroStepNode, IEMidiMacroStep* MacroStep)
+{
+    *MacroStep = IEMidiMacroStep();
+    if (MacroStepNode.has_child(MACRO_STEP_TYPE_KEY_NAME))
+    {
+        uint8_t MacroStepType = 0;
+        MacroStepNode[MACRO_STEP_TYPE_KEY_NAME] >> MacroStepType;
+        MacroStep->MacroStepType = MacroStepType < static_cast<uint8_t>(IEMidiMacroStepType::Count) ?
+                                   static_cast<IEMidiMacroStepType>(MacroStepType) : IEMidiMacroStepType::Delay;
+    }
+
+    if (MacroStepNode.has_child(MACRO_STEP_VALUE_KEY_NAME))
+    {
+        MacroStepNode[MACRO_STEP_VALUE_KEY_NAME] >> MacroStep->Value;
+    }
+
+    if (MacroStepNode.has_child(MACRO_STEP_DURATION_MS_KEY_NAME))
+    {
+        MacroStepNode[MACRO_STEP_DURATION_MS_KEY_NAME] >> MacroStep->DurationMs;
+    }
+
+    if (MacroStepNode.has_child(CONSOLE_COMMAND_KEY_NAME) && !MacroStepNode[CONSOLE_COMMAND_KEY_NAME].val().empty())
+    {
+        MacroStepNode[CONSOLE_COMMAND_KEY_NAME] >> MacroStep->ConsoleCommand;
+    }
+
+    if (MacroStepNode.has_child(MIDI_MESSAGE_KEY_NAME))
+    {
+        MacroStepNode[MIDI_MESSAGE_KEY_NAME] >> MacroStep->MidiMessage;
+    }
+    return true;
+}
+
+static void ReadMidiDeviceProfile(const ryml::ConstNodeRef& MidiProfileNode, IEMidiDeviceProfile& MidiDeviceProfile)
+{
+    const ryml::ConstNodeRef MidiProfilePropertiesNode = MidiProfileNode[MIDI_PROFILE_PROPERTIES_NODE_NAME];
+    MidiDeviceProfile.Properties.clear();
+    MidiDeviceProfile.Properties.reserve(MidiProfilePropertiesNode.num_children());
+
+    for (int ChildPos = 0; ChildPos < MidiProfilePropertiesNode.num_children(); ChildPos++)
+    {
+        const ryml::ConstNodeRef MidiProfilePropertyNode = MidiProfilePropertiesNode.at(ChildPos);
+        IEMidiDeviceProperty& MidiDeviceProperty = MidiDeviceProfile.Properties.emplace_back(MidiDeviceProfile.Name);
+
+        if (MidiProfilePropertyNode.has_child(MIDI_MESSAGE_TYPE_KEY_NAME))
+        {
+            uint8_t MidiMessageType = 0;
+            MidiProfilePropertyNode[MIDI_MESSAGE_TYPE_KEY_NAME] >> MidiMessageType;
+            MidiDeviceProperty.MidiMessageType = static_cast<IEMidiMessageType>(MidiMessageType);
+        }
+
+        if (MidiProfilePropertyNode.has_child(MIDI_TOGGLE_KEY_NAME))
+        {
+            MidiProfilePropertyNode[MIDI_TOGGLE_KEY_NAME] >> MidiDeviceProperty.bToggle;
+        }
+
+        if (MidiProfilePropertyNode.has_child(MIDI_COALESCE_KEY_NAME))
+        {
+            MidiProfilePropertyNode[MIDI_COALESCE_KEY_NAME] >> MidiDeviceProperty.bCoalesce;
+        }
+
+        if (MidiProfilePropertyNode.has_child(MIDI_ACTION_TYPE_KEY_NAME))
+        {
+            uint8_t MidiActionType = 0;
+            MidiProfilePropertyNode[MIDI_ACTION_TYPE_KEY_NAME] >> MidiActionType;
+            MidiDeviceProperty.MidiActionType = static_cast<IEMidiActionType>(MidiActionType);
+        }
+
+        if (MidiProfilePropertyNode.has_child(CONSOLE_COMMAND_KEY_NAME))
+        {
+            if (!MidiProfilePropertyNode[CONSOLE_COMMAND_KEY_NAME].val().empty())
+            {
+                MidiProfilePropertyNode[CONSOLE_COMMAND_KEY_NAME] >> MidiDeviceProperty.ConsoleCommand;
+            }
+        }
+
+        if (MidiProfilePropertyNode.has_child(OPEN_FILE_PATH_KEY_NAME))
+        {
+            if (!MidiProfilePropertyNode[OPEN_FILE_PATH_KEY_NAME].val().empty())
+            {
+                MidiProfilePropertyNode[OPEN_FILE_PATH_KEY_NAME] >> MidiDeviceProperty.OpenFilePath;
+            }
+        }
+
+        if (MidiProfilePropertyNode.has_child(MIDI_MESSAGE_KEY_NAME))
+        {
+            MidiProfilePropertyNode[MIDI_MESSAGE_KEY_NAME] >> MidiDeviceProperty.MidiMessage;
+        }
+
+        if (MidiProfilePropertyNode.has_child(RESPONSE_CURVE_KEY_NAME))
+        {
+            uint8_t ResponseCurve = 0;
+            MidiProfilePropertyNode[RESPONSE_CURVE_KEY_NAME] >> ResponseCurve;
+            MidiDeviceProperty.ResponseCurve = ResponseCurve < static_cast<uint8_t>(IEMidiResponseCurve::Count) ?
+                                               static_cast<IEMidiResponseCurve>(ResponseCurve) : IEMidiResponseCurve::Linear;
+        }
+
+        if (MidiProfilePropertyNode.has_child(INVERT_RESPONSE_KEY_NAME))
+        {
+            MidiProfilePropertyNode[INVERT_RESPONSE_KEY_NAME] >> MidiDeviceProperty.bInvertResponse;
+        }
+
+        if (MidiProfilePropertyNode.has_child(RESPONSE_MIN_KEY_NAME))
+        {
+            MidiProfilePropertyNode[RESPONSE_MIN_KEY_NAME] >> MidiDeviceProperty.ResponseMin;
+        }
+
+        if (MidiProfilePropertyNode.has_child(RESPONSE_MAX_KEY_NAME))
+        {
+            MidiProfilePropertyNode[RESPONSE_MAX_KEY_NAME] >> MidiDeviceProperty.ResponseMax;
+        }
+
+        if (MidiProfilePropertyNode.has_child(RESPONSE_BREAKPOINTS_KEY_NAME))
+        {
+            MidiProfilePropertyNode[RESPONSE_BREAKPOINTS_KEY_NAME] >> MidiDeviceProperty.ResponseBreakpoints;
+        }
+
+        if (MidiProfilePropertyNode.has_child(ANY_CHANNEL_KEY_NAME))
+        {
+            MidiProfilePropertyNode[ANY_CHANNEL_KEY_NAME] >> MidiDeviceProperty.bAnyChannel;
+        }
+
+        if (MidiProfilePropertyNode.has_child(DATA1_RANGE_END_KEY_NAME))
+        {
+            MidiProfilePropertyNode[DATA1_RANGE_END_KEY_NAME] >> MidiDeviceProperty.Data1RangeEnd;
+        }
+
+        if (MidiProfilePropertyNode.has_child(VALUE_MIN_KEY_NAME))
+        {
+            MidiProfilePropertyNode[VALUE_MIN_KEY_NAME] >> MidiDeviceProperty.ValueMin;
+        }
+
+        if (MidiProfilePropertyNode.has_child(VALUE_MAX_KEY_NAME))
+        {
+            MidiProfilePropertyNode[VALUE_MAX_KEY_NAME] >> MidiDeviceProperty.ValueMax;
+        }
+
+        if (MidiProfilePropertyNode.has_child(MACRO_STEPS_KEY_NAME))
+        {
+            MidiProfilePropertyNode[MACRO_STEPS_KEY_NAME] >> MidiDeviceProperty.MacroSteps;
+        }
+
+        if (MidiProfilePropertyNode.has_child(PERSISTENT_CONSOLE_COMMAND_KEY_NAME))
+        {
+            MidiProfilePropertyNode[PERSISTENT_CONSOLE_COMMAND_KEY_NAME] >> MidiDeviceProperty.bPersistentConsoleCommand;
+        }
+
+        if (MidiProfilePropertyNode.has_child(CONSOLE_COMMAND_WORKER_COUNT_KEY_NAME))
+        {
+            MidiProfilePropertyNode[CONSOLE_COMMAND_WORKER_COUNT_KEY_NAME] >> MidiDeviceProperty.ConsoleCommandWorkerCount;
+        }
+
+        if (MidiProfilePropertyNode.has_child(CONSOLE_COMMAND_QUEUE_DEPTH_KEY_NAME))
+        {
+            MidiProfilePropertyNode[CONSOLE_COMMAND_QUEUE_DEPTH_KEY_NAME] >> MidiDeviceProperty.ConsoleCommandQueueDepth;
+        }
+    }
+
+    if (MidiProfileNode.has_child(INITIAL_OUTPUT_MIDI_MESSAGES_KEY_NAME))
+    {
+        const ryml::ConstNodeRef ProfileInitialOutputMidiMessagesNode = MidiProfileNode[INITIAL_OUTPUT_MIDI_MESSAGES_KEY_NAME];
+        ProfileInitialOutputMidiMessagesNode >> MidiDeviceProfile.InitialOutputMidiMessages;
+    }
+
+    if (MidiProfileNode.has_child(COALESCE_CONTROL_CHANGES_KEY_NAME))
+    {
+        MidiProfileNode[COALESCE_CONTROL_CHANGES_KEY_NAME] >> MidiDeviceProfile.bCoalesceControlChanges;
+    }
+
+    if (MidiProfileNode.has_child(COALESCING_RATE_HZ_KEY_NAME))
+    {
+        MidiProfileNode[COALESCING_RATE_HZ_KEY_NAME] >> MidiDeviceProfile.CoalescingRateHz;
+    }
+
+    if (MidiProfileNode.has_child(OUTPUT_RATE_HZ_KEY_NAME))
+    {
+        MidiProfileNode[OUTPUT_RATE_HZ_KEY_NAME] >> MidiDeviceProfile.OutputRateHz;
+    }
+}
+
+/* Hash of the raw yaml of a profile node, profiles whose node did not change are not converted again on reload */
+static uint64_t GetMidiProfileSourceHash(const ryml::ConstNodeRef& MidiProfileNode, uint64_t Hash = FNV_OFFSET_BASIS)
+{
+    const auto HashSubstr = [&Hash](ryml::csubstr Substr)
+    {
+        for (const char Character : Substr)
+        {
+            Hash = (Hash ^ static_cast<unsigned char>(Character)) * FNV_PRIME;
+        }
+        Hash = (Hash ^ 0xFF) * FNV_PRIME;
+    };
+
+    if (MidiProfileNode.has_key())
+    {
+        HashSubstr(MidiProfileNode.key());
+    }
+    if (MidiProfileNode.has_val())
+    {
+        HashSubstr(MidiProfileNode.val());
+    }
+    Hash = (Hash ^ static_cast<uint64_t>(MidiProfileNode.num_children())) * FNV_PRIME;
+    for (const ryml::ConstNodeRef ChildNode : MidiProfileNode.children())
+    {
+        Hash = GetMidiProfileSourceHash(ChildNode, Hash);
+    }
+    return Hash;
+}
+
+static void WriteMidiDeviceProfile(ryml::NodeRef& MidiProfileNode, const IEMidiDeviceProfile& MidiDeviceProfile)
+{
+    ryml::NodeRef MidiProfilePropertiesNode = MidiProfileNode[MIDI_PROFILE_PROPERTIES_NODE_NAME];
+    if (MidiProfilePropertiesNode.is_seed())
+    {
+        MidiProfilePropertiesNode.create();
+        MidiProfilePropertiesNode |= ryml::SEQ;
+    }
+    MidiProfilePropertiesNode.clear_children();
+    for (const IEMidiDeviceProperty& MidiDeviceProperty : MidiDeviceProfile.Properties)
+    {
+        ryml::NodeRef MidiProfilePropertyNode = MidiProfilePropertiesNode.append_child();
+        MidiProfilePropertyNode.create();
+        MidiProfilePropertyNode |= ryml::MAP;
+
+        MidiProfilePropertyNode[MIDI_MESSAGE_TYPE_KEY_NAME] << static_cast<uint8_t>(MidiDeviceProperty.MidiMessageType);
+        MidiProfilePropertyNode[MIDI_TOGGLE_KEY_NAME] << MidiDeviceProperty.bToggle;
+        MidiProfilePropertyNode[MIDI_COALESCE_KEY_NAME] << MidiDeviceProperty.bCoalesce;
+        MidiProfilePropertyNode[MIDI_ACTION_TYPE_KEY_NAME] << static_cast<uint8_t>(MidiDeviceProperty.MidiActionType);
+        MidiProfilePropertyNode[CONSOLE_COMMAND_KEY_NAME] << MidiDeviceProperty.ConsoleCommand;
+        MidiProfilePropertyNode[OPEN_FILE_PATH_KEY_NAME] << MidiDeviceProperty.OpenFilePath;
+        MidiProfilePropertyNode[MIDI_MESSAGE_KEY_NAME] << MidiDeviceProperty.MidiMessage;
+        MidiProfilePropertyNode[RESPONSE_CURVE_KEY_NAME] << static_cast<uint8_t>(MidiDeviceProperty.ResponseCurve);
+        MidiProfilePropertyNode[INVERT_RESPONSE_KEY_NAME] << MidiDeviceProperty.bInvertResponse;
+        MidiProfilePropertyNode[RESPONSE_MIN_KEY_NAME] << MidiDeviceProperty.ResponseMin;
+        MidiProfilePropertyNode[RESPONSE_MAX_KEY_NAME] << MidiDeviceProperty.ResponseMax;
+        ryml::NodeRef ResponseBreakpointsNode = MidiProfilePropertyNode[RESPONSE_BREAKPOINTS_KEY_NAME];
+        ResponseBreakpointsNode.create();
+        ResponseBreakpointsNode |= ryml::SEQ;
+        ResponseBreakpointsNode << MidiDeviceProperty.ResponseBreakpoints;
+        MidiProfilePropertyNode[ANY_CHANNEL_KEY_NAME] << MidiDeviceProperty.bAnyChannel;
+        MidiProfilePropertyNode[DATA1_RANGE_END_KEY_NAME] << MidiDeviceProperty.Data1RangeEnd;
+        MidiProfilePropertyNode[VALUE_MIN_KEY_NAME] << MidiDeviceProperty.ValueMin;
+        MidiProfilePropertyNode[VALUE_MAX_KEY_NAME] << MidiDeviceProperty.ValueMax;
+        ryml::NodeRef MacroStepsNode = MidiProfilePropertyNode[MACRO_STEPS_KEY_NAME];
+        MacroStepsNode.create();
+        MacroStepsNode |= ryml::SEQ;
+        MacroStepsNode << MidiDeviceProperty.MacroSteps;
+        MidiProfilePropertyNode[PERSISTENT_CONSOLE_COMMAND_KEY_NAME] << MidiDeviceProperty.bPersistentConsoleCommand;
+        MidiProfilePropertyNode[CONSOLE_COMMAND_WORKER_COUNT_KEY_NAME] << MidiDeviceProperty.ConsoleCommandWorkerCount;
+        MidiProfilePropertyNode[CONSOLE_COMMAND_QUEUE_DEPTH_KEY_NAME] << MidiDeviceProperty.ConsoleCommandQueueDepth;
+    }
+
+    ryml::NodeRef ProfileInitialOutputMidiMessagesNode = MidiProfileNode[INITIAL_OUTPUT_MIDI_MESSAGES_KEY_NAME];
+    if (ProfileInitialOutputMidiMessagesNode.is_seed())
+    {
+        ProfileInitialOutputMidiMessagesNode.create();
+        ProfileInitialOutputMidiMessagesNode |= ryml::SEQ;
+    }
+    ProfileInitialOutputMidiMessagesNode.clear_children();
+    ProfileInitialOutputMidiMessagesNode << MidiDeviceProfile.InitialOutputMidiMessages;
+
+    MidiProfileNode[COALESCE_CONTROL_CHANGES_KEY_NAME] << MidiDeviceProfile.bCoalesceControlChanges;
+    MidiProfileNode[COALESCING_RATE_HZ_KEY_NAME] << MidiDeviceProfile.CoalescingRateHz;
+    MidiProfileNode[OUTPUT_RATE_HZ_KEY_NAME] << MidiDeviceProfile.OutputRateHz;
+}
+
+/* Writes next to the file and renames over it so that a crash never leaves a truncated file behind */
+static bool WriteYamlFileAtomically(const ryml::Tree& YamlTree, const std::filesystem::path& FilePath)
+{
+    std::filesystem::path TempFilePath = FilePath;
+    TempFilePath += TEMP_FILE_EXTENSION;
+
+    bool bIsWritten = false;
+    if (std::FILE* const TempFile = std::fopen(TempFilePath.string().c_str(), "wb"))
+    {
+        const size_t EmitSize = ryml::emit_yaml(YamlTree, TempFile);
+        bIsWritten = EmitSize && std::fflush(TempFile) == 0;
+#if defined(__linux__) || defined(__APPLE__)
+        bIsWritten = bIsWritten && fsync(fileno(TempFile)) == 0;
+#endif
+        bIsWritten = std::fclose(TempFile) == 0 && bIsWritten;
+    }
+
+    std::error_code ErrorCode;
+    if (bIsWritten)
+    {
+        std::filesystem::rename(TempFilePath, FilePath, ErrorCode);
+        bIsWritten = !ErrorCode;
+    }
+
+    if (!bIsWritten)
+    {
+        std::filesystem::remove(TempFilePath, ErrorCode);
+    }
+    return bIsWritten;
+}
+
+/* Device names may contain any character, the shard file name keeps a readable stem and a hash of the full name */
+static std::string GetMidiProfileShardFileName(const std::string& MidiDeviceName)
+{
+    std::string ShardFileName;
+    uint64_t MidiDeviceNameHash = FNV_OFFSET_BASIS;
+    for (const char Character : MidiDeviceName)
+    {
+        if (ShardFileName.size() < MAX_SHARD_FILE_STEM_LENGTH)
+        {
+            const unsigned char Byte = static_cast<unsigned char>(Character);
+            ShardFileName.push_back(std::isalnum(Byte) ? static_cast<char>(std::tolower(Byte)) : '_');
+        }
+        MidiDeviceNameHash = (MidiDeviceNameHash ^ static_cast<unsigned char>(Character)) * FNV_PRIME;
+    }
+    return std::format("{}_{:016x}{}", ShardFileName, MidiDeviceNameHash, YAML_FILE_EXTENSION);
+}
+
+static void WriteMidiProfileIndexEntry(ryml::Tree& MidiProfileIndexTree, const std::string& MidiDeviceName, const std::string& ShardFileName,
+                                       uint64_t MidiDeviceProfileHash)
+{
+    ryml::NodeRef Root = MidiProfileIndexTree.rootref();
+    if (!Root.is_map() && Root.empty())
+    {
+        Root |= ryml::MAP;
+    }
+
+    ryml::NodeRef MidiProfileIndexNode;
+    if (Root.has_child(ryml::to_csubstr(MidiDeviceName)))
+    {
+        MidiProfileIndexNode = Root[ryml::to_csubstr(MidiDeviceName)];
+    }
+    else
+    {
+        MidiProfileIndexNode = Root.append_child();
+        MidiProfileIndexNode.set_key(MidiProfileIndexTree.copy_to_arena(ryml::to_csubstr(MidiDeviceName)));
+        MidiProfileIndexNode |= ryml::MAP;
+    }
+    MidiProfileIndexNode[MIDI_PROFILE_SHARD_FILE_KEY_NAME] << ShardFileName;
+    MidiProfileIndexNode[MIDI_PROFILE_HASH_KEY_NAME] << MidiDeviceProfileHash;
+}
+
+IEMidiProfileManager::IEMidiProfileManager(IEMidiProfileStorage ProfileStorage) :
+    m_ProfileStorage(ProfileStorage)
+{
+    const std::filesystem::path IEMidiConfigFolderPath = IEUtils::GetIEConfigFolderPath();
+    if (!IEMidiConfigFolderPath.empty() && std::filesystem::exists(GetIEMidiProfileIndexFilePath()))
+    {
+        // A migrated library stays sharded for every client, the app and the daemon must not diverge
+        m_ProfileStorage = IEMidiProfileStorage::Sharded;
+    }
+
+    if (!IEMidiConfigFolderPath.empty() && m_ProfileStorage == IEMidiProfileStorage::Sharded)
+    {
+        const std::filesystem::path MidiProfileIndexFilePath = GetIEMidiProfileIndexFilePath();
+        if (!std::filesystem::exists(MidiProfileIndexFilePath))
+        {
+            const IEResult Result = MigrateToShardedProfiles();
+            if (Result)
+            {
+                IELOG_SUCCESS("%s", Result.Message.c_str());
+            }
+            else
+            {
+                IELOG_ERROR("%s", Result.Message.c_str());
+            }
+        }
+        IELOG_SUCCESS("Using profiles index file %s", MidiProfileIndexFilePath.string().c_str());
+    }
+    else if (!IEMidiConfigFolderPath.empty())
+    {
+        const std::filesystem::path MidiProfilesFilePath = IEMidiConfigFolderPath / IEMIDI_PROFILES_FILENAME;
+        const std::string ProfilesFilePathString = MidiProfilesFilePath.string();
+        if (!std::filesystem::exists(MidiProfilesFilePath))
+        {
+            if (std::FILE* const ProfilesFile = std::fopen(ProfilesFilePathString.c_str(), "w"))
+            {
+                IELOG_SUCCESS("Successfully created profiles settings file %s", ProfilesFilePathString.c_str());
+            }
+        }
+        IELOG_SUCCESS("Using profiles settings file %s", ProfilesFilePathString.c_str());
+    }
+}
+
+IEMidiProfileManager::~IEMidiProfileManager()
+{
+    StopWatchingProfiles();
+}
+
+std::filesystem::path IEMidiProfileManager::GetIEMidiProfilesFilePath() const
+{
+    std::filesystem::path MidiDeviceProfilesFilePath;
+    const std::filesystem::path IEMidiConfigFolderPath = IEUtils::GetIEConfigFolderPath();
+    if (std::filesystem::exists(IEMidiConfigFolderPath))
+    {
+        const std::filesystem::path PotentialMidiDeviceProfilesFilePath = IEMidiConfigFolderPath / IEMIDI_PROFILES_FILENAME;
+        if (std::filesystem::exists(PotentialMidiDeviceProfilesFilePath))
+        {
+            MidiDeviceProfilesFilePath = PotentialMidiDeviceProfilesFilePath;
+        }
+    }
+    return MidiDeviceProfilesFilePath;
+}
+
+std::filesystem::path IEMidiProfileManager::GetIEMidiProfileIndexFilePath() const
+{
+    const std::filesystem::path MidiProfileShardsFolderPath = GetIEMidiProfileShardsFolderPath();
+    return MidiProfileShardsFolderPath.empty() ? std::filesystem::path() : MidiProfileShardsFolderPath / IEMIDI_PROFILE_INDEX_FILENAME;
+}
+
+std::filesystem::path IEMidiProfileManager::GetIEMidiProfileLibraryFilePath() const
+{
+    return m_ProfileStorage == IEMidiProfileStorage::Sharded ? GetIEMidiProfileIndexFilePath() : GetIEMidiProfilesFilePath();
+}
+
+std::filesystem::path IEMidiProfileManager::GetIEMidiProfileShardsFolderPath() const
+{
+    std::filesystem::path MidiProfileShardsFolderPath;
+    const std::filesystem::path IEMidiConfigFolderPath = IEUtils::GetIEConfigFolderPath();
+    if (!IEMidiConfigFolderPath.empty())
+    {
+        MidiProfileShardsFolderPath = IEMidiConfigFolderPath / IEMIDI_PROFILE_SHARDS_FOLDER_NAME;
+    }
+    return MidiProfileShardsFolderPath;
+}
+
+std::filesystem::path IEMidiProfileManager::GetIEMidiProfileSnapshotFilePath() const
+{
+    std::filesystem::path MidiProfileSnapshotFilePath;
+    const std::filesystem::path IEMidiConfigFolderPath = IEUtils::GetIEConfigFolderPath();
+    if (!IEMidiConfigFolderPath.empty())
+    {
+        MidiProfileSnapshotFilePath = IEMidiConfigFolderPath / IEMIDI_PROFILE_SNAPSHOT_FILENAME;
+    }
+    return MidiProfileSnapshotFilePath;
+}
+
+bool IEMidiProfileManager::HasProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const
+{
+    std::scoped_lock ProfileCacheLock(m_ProfileCacheMutex);
+    RefreshProfileCache();
+    return m_ProfileCache.MidiDeviceProfileHashes.contains(MidiDeviceProfile.Name);
+}
+
+std::vector<std::string> IEMidiProfileManager::GetProfileNames() const
+{
+    std::scoped_lock ProfileCacheLock(m_ProfileCacheMutex);
+    RefreshProfileCache();
+    return m_ProfileCache.ProfileNames;
+}
+
+IEResult IEMidiProfileManager::SaveProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to save profile");
+
+    std::scoped_lock ProfileCacheLock(m_ProfileCacheMutex);
+    RefreshProfileCache();
+
+    if (m_ProfileStorage == IEMidiProfileStorage::Sharded)
+    {
+        return SaveShardedProfile(MidiDeviceProfile);
+    }
+
+    const std::filesystem::path MidiProfilesFilePath = GetIEMidiProfilesFilePath();
+    if (m_ProfileCache.bIsValid && LoadProfilesDocument())
+    {
+        const std::string& MidiDeviceName = MidiDeviceProfile.Name;
+        const uint64_t MidiDeviceProfileHash = GetMidiDeviceProfileHash(MidiDeviceProfile);
+
+        const std::unordered_map<std::string, uint64_t>::const_iterator HashIt = m_ProfileCache.MidiDeviceProfileHashes.find(MidiDeviceName);
+        if (HashIt != m_ProfileCache.MidiDeviceProfileHashes.end() && HashIt->second == MidiDeviceProfileHash)
+        {
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::format("Profile {} is unchanged, nothing to save", MidiDeviceName);
+            return Result;
+        }
+
+        // Only the node of this profile is rebuilt, every other profile is emitted back from the parsed tree as is
+        ryml::Tree& MidiProfilesTree = m_ProfileCache.MidiProfilesDocument->MidiProfilesTree;
+        ryml::NodeRef Root = MidiProfilesTree.rootref();
+        if (!Root.is_map() && Root.empty())
+        {
+            Root |= ryml::MAP;
+        }
+
+        ryml::NodeRef MidiProfileNode;
+        if (Root.has_child(ryml::to_csubstr(MidiDeviceName)))
+        {
+            MidiProfileNode = Root[ryml::to_csubstr(MidiDeviceName)];
+        }
+        else
+        {
+            // The tree outlives the profile, the key must live in its arena
+            MidiProfileNode = Root.append_child();
+            MidiProfileNode.set_key(MidiProfilesTree.copy_to_arena(ryml::to_csubstr(MidiDeviceName)));
+            MidiProfileNode |= ryml::MAP;
+        }
+        WriteMidiDeviceProfile(MidiProfileNode, MidiDeviceProfile);
+        const uint64_t MidiProfileSourceHash = GetMidiProfileSourceHash(MidiProfileNode);
+
+        if (WriteYamlFileAtomically(MidiProfilesTree, MidiProfilesFilePath))
+        {
+            if (!m_ProfileCache.MidiDeviceProfileHashes.contains(MidiDeviceName))
+            {
+                m_ProfileCache.ProfileNames.push_back(MidiDeviceName);
+            }
+            m_ProfileCache.MidiDeviceProfiles.insert_or_assign(MidiDeviceName, MidiDeviceProfile);
+            m_ProfileCache.MidiDeviceProfileHashes.insert_or_assign(MidiDeviceName, MidiDeviceProfileHash);
+            m_ProfileCache.MidiProfileSourceHashes.insert_or_assign(MidiDeviceName, MidiProfileSourceHash);
+
+            // Our own write must not look like an external change
+            std::error_code ErrorCode;
+            m_ProfileCache.ProfilesFileWriteTime = std::filesystem::last_write_time(MidiProfilesFilePath, ErrorCode);
+            m_ProfileCache.ProfilesFileSize = ErrorCode ? 0 : std::filesystem::file_size(MidiProfilesFilePath, ErrorCode);
+            m_ProfileCache.bIsValid = !ErrorCode;
+            if (m_ProfileCache.bIsValid)
+            {
+                WriteProfileSnapshot();
+            }
+
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::format("Successfully saved profile {}, into {}", MidiDeviceName, MidiProfilesFilePath.string());
+        }
+        else
+        {
+            // The in memory tree now differs from the file
+            m_ProfileCache.bIsValid = false;
+        }
+    }
+    return Result;
+}
+
+IEResult IEMidiProfileManager::LoadProfile(IEMidiDeviceProfile& MidiDeviceProfile) const
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to load profile");
+
+    std::scoped_lock ProfileCacheLock(m_ProfileCacheMutex);
+    RefreshProfileCache();
+    if (m_ProfileCache.bIsValid)
+    {
+        const std::filesystem::path MidiProfilesFilePath = GetIEMidiProfileLibraryFilePath();
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Successfully found profiles config file {}", MidiProfilesFilePath.string());
+
+        if (const IEMidiDeviceProfile* const CachedMidiDeviceProfilePtr = FindCachedMidiDeviceProfile(m_ProfileCache, MidiDeviceProfile.Name))
+        {
+            const IEMidiDeviceProfile& CachedMidiDeviceProfile = *CachedMidiDeviceProfilePtr;
+
+            // Assign into the existing properties so that their runtime IDs, and the toggle states keyed on them, survive a reload.
+            // Added properties get fresh IDs unique to this profile
+            std::vector<IEMidiDeviceProperty>& MidiDeviceProperties = MidiDeviceProfile.Properties;
+            const std::vector<IEMidiDeviceProperty>& CachedMidiDeviceProperties = CachedMidiDeviceProfile.Properties;
+            if (MidiDeviceProperties.size() > CachedMidiDeviceProperties.size())
+            {
+                MidiDeviceProperties.erase(MidiDeviceProperties.begin() + CachedMidiDeviceProperties.size(), MidiDeviceProperties.end());
+            }
+            MidiDeviceProperties.reserve(CachedMidiDeviceProperties.size());
+            for (size_t PropertyIndex = 0; PropertyIndex < CachedMidiDeviceProperties.size(); PropertyIndex++)
+            {
+                if (PropertyIndex == MidiDeviceProperties.size())
+                {
+                    MidiDeviceProperties.emplace_back(MidiDeviceProfile.Name);
+                }
+                MidiDeviceProperties[PropertyIndex] = CachedMidiDeviceProperties[PropertyIndex];
+                MidiDeviceProperties[PropertyIndex].MidiDeviceName = MidiDeviceProfile.Name;
+            }
+            MidiDeviceProfile.InitialOutputMidiMessages = CachedMidiDeviceProfile.InitialOutputMidiMessages;
+            MidiDeviceProfile.bCoalesceControlChanges = CachedMidiDeviceProfile.bCoalesceControlChanges;
+            MidiDeviceProfile.CoalescingRateHz = CachedMidiDeviceProfile.CoalescingRateHz;
+            MidiDeviceProfile.OutputRateHz = CachedMidiDeviceProfile.OutputRateHz;
+
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::format("Successfully loaded profile {} from {}", MidiDeviceProfile.Name, MidiProfilesFilePath.string());
+        }
+    }
+    return Result;
+}
+
+IEResult IEMidiProfileManager::RemoveProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to remove profile");
+    const std::filesystem::path IEMidiConfigFolderPath = IEUtils::GetIEConfigFolderPath();
+    // TODO
+    // if (!IEMidiConfigFolderPath.empty())
+    // {
+    //     const std::filesystem::path MidiProfilesFilePath = IEMidiConfigFolderPath / IEMIDI_PROFILES_FILENAME;
+    //     if (std::filesystem::exists(MidiProfilesFilePath))
+    //     {
+    //         const std::string Content = ExtractFileContent(MidiProfilesFilePath);
+
+    //         ryml::Tree MidiProfilesTree;
+    //         MidiProfilesTree.reserve(INITIAL_TREE_NODE_COUNT);
+    //         MidiProfilesTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
+    //         ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfilesTree);
+
+    //         ryml::NodeRef Root = MidiProfilesTree.rootref();
+    //         if (Root.is_map())
+    //         {
+    //             const char* MidiDeviceName = MidiDeviceProfile.Name.c_str();
+    //             Root.remove_child(MidiDeviceName);
+
+    //             if (std::FILE* const ProfilesFile = std::fopen(MidiProfilesFilePath.string().c_str(), "w"))
+    //             {
+    //                 if (!Root.empty())
+    //                 {
+    //                     size_t EmitSize = ryml::emit_yaml(MidiProfilesTree, ProfilesFile);
+    //                 }
+
+    //                 Result.Type = IEResult::Type::Success;
+    //                 Result.Message = std::format("Successfully removed profile {}, from {}", MidiDeviceProfile.Name, MidiProfilesFilePath.string());
+                    
+    //                 std::fclose(ProfilesFile);
+    //             }
+    //         }
+    //     }
+    // }
+    return Result;
+}
+
+IEResult IEMidiProfileManager::StartWatchingProfiles(IEMidiProfilesChangedCallback ProfilesChangedCallback, void* UserData)
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to watch profiles");
+
+    StopWatchingProfiles();
+
+#if defined(__linux__)
+    const std::filesystem::path MidiProfilesFilePath = GetIEMidiProfileLibraryFilePath();
+    if (!MidiProfilesFilePath.empty())
+    {
+        const int InotifyFileDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (InotifyFileDescriptor >= 0)
+        {
+            // Watch the folder, atomic saves and config management tools replace the file instead of writing into it
+            const std::string MidiProfilesFolderPath = MidiProfilesFilePath.parent_path().string();
+            if (inotify_add_watch(InotifyFileDescriptor, MidiProfilesFolderPath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0)
+            {
+                {
+                    // Establish the baseline the watcher diffs against
+                    std::scoped_lock ProfileCacheLock(m_ProfileCacheMutex);
+                    RefreshProfileCache();
+                }
+
+                m_ProfilesChangedCallback = ProfilesChangedCallback;
+                m_ProfilesChangedUserData = UserData;
+                m_bIsProfilesWatcherStopping.store(false);
+                m_ProfilesWatcher = std::thread(&IEMidiProfileManager::RunProfilesWatcher, this, InotifyFileDescriptor);
+
+                Result.Type = IEResult::Type::Success;
+                Result.Message = std::format("Watching profiles file {}", MidiProfilesFilePath.string());
+            }
+            else
+            {
+                close(InotifyFileDescriptor);
+            }
+        }
+    }
+#else
+    Result.Message = "Watching profiles is only supported on Linux";
+#endif
+    return Result;
+}
+
+void IEMidiProfileManager::StopWatchingProfiles()
+{
+    m_bIsProfilesWatcherStopping.store(true);
+    if (m_ProfilesWatcher.joinable())
+    {
+        m_ProfilesWatcher.join();
+    }
+    m_ProfilesChangedCallback = nullptr;
+    m_ProfilesChangedUserData = nullptr;
+}
 
-IEMidiProfileManager::IEMidiProfileManager()
+void IEMidiProfileManager::RunProfilesWatcher(int InotifyFileDescriptor)
 {
-    const std::filesystem::path IEMidiConfigFolderPath = IEUtils::GetIEConfigFolderPath();
-    if (!IEMidiConfigFolderPath.empty())
+#if defined(__linux__)
+    alignas(inotify_event) std::array<char, 4096> EventBuffer;
+    pollfd InotifyPollFileDescriptor = { InotifyFileDescriptor, POLLIN, 0 };
+    while (!m_bIsProfilesWatcherStopping.load())
     {
-        const std::filesystem::path MidiProfilesFilePath = IEMidiConfigFolderPath / IEMIDI_PROFILES_FILENAME;
-        const std::string ProfilesFilePathString = MidiProfilesFilePath.string();
-        if (!std::filesystem::exists(MidiProfilesFilePath))
+        if (poll(&InotifyPollFileDescriptor, 1, PROFILES_WATCHER_POLL_TIMEOUT_MS) <= 0)
         {
-            if (std::FILE* const ProfilesFile = std::fopen(ProfilesFilePathString.c_str(), "w"))
+            continue;
+        }
+
+        bool bHasProfilesFileChanged = false;
+        ssize_t ReadSize = 0;
+        while ((ReadSize = read(InotifyFileDescriptor, EventBuffer.data(), EventBuffer.size())) > 0)
+        {
+            for (ssize_t EventOffset = 0; EventOffset < ReadSize;)
             {
-                IELOG_SUCCESS("Successfully created profiles settings file %s", ProfilesFilePathString.c_str());
+                const inotify_event* const Event = reinterpret_cast<const inotify_event*>(EventBuffer.data() + EventOffset);
+                if (Event->len > 0)
+                {
+                    // Sharded profiles can change through the index or through any shard edited behind it
+                    const std::string_view EventFileName(Event->name);
+                    bHasProfilesFileChanged |= m_ProfileStorage == IEMidiProfileStorage::Sharded ? EventFileName.ends_with(YAML_FILE_EXTENSION) :
+                                                                                                   EventFileName == IEMIDI_PROFILES_FILENAME;
+                }
+                EventOffset += sizeof(inotify_event) + Event->len;
+            }
+        }
+
+        if (bHasProfilesFileChanged)
+        {
+            // Let writers that emit several events in a row finish before reading the file
+            std::this_thread::sleep_for(PROFILES_WATCHER_SETTLE_DURATION);
+            while (read(InotifyFileDescriptor, EventBuffer.data(), EventBuffer.size()) > 0);
+
+            const std::vector<std::string> ChangedProfileNames = RefreshChangedProfiles();
+            if (!ChangedProfileNames.empty() && m_ProfilesChangedCallback)
+            {
+                m_ProfilesChangedCallback(ChangedProfileNames, m_ProfilesChangedUserData);
             }
         }
-        IELOG_SUCCESS("Using profiles settings file %s", ProfilesFilePathString.c_str());
     }
+    close(InotifyFileDescriptor);
+#endif
 }
 
-std::filesystem::path IEMidiProfileManager::GetIEMidiProfilesFilePath() const
+std::string IEMidiProfileManager::ExtractFileContent(const std::filesystem::path& FilePath)
 {
-    std::filesystem::path MidiDeviceProfilesFilePath;
-    const std::filesystem::path IEMidiConfigFolderPath = IEUtils::GetIEConfigFolderPath();
-    if (std::filesystem::exists(IEMidiConfigFolderPath))
+    std::string Content;
+    if (std::FILE* const File = std::fopen(FilePath.string().c_str(), "rb"))
     {
-        const std::filesystem::path PotentialMidiDeviceProfilesFilePath = IEMidiConfigFolderPath / IEMIDI_PROFILES_FILENAME;
-        if (std::filesystem::exists(PotentialMidiDeviceProfilesFilePath))
+        std::fseek(File, 0, SEEK_END);
+        const long Size = std::ftell(File);
+        if (Size)
         {
-            MidiDeviceProfilesFilePath = PotentialMidiDeviceProfilesFilePath;
+            Content.resize(Size);
+            std::rewind(File);
+            std::fread(Content.data(), 1, Size, File);
         }
+        std::fclose(File);
     }
-    return MidiDeviceProfilesFilePath;
+    return Content;
 }
 
-bool IEMidiProfileManager::HasProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const
+void IEMidiProfileManager::RefreshProfileCache() const
 {
-    bool bHasProfile = false;
+    if (m_ProfileStorage == IEMidiProfileStorage::Sharded)
+    {
+        RefreshShardedProfileCache();
+        return;
+    }
 
     const std::filesystem::path MidiProfilesFilePath = GetIEMidiProfilesFilePath();
-    if (std::filesystem::exists(MidiProfilesFilePath))
+
+    std::error_code ErrorCode;
+    const std::filesystem::file_time_type ProfilesFileWriteTime = std::filesystem::last_write_time(MidiProfilesFilePath, ErrorCode);
+    const uintmax_t ProfilesFileSize = ErrorCode ? 0 : std::filesystem::file_size(MidiProfilesFilePath, ErrorCode);
+    if (ErrorCode)
     {
-        const std::string Content = ExtractFileContent(MidiProfilesFilePath);
+        m_ProfileCache = IEMidiProfileCache();
+        return;
+    }
 
-        ryml::Tree MidiProfilesTree;
-        MidiProfilesTree.reserve(INITIAL_TREE_NODE_COUNT);
-        MidiProfilesTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
-        ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfilesTree);
+    if (m_ProfileCache.bIsValid && m_ProfileCache.ProfilesFileWriteTime == ProfilesFileWriteTime && m_ProfileCache.ProfilesFileSize == ProfilesFileSize)
+    {
+        return;
+    }
+
+    IEMidiProfileCache PreviousProfileCache = std::move(m_ProfileCache);
+    m_ProfileCache = IEMidiProfileCache();
+    m_ProfileCache.ProfilesFileWriteTime = ProfilesFileWriteTime;
+    m_ProfileCache.ProfilesFileSize = ProfilesFileSize;
+    m_ProfileCache.bIsValid = true;
+
+    // Index the library straight from the compiled snapshot when it was compiled from this exact file
+    std::shared_ptr<IEMidiProfileSnapshot> MidiProfileSnapshot = std::make_shared<IEMidiProfileSnapshot>();
+    if (MidiProfileSnapshot->Open(GetIEMidiProfileSnapshotFilePath()) && MidiProfileSnapshot->IsCompiledFrom(ProfilesFileWriteTime, ProfilesFileSize))
+    {
+        const size_t ProfileCount = MidiProfileSnapshot->GetProfileCount();
+        m_ProfileCache.ProfileNames.reserve(ProfileCount);
+        m_ProfileCache.MidiDeviceProfileHashes.reserve(ProfileCount);
+        m_ProfileCache.MidiProfileSourceHashes.reserve(ProfileCount);
+        m_ProfileCache.SnapshotProfileIndices.reserve(ProfileCount);
+        for (size_t ProfileIndex = 0; ProfileIndex < ProfileCount; ProfileIndex++)
+        {
+            const std::string& ProfileName = m_ProfileCache.ProfileNames.emplace_back(MidiProfileSnapshot->GetProfileName(ProfileIndex));
+            m_ProfileCache.MidiDeviceProfileHashes.insert_or_assign(ProfileName, MidiProfileSnapshot->GetProfileHash(ProfileIndex));
+            m_ProfileCache.MidiProfileSourceHashes.insert_or_assign(ProfileName, MidiProfileSnapshot->GetProfileSourceHash(ProfileIndex));
+            m_ProfileCache.SnapshotProfileIndices.insert_or_assign(ProfileName, ProfileIndex);
+        }
+        m_ProfileCache.MidiProfileSnapshot = std::move(MidiProfileSnapshot);
+        return;
+    }
 
-        const ryml::ConstNodeRef Root = MidiProfilesTree.rootref();
+    if (LoadProfilesDocument())
+    {
+        const ryml::ConstNodeRef Root = m_ProfileCache.MidiProfilesDocument->MidiProfilesTree.crootref();
         if (Root.is_map())
         {
-            if (Root.has_child(MidiDeviceProfile.Name.c_str()))
+            m_ProfileCache.ProfileNames.reserve(Root.num_children());
+            m_ProfileCache.MidiDeviceProfiles.reserve(Root.num_children());
+            m_ProfileCache.MidiDeviceProfileHashes.reserve(Root.num_children());
+            m_ProfileCache.MidiProfileSourceHashes.reserve(Root.num_children());
+            for (const ryml::ConstNodeRef MidiProfileNode : Root.children())
             {
-                bHasProfile = true;
+                const std::string& ProfileName = m_ProfileCache.ProfileNames.emplace_back(MidiProfileNode.key().str, MidiProfileNode.key().len);
+                const uint64_t MidiProfileSourceHash = GetMidiProfileSourceHash(MidiProfileNode);
+                m_ProfileCache.MidiProfileSourceHashes.insert_or_assign(ProfileName, MidiProfileSourceHash);
+
+                // A profile whose yaml is unchanged is carried over instead of being converted again
+                const std::unordered_map<std::string, uint64_t>::const_iterator PreviousSourceHashIt = PreviousProfileCache.MidiProfileSourceHashes.find(ProfileName);
+                if (PreviousSourceHashIt != PreviousProfileCache.MidiProfileSourceHashes.end() && PreviousSourceHashIt->second == MidiProfileSourceHash)
+                {
+                    if (const IEMidiDeviceProfile* const PreviousMidiDeviceProfile = FindCachedMidiDeviceProfile(PreviousProfileCache, ProfileName))
+                    {
+                        m_ProfileCache.MidiDeviceProfiles.insert_or_assign(ProfileName, *PreviousMidiDeviceProfile);
+                        m_ProfileCache.MidiDeviceProfileHashes.insert_or_assign(ProfileName, PreviousProfileCache.MidiDeviceProfileHashes.at(ProfileName));
+                        continue;
+                    }
+                }
+
+                IEMidiDeviceProfile& MidiDeviceProfile = m_ProfileCache.MidiDeviceProfiles.try_emplace(ProfileName, ProfileName, 0, 0).first->second;
+                ReadMidiDeviceProfile(MidiProfileNode, MidiDeviceProfile);
+                m_ProfileCache.MidiDeviceProfileHashes.insert_or_assign(ProfileName, GetMidiDeviceProfileHash(MidiDeviceProfile));
             }
         }
+        WriteProfileSnapshot();
     }
-    
-    return bHasProfile;
 }
 
-IEResult IEMidiProfileManager::SaveProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const
+void IEMidiProfileManager::RefreshShardedProfileCache() const
 {
-    IEResult Result(IEResult::Type::Fail, "Failed to save profile");
+    const std::filesystem::path MidiProfileIndexFilePath = GetIEMidiProfileIndexFilePath();
 
-    const std::filesystem::path MidiProfilesFilePath = GetIEMidiProfilesFilePath();
-    if (std::filesystem::exists(MidiProfilesFilePath))
+    std::error_code ErrorCode;
+    const std::filesystem::file_time_type ProfilesFileWriteTime = std::filesystem::last_write_time(MidiProfileIndexFilePath, ErrorCode);
+    const uintmax_t ProfilesFileSize = ErrorCode ? 0 : std::filesystem::file_size(MidiProfileIndexFilePath, ErrorCode);
+    if (ErrorCode)
     {
-        if (std::FILE* const ProfilesFile = std::fopen(MidiProfilesFilePath.string().c_str(), "w"))
-        {
-            const std::string Content = ExtractFileContent(MidiProfilesFilePath);
+        m_ProfileCache = IEMidiProfileCache();
+        return;
+    }
 
-            ryml::Tree MidiProfilesTree;
-            MidiProfilesTree.reserve(INITIAL_TREE_NODE_COUNT);
-            MidiProfilesTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
-            ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfilesTree);
+    if (m_ProfileCache.bIsValid && m_ProfileCache.ProfilesFileWriteTime == ProfilesFileWriteTime && m_ProfileCache.ProfilesFileSize == ProfilesFileSize)
+    {
+        return;
+    }
 
-            ryml::NodeRef Root = MidiProfilesTree.rootref();
-            if (!Root.is_map() && Root.empty())
-            {
-                Root |= ryml::MAP;
-            }
+    IEMidiProfileCache PreviousProfileCache = std::move(m_ProfileCache);
+    m_ProfileCache = IEMidiProfileCache();
+    m_ProfileCache.ProfilesFileWriteTime = ProfilesFileWriteTime;
+    m_ProfileCache.ProfilesFileSize = ProfilesFileSize;
+    m_ProfileCache.bIsValid = true;
 
-            const char* MidiDeviceName = MidiDeviceProfile.Name.c_str();
-            ryml::NodeRef MidiProfileNode = Root[MidiDeviceName];
-            if (MidiProfileNode.is_seed())
-            {
-                MidiProfileNode.create();
-                MidiProfileNode |= ryml::MAP;
-            }
+    // Only the index is parsed, it lists every profile with its shard and content hash
+    const std::string Content = ExtractFileContent(MidiProfileIndexFilePath);
+    ryml::Tree MidiProfileIndexTree;
+    MidiProfileIndexTree.reserve(INITIAL_TREE_NODE_COUNT);
+    MidiProfileIndexTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
+    ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfileIndexTree);
 
-            ryml::NodeRef MidiProfilePropertiesNode = MidiProfileNode[MIDI_PROFILE_PROPERTIES_NODE_NAME];
-            if (MidiProfilePropertiesNode.is_seed())
-            {
-                MidiProfilePropertiesNode.create();
-                MidiProfilePropertiesNode |= ryml::SEQ;
-            }
-            MidiProfilePropertiesNode.clear_children();
-            for (const IEMidiDeviceProperty& MidiDeviceProperty : MidiDeviceProfile.Properties)
+    const ryml::ConstNodeRef Root = MidiProfileIndexTree.crootref();
+    if (Root.is_map())
+    {
+        const std::filesystem::path MidiProfileShardsFolderPath = GetIEMidiProfileShardsFolderPath();
+        m_ProfileCache.ProfileNames.reserve(Root.num_children());
+        m_ProfileCache.MidiDeviceProfileHashes.reserve(Root.num_children());
+        m_ProfileCache.ProfileShardFilePaths.reserve(Root.num_children());
+        for (const ryml::ConstNodeRef MidiProfileIndexNode : Root.children())
+        {
+            if (!MidiProfileIndexNode.has_child(MIDI_PROFILE_SHARD_FILE_KEY_NAME))
             {
-                ryml::NodeRef MidiProfilePropertyNode = MidiProfilePropertiesNode.append_child();
-                MidiProfilePropertyNode.create();
-                MidiProfilePropertyNode |= ryml::MAP;
-
-                MidiProfilePropertyNode[MIDI_MESSAGE_TYPE_KEY_NAME] << static_cast<uint8_t>(MidiDeviceProperty.MidiMessageType);
-                MidiProfilePropertyNode[MIDI_TOGGLE_KEY_NAME] << MidiDeviceProperty.bToggle;
-                MidiProfilePropertyNode[MIDI_ACTION_TYPE_KEY_NAME] << static_cast<uint8_t>(MidiDeviceProperty.MidiActionType);
-                MidiProfilePropertyNode[CONSOLE_COMMAND_KEY_NAME] << MidiDeviceProperty.ConsoleCommand;
-                MidiProfilePropertyNode[OPEN_FILE_PATH_KEY_NAME] << MidiDeviceProperty.OpenFilePath;
-                MidiProfilePropertyNode[MIDI_MESSAGE_KEY_NAME] << MidiDeviceProperty.MidiMessage;
+                continue;
             }
-            
-            ryml::NodeRef ProfileInitialOutputMidiMessagesNode = MidiProfileNode[INITIAL_OUTPUT_MIDI_MESSAGES_KEY_NAME];
-            if (ProfileInitialOutputMidiMessagesNode.is_seed())
+
+            std::string ShardFileName;
+            MidiProfileIndexNode[MIDI_PROFILE_SHARD_FILE_KEY_NAME] >> ShardFileName;
+            uint64_t MidiDeviceProfileHash = 0;
+            if (MidiProfileIndexNode.has_child(MIDI_PROFILE_HASH_KEY_NAME))
             {
-                ProfileInitialOutputMidiMessagesNode.create();
-                ProfileInitialOutputMidiMessagesNode |= ryml::SEQ;
+                MidiProfileIndexNode[MIDI_PROFILE_HASH_KEY_NAME] >> MidiDeviceProfileHash;
             }
-            ProfileInitialOutputMidiMessagesNode.clear_children();
-            ProfileInitialOutputMidiMessagesNode << MidiDeviceProfile.InitialOutputMidiMessages;
 
-            const size_t EmitSize = ryml::emit_yaml(MidiProfilesTree, ProfilesFile);
-            if (EmitSize)
+            const std::string& ProfileName = m_ProfileCache.ProfileNames.emplace_back(MidiProfileIndexNode.key().str, MidiProfileIndexNode.key().len);
+            m_ProfileCache.MidiDeviceProfileHashes.insert_or_assign(ProfileName, MidiDeviceProfileHash);
+            m_ProfileCache.ProfileShardFilePaths.insert_or_assign(ProfileName, MidiProfileShardsFolderPath / ShardFileName);
+
+            // Profiles already parsed stay cached while the index vouches for the same content
+            const std::unordered_map<std::string, uint64_t>::const_iterator PreviousHashIt = PreviousProfileCache.MidiDeviceProfileHashes.find(ProfileName);
+            const std::unordered_map<std::string, IEMidiDeviceProfile>::const_iterator PreviousProfileIt = PreviousProfileCache.MidiDeviceProfiles.find(ProfileName);
+            if (PreviousHashIt != PreviousProfileCache.MidiDeviceProfileHashes.end() && PreviousHashIt->second == MidiDeviceProfileHash &&
+                PreviousProfileIt != PreviousProfileCache.MidiDeviceProfiles.end() && PreviousProfileCache.ProfileShardWriteTimes.contains(ProfileName))
             {
-                Result.Type = IEResult::Type::Success;
-                Result.Message = std::format("Successfully saved profile {}, into {}", MidiDeviceName, MidiProfilesFilePath.string());
+                m_ProfileCache.MidiDeviceProfiles.insert_or_assign(ProfileName, PreviousProfileIt->second);
+                m_ProfileCache.ProfileShardWriteTimes.insert_or_assign(ProfileName, PreviousProfileCache.ProfileShardWriteTimes.at(ProfileName));
             }
+        }
+    }
+}
+
+IEResult IEMidiProfileManager::SaveShardedProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to save profile");
+    if (!m_ProfileCache.bIsValid)
+    {
+        return Result;
+    }
+
+    const std::string& MidiDeviceName = MidiDeviceProfile.Name;
+    const uint64_t MidiDeviceProfileHash = GetMidiDeviceProfileHash(MidiDeviceProfile);
+
+    // Picks up a shard edited behind the index before comparing hashes
+    FindCachedMidiDeviceProfile(m_ProfileCache, MidiDeviceName);
+    const std::unordered_map<std::string, uint64_t>::const_iterator HashIt = m_ProfileCache.MidiDeviceProfileHashes.find(MidiDeviceName);
+    if (HashIt != m_ProfileCache.MidiDeviceProfileHashes.end() && HashIt->second == MidiDeviceProfileHash)
+    {
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Profile {} is unchanged, nothing to save", MidiDeviceName);
+        return Result;
+    }
+
+    const std::unordered_map<std::string, std::filesystem::path>::const_iterator ShardIt = m_ProfileCache.ProfileShardFilePaths.find(MidiDeviceName);
+    const std::filesystem::path MidiProfileShardFilePath = ShardIt != m_ProfileCache.ProfileShardFilePaths.end() ? ShardIt->second :
+                                                           GetIEMidiProfileShardsFolderPath() / GetMidiProfileShardFileName(MidiDeviceName);
+
+    ryml::Tree MidiProfileShardTree;
+    MidiProfileShardTree.reserve(INITIAL_TREE_NODE_COUNT);
+    MidiProfileShardTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
+    ryml::NodeRef Root = MidiProfileShardTree.rootref();
+    Root |= ryml::MAP;
+    ryml::NodeRef MidiProfileNode = Root.append_child();
+    MidiProfileNode.set_key(MidiProfileShardTree.copy_to_arena(ryml::to_csubstr(MidiDeviceName)));
+    MidiProfileNode |= ryml::MAP;
+    WriteMidiDeviceProfile(MidiProfileNode, MidiDeviceProfile);
+
+    if (WriteYamlFileAtomically(MidiProfileShardTree, MidiProfileShardFilePath) &&
+        UpdateShardedProfileIndex(MidiDeviceName, MidiProfileShardFilePath.filename().string(), MidiDeviceProfileHash))
+    {
+        if (!m_ProfileCache.ProfileShardFilePaths.contains(MidiDeviceName))
+        {
+            m_ProfileCache.ProfileNames.push_back(MidiDeviceName);
+        }
+        m_ProfileCache.MidiDeviceProfiles.insert_or_assign(MidiDeviceName, MidiDeviceProfile);
+        m_ProfileCache.MidiDeviceProfileHashes.insert_or_assign(MidiDeviceName, MidiDeviceProfileHash);
+        m_ProfileCache.ProfileShardFilePaths.insert_or_assign(MidiDeviceName, MidiProfileShardFilePath);
 
-            std::fclose(ProfilesFile);
+        // The index stat is left stale on purpose, the next refresh merges profiles other processes saved meanwhile
+        std::error_code ErrorCode;
+        const std::filesystem::file_time_type ShardWriteTime = std::filesystem::last_write_time(MidiProfileShardFilePath, ErrorCode);
+        if (!ErrorCode)
+        {
+            m_ProfileCache.ProfileShardWriteTimes.insert_or_assign(MidiDeviceName, ShardWriteTime);
         }
+
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Successfully saved profile {}, into {}", MidiDeviceName, MidiProfileShardFilePath.string());
     }
     return Result;
 }
 
-IEResult IEMidiProfileManager::LoadProfile(IEMidiDeviceProfile& MidiDeviceProfile) const
+bool IEMidiProfileManager::UpdateShardedProfileIndex(const std::string& MidiDeviceName, const std::string& ShardFileName, uint64_t MidiDeviceProfileHash) const
 {
-    IEResult Result(IEResult::Type::Fail, "Failed to load profile");
+    const std::filesystem::path MidiProfileIndexFilePath = GetIEMidiProfileIndexFilePath();
 
-    const std::filesystem::path MidiProfilesFilePath = GetIEMidiProfilesFilePath();
-    if (std::filesystem::exists(MidiProfilesFilePath))
+    // Other processes save their own profiles too, the entry is merged into the index on disk under an advisory lock
+#if defined(__linux__) || defined(__APPLE__)
+    const std::string MidiProfileIndexLockFilePath = (GetIEMidiProfileShardsFolderPath() / IEMIDI_PROFILE_INDEX_LOCK_FILENAME).string();
+    const int IndexLockFileDescriptor = open(MidiProfileIndexLockFilePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (IndexLockFileDescriptor >= 0)
     {
-        Result.Type = IEResult::Type::Success;
-        Result.Message = std::format("Successfully found profiles config file {}", MidiProfilesFilePath.string());
+        flock(IndexLockFileDescriptor, LOCK_EX);
+    }
+#endif
 
-        const std::string Content = ExtractFileContent(MidiProfilesFilePath);
+    const std::string Content = ExtractFileContent(MidiProfileIndexFilePath);
+    ryml::Tree MidiProfileIndexTree;
+    MidiProfileIndexTree.reserve(INITIAL_TREE_NODE_COUNT);
+    MidiProfileIndexTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
+    ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfileIndexTree);
+    WriteMidiProfileIndexEntry(MidiProfileIndexTree, MidiDeviceName, ShardFileName, MidiDeviceProfileHash);
+    const bool bIsWritten = WriteYamlFileAtomically(MidiProfileIndexTree, MidiProfileIndexFilePath);
+
+#if defined(__linux__) || defined(__APPLE__)
+    if (IndexLockFileDescriptor >= 0)
+    {
+        flock(IndexLockFileDescriptor, LOCK_UN);
+        close(IndexLockFileDescriptor);
+    }
+#endif
+    return bIsWritten;
+}
+
+IEResult IEMidiProfileManager::MigrateToShardedProfiles() const
+{
+    IEResult Result(IEResult::Type::Fail, "Failed to migrate profiles to sharded storage");
+
+    const std::filesystem::path MidiProfileShardsFolderPath = GetIEMidiProfileShardsFolderPath();
+    std::error_code ErrorCode;
+    std::filesystem::create_directories(MidiProfileShardsFolderPath, ErrorCode);
+    if (ErrorCode)
+    {
+        return Result;
+    }
 
+    ryml::Tree MidiProfileIndexTree;
+    MidiProfileIndexTree.reserve(INITIAL_TREE_NODE_COUNT);
+    MidiProfileIndexTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
+    MidiProfileIndexTree.rootref() |= ryml::MAP;
+
+    size_t MigratedProfileCount = 0;
+    const std::filesystem::path MidiProfilesFilePath = GetIEMidiProfilesFilePath();
+    if (!MidiProfilesFilePath.empty())
+    {
+        const std::string Content = ExtractFileContent(MidiProfilesFilePath);
         ryml::Tree MidiProfilesTree;
         MidiProfilesTree.reserve(INITIAL_TREE_NODE_COUNT);
         MidiProfilesTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
         ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfilesTree);
 
-        const ryml::ConstNodeRef Root = MidiProfilesTree.rootref();
-        if (Root.is_map() && Root.has_child(MidiDeviceProfile.Name.c_str()))
+        const ryml::ConstNodeRef Root = MidiProfilesTree.crootref();
+        if (Root.is_map())
         {
-            const ryml::ConstNodeRef MidiProfileNode = Root[MidiDeviceProfile.Name.c_str()];
-            const ryml::ConstNodeRef MidiProfilePropertiesNode = MidiProfileNode[MIDI_PROFILE_PROPERTIES_NODE_NAME];
-            MidiDeviceProfile.Properties.clear();
-            MidiDeviceProfile.Properties.reserve(MidiProfilePropertiesNode.num_children());
-
-            for (int ChildPos = 0; ChildPos < MidiProfilePropertiesNode.num_children(); ChildPos++)
+            for (const ryml::ConstNodeRef MidiProfileNode : Root.children())
             {
-                const ryml::ConstNodeRef MidiProfilePropertyNode = MidiProfilePropertiesNode.at(ChildPos);
-                IEMidiDeviceProperty& MidiDeviceProperty = MidiDeviceProfile.Properties.emplace_back(MidiDeviceProfile.Name);
+                const std::string MidiDeviceName(MidiProfileNode.key().str, MidiProfileNode.key().len);
+                IEMidiDeviceProfile MidiDeviceProfile(MidiDeviceName, 0, 0);
+                ReadMidiDeviceProfile(MidiProfileNode, MidiDeviceProfile);
 
-                if (MidiProfilePropertyNode.has_child(MIDI_MESSAGE_TYPE_KEY_NAME))
-                {
-                    uint8_t MidiMessageType = 0;
-                    MidiProfilePropertyNode[MIDI_MESSAGE_TYPE_KEY_NAME] >> MidiMessageType;
-                    MidiDeviceProperty.MidiMessageType = static_cast<IEMidiMessageType>(MidiMessageType);
-                }
+                ryml::Tree MidiProfileShardTree;
+                MidiProfileShardTree.reserve(INITIAL_TREE_NODE_COUNT);
+                MidiProfileShardTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
+                ryml::NodeRef ShardRoot = MidiProfileShardTree.rootref();
+                ShardRoot |= ryml::MAP;
+                ryml::NodeRef MidiProfileShardNode = ShardRoot.append_child();
+                MidiProfileShardNode.set_key(MidiProfileShardTree.copy_to_arena(ryml::to_csubstr(MidiDeviceName)));
+                MidiProfileShardNode |= ryml::MAP;
+                WriteMidiDeviceProfile(MidiProfileShardNode, MidiDeviceProfile);
 
-                if (MidiProfilePropertyNode.has_child(MIDI_TOGGLE_KEY_NAME))
+                const std::string ShardFileName = GetMidiProfileShardFileName(MidiDeviceName);
+                if (!WriteYamlFileAtomically(MidiProfileShardTree, MidiProfileShardsFolderPath / ShardFileName))
                 {
-                    MidiProfilePropertyNode[MIDI_TOGGLE_KEY_NAME] >> MidiDeviceProperty.bToggle;
+                    Result.Message = std::format("Failed to migrate profile {} to sharded storage", MidiDeviceName);
+                    return Result;
                 }
+                WriteMidiProfileIndexEntry(MidiProfileIndexTree, MidiDeviceName, ShardFileName, GetMidiDeviceProfileHash(MidiDeviceProfile));
+                MigratedProfileCount++;
+            }
+        }
+    }
 
-                if (MidiProfilePropertyNode.has_child(MIDI_ACTION_TYPE_KEY_NAME))
-                {
-                    uint8_t MidiActionType = 0;
-                    MidiProfilePropertyNode[MIDI_ACTION_TYPE_KEY_NAME] >> MidiActionType;
-                    MidiDeviceProperty.MidiActionType = static_cast<IEMidiActionType>(MidiActionType);
-                }
+    // The index is written last, an interrupted migration has no index and runs again on the next start.
+    // profiles.yaml is left in place as a backup
+    if (WriteYamlFileAtomically(MidiProfileIndexTree, GetIEMidiProfileIndexFilePath()))
+    {
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Migrated {} profiles to sharded storage in {}", MigratedProfileCount, MidiProfileShardsFolderPath.string());
+    }
+    return Result;
+}
 
-                if (MidiProfilePropertyNode.has_child(CONSOLE_COMMAND_KEY_NAME))
-                {
-                    if (!MidiProfilePropertyNode[CONSOLE_COMMAND_KEY_NAME].val().empty())
-                    {
-                        MidiProfilePropertyNode[CONSOLE_COMMAND_KEY_NAME] >> MidiDeviceProperty.ConsoleCommand;
-                    }
-                }
+bool IEMidiProfileManager::LoadProfilesDocument() const
+{
+    if (!m_ProfileCache.MidiProfilesDocument)
+    {
+        const std::filesystem::path MidiProfilesFilePath = GetIEMidiProfilesFilePath();
+        if (!MidiProfilesFilePath.empty())
+        {
+            const std::string Content = ExtractFileContent(MidiProfilesFilePath);
 
-                if (MidiProfilePropertyNode.has_child(OPEN_FILE_PATH_KEY_NAME))
-                {
-                    if (!MidiProfilePropertyNode[OPEN_FILE_PATH_KEY_NAME].val().empty())
-                    {
-                        MidiProfilePropertyNode[OPEN_FILE_PATH_KEY_NAME] >> MidiDeviceProperty.OpenFilePath;
-                    }
-                }
+            m_ProfileCache.MidiProfilesDocument = std::make_shared<IEMidiProfilesDocument>();
+            ryml::Tree& MidiProfilesTree = m_ProfileCache.MidiProfilesDocument->MidiProfilesTree;
+            MidiProfilesTree.reserve(INITIAL_TREE_NODE_COUNT);
+            MidiProfilesTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
+            ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfilesTree);
+        }
+    }
+    return m_ProfileCache.MidiProfilesDocument != nullptr;
+}
 
-                if (MidiProfilePropertyNode.has_child(MIDI_MESSAGE_KEY_NAME))
-                {
-                    MidiProfilePropertyNode[MIDI_MESSAGE_KEY_NAME] >> MidiDeviceProperty.MidiMessage;
-                }
-            }
+std::vector<std::string> IEMidiProfileManager::RefreshChangedProfiles() const
+{
+    std::vector<std::string> ChangedProfileNames;
 
-            if (MidiProfileNode.has_child(INITIAL_OUTPUT_MIDI_MESSAGES_KEY_NAME))
-            {
-                const ryml::ConstNodeRef ProfileInitialOutputMidiMessagesNode = MidiProfileNode[INITIAL_OUTPUT_MIDI_MESSAGES_KEY_NAME];
-                ProfileInitialOutputMidiMessagesNode >> MidiDeviceProfile.InitialOutputMidiMessages;
-            }
+    std::scoped_lock ProfileCacheLock(m_ProfileCacheMutex);
+    const std::unordered_map<std::string, uint64_t> PreviousMidiDeviceProfileHashes = m_ProfileCache.MidiDeviceProfileHashes;
+    RefreshProfileCache();
 
-            Result.Type = IEResult::Type::Success;
-            Result.Message = std::format("Successfully loaded profile {} from {}", MidiDeviceProfile.Name, MidiProfilesFilePath.string());
+    // Shards in use are read again when they were edited behind the index, which also refreshes their hash
+    std::vector<std::string> MaterializedProfileNames;
+    for (const std::pair<const std::string, std::filesystem::path>& ProfileShardFilePath : m_ProfileCache.ProfileShardFilePaths)
+    {
+        if (m_ProfileCache.MidiDeviceProfiles.contains(ProfileShardFilePath.first))
+        {
+            MaterializedProfileNames.push_back(ProfileShardFilePath.first);
         }
     }
-    return Result;
+    for (const std::string& MaterializedProfileName : MaterializedProfileNames)
+    {
+        FindCachedMidiDeviceProfile(m_ProfileCache, MaterializedProfileName);
+    }
+
+    for (const std::pair<const std::string, uint64_t>& MidiDeviceProfileHash : m_ProfileCache.MidiDeviceProfileHashes)
+    {
+        const std::unordered_map<std::string, uint64_t>::const_iterator It = PreviousMidiDeviceProfileHashes.find(MidiDeviceProfileHash.first);
+        if (It == PreviousMidiDeviceProfileHashes.end() || It->second != MidiDeviceProfileHash.second)
+        {
+            ChangedProfileNames.push_back(MidiDeviceProfileHash.first);
+        }
+    }
+    return ChangedProfileNames;
 }
 
-IEResult IEMidiProfileManager::RemoveProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const
+const IEMidiDeviceProfile* IEMidiProfileManager::FindCachedMidiDeviceProfile(IEMidiProfileCache& ProfileCache, const std::string& MidiDeviceName)
 {
-    IEResult Result(IEResult::Type::Fail, "Failed to remove profile");
-    const std::filesystem::path IEMidiConfigFolderPath = IEUtils::GetIEConfigFolderPath();
-    // TODO
-    // if (!IEMidiConfigFolderPath.empty())
-    // {
-    //     const std::filesystem::path MidiProfilesFilePath = IEMidiConfigFolderPath / IEMIDI_PROFILES_FILENAME;
-    //     if (std::filesystem::exists(MidiProfilesFilePath))
-    //     {
-    //         const std::string Content = ExtractFileContent(MidiProfilesFilePath);
+    const std::unordered_map<std::string, std::filesystem::path>::const_iterator ShardIt = ProfileCache.ProfileShardFilePaths.find(MidiDeviceName);
+    if (ShardIt != ProfileCache.ProfileShardFilePaths.end())
+    {
+        std::error_code ErrorCode;
+        const std::filesystem::file_time_type ShardWriteTime = std::filesystem::last_write_time(ShardIt->second, ErrorCode);
+        if (ErrorCode)
+        {
+            return nullptr;
+        }
 
-    //         ryml::Tree MidiProfilesTree;
-    //         MidiProfilesTree.reserve(INITIAL_TREE_NODE_COUNT);
-    //         MidiProfilesTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
-    //         ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfilesTree);
+        // Shards are parsed on first use, and again only once their file changed
+        const std::unordered_map<std::string, IEMidiDeviceProfile>::iterator It = ProfileCache.MidiDeviceProfiles.find(MidiDeviceName);
+        const std::unordered_map<std::string, std::filesystem::file_time_type>::const_iterator WriteTimeIt = ProfileCache.ProfileShardWriteTimes.find(MidiDeviceName);
+        if (It != ProfileCache.MidiDeviceProfiles.end() && WriteTimeIt != ProfileCache.ProfileShardWriteTimes.end() && WriteTimeIt->second == ShardWriteTime)
+        {
+            return &It->second;
+        }
 
-    //         ryml::NodeRef Root = MidiProfilesTree.rootref();
-    //         if (Root.is_map())
-    //         {
-    //             const char* MidiDeviceName = MidiDeviceProfile.Name.c_str();
-    //             Root.remove_child(MidiDeviceName);
+        const std::string Content = ExtractFileContent(ShardIt->second);
+        ryml::Tree MidiProfileShardTree;
+        MidiProfileShardTree.reserve(INITIAL_TREE_NODE_COUNT);
+        MidiProfileShardTree.reserve_arena(INITIAL_TREE_ARENA_CHAR_COUNT);
+        ryml::parse_in_arena(ryml::to_csubstr(Content), &MidiProfileShardTree);
 
-    //             if (std::FILE* const ProfilesFile = std::fopen(MidiProfilesFilePath.string().c_str(), "w"))
-    //             {
-    //                 if (!Root.empty())
-    //                 {
-    //                     size_t EmitSize = ryml::emit_yaml(MidiProfilesTree, ProfilesFile);
-    //                 }
+        const ryml::ConstNodeRef Root = MidiProfileShardTree.crootref();
+        if (!Root.is_map() || !Root.has_child(ryml::to_csubstr(MidiDeviceName)))
+        {
+            return nullptr;
+        }
 
-    //                 Result.Type = IEResult::Type::Success;
-    //                 Result.Message = std::format("Successfully removed profile {}, from {}", MidiDeviceProfile.Name, MidiProfilesFilePath.string());
-                    
-    //                 std::fclose(ProfilesFile);
-    //             }
-    //         }
-    //     }
-    // }
-    return Result;
+        ProfileCache.MidiDeviceProfiles.erase(MidiDeviceName);
+        IEMidiDeviceProfile& MidiDeviceProfile = ProfileCache.MidiDeviceProfiles.try_emplace(MidiDeviceName, MidiDeviceName, 0, 0).first->second;
+        ReadMidiDeviceProfile(Root[ryml::to_csubstr(MidiDeviceName)], MidiDeviceProfile);
+        ProfileCache.MidiDeviceProfileHashes.insert_or_assign(MidiDeviceName, GetMidiDeviceProfileHash(MidiDeviceProfile));
+        ProfileCache.ProfileShardWriteTimes.insert_or_assign(MidiDeviceName, ShardWriteTime);
+        return &MidiDeviceProfile;
+    }
+
+    const std::unordered_map<std::string, IEMidiDeviceProfile>::const_iterator It = ProfileCache.MidiDeviceProfiles.find(MidiDeviceName);
+    if (It != ProfileCache.MidiDeviceProfiles.end())
+    {
+        return &It->second;
+    }
+
+    // Profiles indexed from the snapshot are only materialized once they are asked for
+    const std::unordered_map<std::string, size_t>::const_iterator IndexIt = ProfileCache.SnapshotProfileIndices.find(MidiDeviceName);
+    if (ProfileCache.MidiProfileSnapshot && IndexIt != ProfileCache.SnapshotProfileIndices.end())
+    {
+        IEMidiDeviceProfile& MidiDeviceProfile = ProfileCache.MidiDeviceProfiles.try_emplace(MidiDeviceName, MidiDeviceName, 0, 0).first->second;
+        ProfileCache.MidiProfileSnapshot->ReadMidiDeviceProfile(IndexIt->second, MidiDeviceProfile);
+        return &MidiDeviceProfile;
+    }
+    return nullptr;
 }
 
-std::string IEMidiProfileManager::ExtractFileContent(const std::filesystem::path& FilePath) const
+void IEMidiProfileManager::WriteProfileSnapshot() const
 {
-    std::string Content;
-    if (std::FILE* const File = std::fopen(FilePath.string().c_str(), "rb"))
+    std::vector<const IEMidiDeviceProfile*> MidiDeviceProfiles;
+    std::vector<uint64_t> MidiDeviceProfileHashes;
+    std::vector<uint64_t> MidiProfileSourceHashes;
+    MidiDeviceProfiles.reserve(m_ProfileCache.ProfileNames.size());
+    MidiDeviceProfileHashes.reserve(m_ProfileCache.ProfileNames.size());
+    MidiProfileSourceHashes.reserve(m_ProfileCache.ProfileNames.size());
+    for (const std::string& ProfileName : m_ProfileCache.ProfileNames)
     {
-        std::fseek(File, 0, SEEK_END);
-        const long Size = std::ftell(File);
-        if (Size)
+        if (const IEMidiDeviceProfile* const MidiDeviceProfile = FindCachedMidiDeviceProfile(m_ProfileCache, ProfileName))
         {
-            Content.resize(Size);
-            std::rewind(File);
-            std::fread(Content.data(), 1, Size, File);
+            MidiDeviceProfiles.push_back(MidiDeviceProfile);
+            MidiDeviceProfileHashes.push_back(m_ProfileCache.MidiDeviceProfileHashes.at(ProfileName));
+            MidiProfileSourceHashes.push_back(m_ProfileCache.MidiProfileSourceHashes.at(ProfileName));
         }
-        std::fclose(File);
     }
-    return Content;
+
+    const IEResult Result = IEMidiProfileSnapshot::Write(GetIEMidiProfileSnapshotFilePath(), MidiDeviceProfiles, MidiDeviceProfileHashes, MidiProfileSourceHashes,
+                                                         m_ProfileCache.ProfilesFileWriteTime, m_ProfileCache.ProfilesFileSize);
+    if (!Result)
+    {
+        IELOG_ERROR("%s", Result.Message.c_str());
+    }
+}
+
+uint64_t IEMidiProfileManager::GetMidiDeviceProfileHash(const IEMidiDeviceProfile& MidiDeviceProfile)
+{
+    // FNV-1a over every persisted field, runtime IDs and recording state are left out
+    uint64_t Hash = FNV_OFFSET_BASIS;
+    const auto HashBytes = [&Hash](const void* Data, size_t Size)
+    {
+        const unsigned char* const Bytes = static_cast<const unsigned char*>(Data);
+        for (size_t ByteIndex = 0; ByteIndex < Size; ByteIndex++)
+        {
+            Hash = (Hash ^ Bytes[ByteIndex]) * FNV_PRIME;
+        }
+    };
+    const auto HashString = [&HashBytes](const std::string& String)
+    {
+        const size_t Size = String.size();
+        HashBytes(&Size, sizeof(Size));
+        HashBytes(String.data(), Size);
+    };
+    const auto HashMidiMessage = [&HashBytes](const IEMidiMessage& MidiMessage)
+    {
+        HashBytes(&MidiMessage.Size, sizeof(MidiMessage.Size));
+        HashBytes(MidiMessage.data(), MidiMessage.size());
+    };
+
+    const size_t PropertyCount = MidiDeviceProfile.Properties.size();
+    HashBytes(&PropertyCount, sizeof(PropertyCount));
+    for (const IEMidiDeviceProperty& MidiDeviceProperty : MidiDeviceProfile.Properties)
+    {
+        HashBytes(&MidiDeviceProperty.MidiMessageType, sizeof(MidiDeviceProperty.MidiMessageType));
+        HashBytes(&MidiDeviceProperty.MidiActionType, sizeof(MidiDeviceProperty.MidiActionType));
+        HashBytes(&MidiDeviceProperty.bToggle, sizeof(MidiDeviceProperty.bToggle));
+        HashBytes(&MidiDeviceProperty.bCoalesce, sizeof(MidiDeviceProperty.bCoalesce));
+        HashString(MidiDeviceProperty.ConsoleCommand);
+        HashString(MidiDeviceProperty.OpenFilePath);
+        HashMidiMessage(MidiDeviceProperty.MidiMessage);
+        HashBytes(&MidiDeviceProperty.ResponseCurve, sizeof(MidiDeviceProperty.ResponseCurve));
+        HashBytes(&MidiDeviceProperty.bInvertResponse, sizeof(MidiDeviceProperty.bInvertResponse));
+        HashBytes(&MidiDeviceProperty.ResponseMin, sizeof(MidiDeviceProperty.ResponseMin));
+        HashBytes(&MidiDeviceProperty.ResponseMax, sizeof(MidiDeviceProperty.ResponseMax));
+        const size_t ResponseBreakpointCount = MidiDeviceProperty.ResponseBreakpoints.size();
+        HashBytes(&ResponseBreakpointCount, sizeof(ResponseBreakpointCount));
+        HashBytes(MidiDeviceProperty.ResponseBreakpoints.data(), ResponseBreakpointCount * sizeof(IEMidiResponseBreakpoint));
+        HashBytes(&MidiDeviceProperty.bAnyChannel, sizeof(MidiDeviceProperty.bAnyChannel));
+        HashBytes(&MidiDeviceProperty.Data1RangeEnd, sizeof(MidiDeviceProperty.Data1RangeEnd));
+        HashBytes(&MidiDeviceProperty.ValueMin, sizeof(MidiDeviceProperty.ValueMin));
+        HashBytes(&MidiDeviceProperty.ValueMax, sizeof(MidiDeviceProperty.ValueMax));
+        const size_t MacroStepCount = MidiDeviceProperty.MacroSteps.size();
+        HashBytes(&MacroStepCount, sizeof(MacroStepCount));
+        for (const IEMidiMacroStep& MacroStep : MidiDeviceProperty.MacroSteps)
+        {
+            HashBytes(&MacroStep.MacroStepType, sizeof(MacroStep.MacroStepType));
+            HashBytes(&MacroStep.Value, sizeof(MacroStep.Value));
+            HashBytes(&MacroStep.DurationMs, sizeof(MacroStep.DurationMs));
+            HashString(MacroStep.ConsoleCommand);
+            HashMidiMessage(MacroStep.MidiMessage);
+        }
+        HashBytes(&MidiDeviceProperty.bPersistentConsoleCommand, sizeof(MidiDeviceProperty.bPersistentConsoleCommand));
+        HashBytes(&MidiDeviceProperty.ConsoleCommandWorkerCount, sizeof(MidiDeviceProperty.ConsoleCommandWorkerCount));
+        HashBytes(&MidiDeviceProperty.ConsoleCommandQueueDepth, sizeof(MidiDeviceProperty.ConsoleCommandQueueDepth));
+    }
+
+    const size_t InitialOutputMidiMessageCount = MidiDeviceProfile.InitialOutputMidiMessages.size();
+    HashBytes(&InitialOutputMidiMessageCount, sizeof(InitialOutputMidiMessageCount));
+    for (const IEMidiMessage& MidiMessage : MidiDeviceProfile.InitialOutputMidiMessages)
+    {
+        HashMidiMessage(MidiMessage);
+    }
+
+    HashBytes(&MidiDeviceProfile.bCoalesceControlChanges, sizeof(MidiDeviceProfile.bCoalesceControlChanges));
+    HashBytes(&MidiDeviceProfile.CoalescingRateHz, sizeof(MidiDeviceProfile.CoalescingRateHz));
+    HashBytes(&MidiDeviceProfile.OutputRateHz, sizeof(MidiDeviceProfile.OutputRateHz));
+    return Hash;
 }
\ No newline at end of file
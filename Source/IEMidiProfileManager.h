@@ -6,20 +6,94 @@
 
 #include "IECore.h"
 
+#include "IEMidiProfileSnapshot.h"
 #include "IEMidiTypes.h"
 
+enum class IEMidiProfileStorage : uint8_t
+{
+    /* Every profile in a single profiles.yaml */
+    SingleFile,
+    /* One file per profile plus an index, profiles are parsed on first use and saved independently */
+    Sharded
+};
+
+/* Names of the profiles whose content changed on disk, called from the profiles watcher thread */
+using IEMidiProfilesChangedCallback = void(*)(const std::vector<std::string>& ChangedProfileNames, void* UserData);
+
 class IEMidiProfileManager
 {
 public:
-    IEMidiProfileManager();
+    IEMidiProfileManager(IEMidiProfileStorage ProfileStorage = IEMidiProfileStorage::SingleFile);
+    ~IEMidiProfileManager();
     
 public:
+    IEMidiProfileStorage GetProfileStorage() const { return m_ProfileStorage; }
     std::filesystem::path GetIEMidiProfilesFilePath() const;
+    std::filesystem::path GetIEMidiProfileIndexFilePath() const;
+    std::filesystem::path GetIEMidiProfileLibraryFilePath() const;
     bool HasProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const;
+    std::vector<std::string> GetProfileNames() const;
     IEResult SaveProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const;
     IEResult LoadProfile(IEMidiDeviceProfile& MidiDeviceProfile) const;
     IEResult RemoveProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const;
 
+    /* Watches the profiles file for external edits, only supported on Linux through inotify */
+    IEResult StartWatchingProfiles(IEMidiProfilesChangedCallback ProfilesChangedCallback, void* UserData);
+    void StopWatchingProfiles();
+
+private:
+    /* Parsed yaml tree of the profiles file, saves only rewrite the node of the saved profile */
+    struct IEMidiProfilesDocument;
+
+    /*
+    * Profile library, rebuilt only when the write time or size of the profiles file changes.
+    * When the compiled snapshot matches the profiles file, profiles are read from it on demand and the yaml
+    * is only parsed once a profile is saved.
+    * With sharded storage the tracked file is the index and profiles are read from their shard on demand.
+    */
+    struct IEMidiProfileCache
+    {
+    public:
+        bool bIsValid = false;
+        std::filesystem::file_time_type ProfilesFileWriteTime = std::filesystem::file_time_type();
+        uintmax_t ProfilesFileSize = 0;
+        std::vector<std::string> ProfileNames;
+        std::unordered_map<std::string, IEMidiDeviceProfile> MidiDeviceProfiles;
+        std::unordered_map<std::string, uint64_t> MidiDeviceProfileHashes;
+        std::unordered_map<std::string, uint64_t> MidiProfileSourceHashes;
+        std::unordered_map<std::string, size_t> SnapshotProfileIndices;
+        std::unordered_map<std::string, std::filesystem::path> ProfileShardFilePaths;
+        std::unordered_map<std::string, std::filesystem::file_time_type> ProfileShardWriteTimes;
+        std::shared_ptr<IEMidiProfileSnapshot> MidiProfileSnapshot;
+        std::shared_ptr<IEMidiProfilesDocument> MidiProfilesDocument;
+    };
+
+private:
+    std::filesystem::path GetIEMidiProfileSnapshotFilePath() const;
+    std::filesystem::path GetIEMidiProfileShardsFolderPath() const;
+    void RefreshProfileCache() const;
+    void RefreshShardedProfileCache() const;
+    IEResult SaveShardedProfile(const IEMidiDeviceProfile& MidiDeviceProfile) const;
+    bool UpdateShardedProfileIndex(const std::string& MidiDeviceName, const std::string& ShardFileName, uint64_t MidiDeviceProfileHash) const;
+    IEResult MigrateToShardedProfiles() const;
+    bool LoadProfilesDocument() const;
+    std::vector<std::string> RefreshChangedProfiles() const;
+    void WriteProfileSnapshot() const;
+    static std::string ExtractFileContent(const std::filesystem::path& FilePath);
+    static const IEMidiDeviceProfile* FindCachedMidiDeviceProfile(IEMidiProfileCache& ProfileCache, const std::string& MidiDeviceName);
+    static uint64_t GetMidiDeviceProfileHash(const IEMidiDeviceProfile& MidiDeviceProfile);
+
+private:
+    void RunProfilesWatcher(int InotifyFileDescriptor);
+
+private:
+    IEMidiProfileStorage m_ProfileStorage = IEMidiProfileStorage::SingleFile;
+    mutable IEMidiProfileCache m_ProfileCache;
+    mutable std::mutex m_ProfileCacheMutex;
+
 private:
-    std::string ExtractFileContent(const std::filesystem::path& FilePath) const;
+    std::thread m_ProfilesWatcher;
+    std::atomic<bool> m_bIsProfilesWatcherStopping = false;
+    IEMidiProfilesChangedCallback m_ProfilesChangedCallback = nullptr;
+    void* m_ProfilesChangedUserData = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,429 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiProfileSnapshot.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr std::array<char, 4> MIDI_PROFILE_SNAPSHOT_MAGIC = { 'I', 'E', 'M', 'P' };
+static constexpr size_t MIDI_PROFILE_SNAPSHOT_ALIGNMENT = 8;
+
+static size_t AlignSnapshotOffset(size_t Offset)
+{
+    return (Offset + MIDI_PROFILE_SNAPSHOT_ALIGNMENT - 1) & ~(MIDI_PROFILE_SNAPSHOT_ALIGNMENT - 1);
+}
+
+IEMidiProfileSnapshot::~IEMidiProfileSnapshot()
+{
+    Close();
+}
+
+IEResult IEMidiProfileSnapshot::Open(const std::filesystem::path& SnapshotFilePath)
+{
+    IEResult Result(IEResult::Type::Fail);
+    Result.Message = std::format("Failed to open profile snapshot {}", SnapshotFilePath.string());
+
+    Close();
+
+#if defined(__linux__) || defined(__APPLE__)
+    const int SnapshotFile = open(SnapshotFilePath.c_str(), O_RDONLY);
+    if (SnapshotFile >= 0)
+    {
+        struct stat SnapshotFileStat;
+        if (fstat(SnapshotFile, &SnapshotFileStat) == 0 && SnapshotFileStat.st_size > 0)
+        {
+            void* const MappedData = mmap(nullptr, SnapshotFileStat.st_size, PROT_READ, MAP_PRIVATE, SnapshotFile, 0);
+            if (MappedData != MAP_FAILED)
+            {
+                m_Data = static_cast<const unsigned char*>(MappedData);
+                m_Size = static_cast<size_t>(SnapshotFileStat.st_size);
+            }
+        }
+        close(SnapshotFile);
+    }
+#else
+    if (std::FILE* const SnapshotFile = std::fopen(SnapshotFilePath.string().c_str(), "rb"))
+    {
+        std::fseek(SnapshotFile, 0, SEEK_END);
+        const long Size = std::ftell(SnapshotFile);
+        if (Size > 0)
+        {
+            m_FallbackBuffer.resize(Size);
+            std::rewind(SnapshotFile);
+            if (std::fread(m_FallbackBuffer.data(), 1, Size, SnapshotFile) == static_cast<size_t>(Size))
+            {
+                m_Data = m_FallbackBuffer.data();
+                m_Size = m_FallbackBuffer.size();
+            }
+        }
+        std::fclose(SnapshotFile);
+    }
+#endif
+
+    if (IsOpen())
+    {
+        if (Validate())
+        {
+            Result.Type = IEResult::Type::Success;
+            Result.Message = std::format("Successfully opened profile snapshot {}", SnapshotFilePath.string());
+        }
+        else
+        {
+            Close();
+            Result.Message = std::format("Profile snapshot {} is invalid or from another version", SnapshotFilePath.string());
+        }
+    }
+    return Result;
+}
+
+void IEMidiProfileSnapshot::Close()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    if (m_Data)
+    {
+        munmap(const_cast<unsigned char*>(m_Data), m_Size);
+    }
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+    m_FallbackBuffer.clear();
+}
+
+bool IEMidiProfileSnapshot::IsCompiledFrom(std::filesystem::file_time_type SourceWriteTime, uintmax_t SourceSize) const
+{
+    return IsOpen() && GetHeader().SourceWriteTime == static_cast<int64_t>(SourceWriteTime.time_since_epoch().count()) &&
+           GetHeader().SourceSize == static_cast<uint64_t>(SourceSize);
+}
+
+size_t IEMidiProfileSnapshot::GetProfileCount() const
+{
+    return IsOpen() ? GetHeader().ProfileCount : 0;
+}
+
+std::string_view IEMidiProfileSnapshot::GetProfileName(size_t ProfileIndex) const
+{
+    return GetString(GetProfiles()[ProfileIndex].Name);
+}
+
+uint64_t IEMidiProfileSnapshot::GetProfileHash(size_t ProfileIndex) const
+{
+    return GetProfiles()[ProfileIndex].ContentHash;
+}
+
+uint64_t IEMidiProfileSnapshot::GetProfileSourceHash(size_t ProfileIndex) const
+{
+    return GetProfiles()[ProfileIndex].SourceHash;
+}
+
+void IEMidiProfileSnapshot::ReadMidiDeviceProfile(size_t ProfileIndex, IEMidiDeviceProfile& MidiDeviceProfile) const
+{
+    const IEMidiSnapshotProfile& SnapshotProfile = GetProfiles()[ProfileIndex];
+
+    const std::span<const IEMidiSnapshotProperty> SnapshotProperties = GetProperties().subspan(SnapshotProfile.FirstPropertyIndex, SnapshotProfile.PropertyCount);
+    MidiDeviceProfile.Properties.clear();
+    MidiDeviceProfile.Properties.reserve(SnapshotProperties.size());
+    for (const IEMidiSnapshotProperty& SnapshotProperty : SnapshotProperties)
+    {
+        IEMidiDeviceProperty& MidiDeviceProperty = MidiDeviceProfile.Properties.emplace_back(MidiDeviceProfile.Name);
+        MidiDeviceProperty.MidiMessageType = SnapshotProperty.MidiMessageType;
+        MidiDeviceProperty.MidiActionType = SnapshotProperty.MidiActionType;
+        MidiDeviceProperty.ConsoleCommand = GetString(SnapshotProperty.ConsoleCommand);
+        MidiDeviceProperty.OpenFilePath = GetString(SnapshotProperty.OpenFilePath);
+        MidiDeviceProperty.MidiMessage = SnapshotProperty.MidiMessage;
+        MidiDeviceProperty.bToggle = SnapshotProperty.bToggle != 0;
+        MidiDeviceProperty.bCoalesce = SnapshotProperty.bCoalesce != 0;
+        MidiDeviceProperty.ResponseCurve = SnapshotProperty.ResponseCurve;
+        MidiDeviceProperty.bInvertResponse = SnapshotProperty.bInvertResponse != 0;
+        MidiDeviceProperty.ResponseMin = SnapshotProperty.ResponseMin;
+        MidiDeviceProperty.ResponseMax = SnapshotProperty.ResponseMax;
+        const std::span<const IEMidiResponseBreakpoint> SnapshotResponseBreakpoints =
+            GetResponseBreakpoints().subspan(SnapshotProperty.FirstResponseBreakpointIndex, SnapshotProperty.ResponseBreakpointCount);
+        MidiDeviceProperty.ResponseBreakpoints.assign(SnapshotResponseBreakpoints.begin(), SnapshotResponseBreakpoints.end());
+        MidiDeviceProperty.bAnyChannel = SnapshotProperty.bAnyChannel != 0;
+        MidiDeviceProperty.Data1RangeEnd = SnapshotProperty.Data1RangeEnd;
+        MidiDeviceProperty.ValueMin = SnapshotProperty.ValueMin;
+        MidiDeviceProperty.ValueMax = SnapshotProperty.ValueMax;
+        MidiDeviceProperty.bPersistentConsoleCommand = SnapshotProperty.bPersistentConsoleCommand != 0;
+        MidiDeviceProperty.ConsoleCommandWorkerCount = SnapshotProperty.ConsoleCommandWorkerCount;
+        MidiDeviceProperty.ConsoleCommandQueueDepth = SnapshotProperty.ConsoleCommandQueueDepth;
+        const std::span<const IEMidiSnapshotMacroStep> SnapshotMacroSteps = GetMacroSteps().subspan(SnapshotProperty.FirstMacroStepIndex, SnapshotProperty.MacroStepCount);
+        MidiDeviceProperty.MacroSteps.clear();
+        MidiDeviceProperty.MacroSteps.reserve(SnapshotMacroSteps.size());
+        for (const IEMidiSnapshotMacroStep& SnapshotMacroStep : SnapshotMacroSteps)
+        {
+            IEMidiMacroStep& MacroStep = MidiDeviceProperty.MacroSteps.emplace_back();
+            MacroStep.MacroStepType = SnapshotMacroStep.MacroStepType;
+            MacroStep.Value = SnapshotMacroStep.Value;
+            MacroStep.DurationMs = SnapshotMacroStep.DurationMs;
+            MacroStep.ConsoleCommand = GetString(SnapshotMacroStep.ConsoleCommand);
+            MacroStep.MidiMessage = SnapshotMacroStep.MidiMessage;
+        }
+    }
+
+    const std::span<const IEMidiMessage> SnapshotMidiMessages = GetMidiMessages().subspan(SnapshotProfile.FirstInitialOutputMidiMessageIndex,
+                                                                                         SnapshotProfile.InitialOutputMidiMessageCount);
+    MidiDeviceProfile.InitialOutputMidiMessages.assign(SnapshotMidiMessages.begin(), SnapshotMidiMessages.end());
+    MidiDeviceProfile.bCoalesceControlChanges = SnapshotProfile.bCoalesceControlChanges != 0;
+    MidiDeviceProfile.CoalescingRateHz = SnapshotProfile.CoalescingRateHz;
+    MidiDeviceProfile.OutputRateHz = SnapshotProfile.OutputRateHz;
+}
+
+IEResult IEMidiProfileSnapshot::Write(const std::filesystem::path& SnapshotFilePath, std::span<const IEMidiDeviceProfile* const> MidiDeviceProfiles,
+                                      std::span<const uint64_t> MidiDeviceProfileHashes, std::span<const uint64_t> MidiProfileSourceHashes,
+                                      std::filesystem::file_time_type SourceWriteTime, uintmax_t SourceSize)
+{
+    IEResult Result(IEResult::Type::Fail);
+    Result.Message = std::format("Failed to write profile snapshot {}", SnapshotFilePath.string());
+
+    if (!IEAssert(MidiDeviceProfiles.size() == MidiDeviceProfileHashes.size() && MidiDeviceProfiles.size() == MidiProfileSourceHashes.size()))
+    {
+        return Result;
+    }
+
+    std::vector<IEMidiSnapshotProfile> SnapshotProfiles;
+    std::vector<IEMidiSnapshotProperty> SnapshotProperties;
+    std::vector<IEMidiMessage> SnapshotMidiMessages;
+    std::vector<IEMidiResponseBreakpoint> SnapshotResponseBreakpoints;
+    std::vector<IEMidiSnapshotMacroStep> SnapshotMacroSteps;
+    std::string StringTable;
+    std::unordered_map<std::string, IEMidiSnapshotString> InternedStrings;
+
+    const auto InternString = [&StringTable, &InternedStrings](const std::string& String)
+    {
+        const std::pair<std::unordered_map<std::string, IEMidiSnapshotString>::iterator, bool> It = InternedStrings.try_emplace(String);
+        if (It.second)
+        {
+            It.first->second.Offset = static_cast<uint32_t>(StringTable.size());
+            It.first->second.Size = static_cast<uint32_t>(String.size());
+            StringTable += String;
+        }
+        return It.first->second;
+    };
+
+    SnapshotProfiles.reserve(MidiDeviceProfiles.size());
+    for (size_t ProfileIndex = 0; ProfileIndex < MidiDeviceProfiles.size(); ProfileIndex++)
+    {
+        const IEMidiDeviceProfile& MidiDeviceProfile = *MidiDeviceProfiles[ProfileIndex];
+
+        IEMidiSnapshotProfile& SnapshotProfile = SnapshotProfiles.emplace_back();
+        SnapshotProfile.ContentHash = MidiDeviceProfileHashes[ProfileIndex];
+        SnapshotProfile.SourceHash = MidiProfileSourceHashes[ProfileIndex];
+        SnapshotProfile.Name = InternString(MidiDeviceProfile.Name);
+        SnapshotProfile.FirstPropertyIndex = static_cast<uint32_t>(SnapshotProperties.size());
+        SnapshotProfile.PropertyCount = static_cast<uint32_t>(MidiDeviceProfile.Properties.size());
+        SnapshotProfile.FirstInitialOutputMidiMessageIndex = static_cast<uint32_t>(SnapshotMidiMessages.size());
+        SnapshotProfile.InitialOutputMidiMessageCount = static_cast<uint32_t>(MidiDeviceProfile.InitialOutputMidiMessages.size());
+        SnapshotProfile.CoalescingRateHz = MidiDeviceProfile.CoalescingRateHz;
+        SnapshotProfile.OutputRateHz = MidiDeviceProfile.OutputRateHz;
+        SnapshotProfile.bCoalesceControlChanges = MidiDeviceProfile.bCoalesceControlChanges;
+
+        for (const IEMidiDeviceProperty& MidiDeviceProperty : MidiDeviceProfile.Properties)
+        {
+            IEMidiSnapshotProperty& SnapshotProperty = SnapshotProperties.emplace_back();
+            SnapshotProperty.ConsoleCommand = InternString(MidiDeviceProperty.ConsoleCommand);
+            SnapshotProperty.OpenFilePath = InternString(MidiDeviceProperty.OpenFilePath);
+            SnapshotProperty.MidiMessage = MidiDeviceProperty.MidiMessage;
+            SnapshotProperty.MidiMessageType = MidiDeviceProperty.MidiMessageType;
+            SnapshotProperty.MidiActionType = MidiDeviceProperty.MidiActionType;
+            SnapshotProperty.bToggle = MidiDeviceProperty.bToggle;
+            SnapshotProperty.bCoalesce = MidiDeviceProperty.bCoalesce;
+            SnapshotProperty.ResponseCurve = MidiDeviceProperty.ResponseCurve;
+            SnapshotProperty.bInvertResponse = MidiDeviceProperty.bInvertResponse;
+            SnapshotProperty.ResponseMin = MidiDeviceProperty.ResponseMin;
+            SnapshotProperty.ResponseMax = MidiDeviceProperty.ResponseMax;
+            SnapshotProperty.FirstResponseBreakpointIndex = static_cast<uint32_t>(SnapshotResponseBreakpoints.size());
+            SnapshotProperty.ResponseBreakpointCount = static_cast<uint32_t>(MidiDeviceProperty.ResponseBreakpoints.size());
+            SnapshotProperty.bAnyChannel = MidiDeviceProperty.bAnyChannel;
+            SnapshotProperty.Data1RangeEnd = MidiDeviceProperty.Data1RangeEnd;
+            SnapshotProperty.ValueMin = MidiDeviceProperty.ValueMin;
+            SnapshotProperty.ValueMax = MidiDeviceProperty.ValueMax;
+            SnapshotProperty.FirstMacroStepIndex = static_cast<uint32_t>(SnapshotMacroSteps.size());
+            SnapshotProperty.MacroStepCount = static_cast<uint32_t>(MidiDeviceProperty.MacroSteps.size());
+            SnapshotProperty.bPersistentConsoleCommand = MidiDeviceProperty.bPersistentConsoleCommand;
+            SnapshotProperty.ConsoleCommandWorkerCount = MidiDeviceProperty.ConsoleCommandWorkerCount;
+            SnapshotProperty.ConsoleCommandQueueDepth = MidiDeviceProperty.ConsoleCommandQueueDepth;
+            SnapshotResponseBreakpoints.insert(SnapshotResponseBreakpoints.end(), MidiDeviceProperty.ResponseBreakpoints.begin(),
+                                               MidiDeviceProperty.ResponseBreakpoints.end());
+            for (const IEMidiMacroStep& MacroStep : MidiDeviceProperty.MacroSteps)
+            {
+                IEMidiSnapshotMacroStep& SnapshotMacroStep = SnapshotMacroSteps.emplace_back();
+                SnapshotMacroStep.ConsoleCommand = InternString(MacroStep.ConsoleCommand);
+                SnapshotMacroStep.MidiMessage = MacroStep.MidiMessage;
+                SnapshotMacroStep.MacroStepType = MacroStep.MacroStepType;
+                SnapshotMacroStep.Value = MacroStep.Value;
+                SnapshotMacroStep.DurationMs = MacroStep.DurationMs;
+            }
+        }
+
+        SnapshotMidiMessages.insert(SnapshotMidiMessages.end(), MidiDeviceProfile.InitialOutputMidiMessages.begin(), MidiDeviceProfile.InitialOutputMidiMessages.end());
+    }
+
+    IEMidiSnapshotHeader Header;
+    Header.Magic = MIDI_PROFILE_SNAPSHOT_MAGIC;
+    Header.Version = MIDI_PROFILE_SNAPSHOT_VERSION;
+    Header.SourceWriteTime = static_cast<int64_t>(SourceWriteTime.time_since_epoch().count());
+    Header.SourceSize = static_cast<uint64_t>(SourceSize);
+    Header.ProfileCount = static_cast<uint32_t>(SnapshotProfiles.size());
+    Header.PropertyCount = static_cast<uint32_t>(SnapshotProperties.size());
+    Header.MidiMessageCount = static_cast<uint32_t>(SnapshotMidiMessages.size());
+    Header.ResponseBreakpointCount = static_cast<uint32_t>(SnapshotResponseBreakpoints.size());
+    Header.MacroStepCount = static_cast<uint32_t>(SnapshotMacroSteps.size());
+    Header.StringTableSize = static_cast<uint32_t>(StringTable.size());
+    Header.ProfilesOffset = AlignSnapshotOffset(sizeof(IEMidiSnapshotHeader));
+    Header.PropertiesOffset = AlignSnapshotOffset(Header.ProfilesOffset + SnapshotProfiles.size() * sizeof(IEMidiSnapshotProfile));
+    Header.MidiMessagesOffset = AlignSnapshotOffset(Header.PropertiesOffset + SnapshotProperties.size() * sizeof(IEMidiSnapshotProperty));
+    Header.ResponseBreakpointsOffset = AlignSnapshotOffset(Header.MidiMessagesOffset + SnapshotMidiMessages.size() * sizeof(IEMidiMessage));
+    Header.MacroStepsOffset = AlignSnapshotOffset(Header.ResponseBreakpointsOffset + SnapshotResponseBreakpoints.size() * sizeof(IEMidiResponseBreakpoint));
+    Header.StringTableOffset = AlignSnapshotOffset(Header.MacroStepsOffset + SnapshotMacroSteps.size() * sizeof(IEMidiSnapshotMacroStep));
+
+    std::vector<unsigned char> SnapshotData(Header.StringTableOffset + StringTable.size(), 0);
+    std::memcpy(SnapshotData.data(), &Header, sizeof(Header));
+    std::memcpy(SnapshotData.data() + Header.ProfilesOffset, SnapshotProfiles.data(), SnapshotProfiles.size() * sizeof(IEMidiSnapshotProfile));
+    std::memcpy(SnapshotData.data() + Header.PropertiesOffset, SnapshotProperties.data(), SnapshotProperties.size() * sizeof(IEMidiSnapshotProperty));
+    std::memcpy(SnapshotData.data() + Header.MidiMessagesOffset, SnapshotMidiMessages.data(), SnapshotMidiMessages.size() * sizeof(IEMidiMessage));
+    std::memcpy(SnapshotData.data() + Header.ResponseBreakpointsOffset, SnapshotResponseBreakpoints.data(),
+                SnapshotResponseBreakpoints.size() * sizeof(IEMidiResponseBreakpoint));
+    std::memcpy(SnapshotData.data() + Header.MacroStepsOffset, SnapshotMacroSteps.data(), SnapshotMacroSteps.size() * sizeof(IEMidiSnapshotMacroStep));
+    std::memcpy(SnapshotData.data() + Header.StringTableOffset, StringTable.data(), StringTable.size());
+
+    // A reader may have the previous snapshot mapped, replace it with a rename instead of writing in place
+    std::filesystem::path SnapshotTempFilePath = SnapshotFilePath;
+    SnapshotTempFilePath += ".tmp";
+    bool bIsWritten = false;
+    if (std::FILE* const SnapshotTempFile = std::fopen(SnapshotTempFilePath.string().c_str(), "wb"))
+    {
+        bIsWritten = std::fwrite(SnapshotData.data(), 1, SnapshotData.size(), SnapshotTempFile) == SnapshotData.size();
+        bIsWritten = std::fclose(SnapshotTempFile) == 0 && bIsWritten;
+    }
+
+    std::error_code ErrorCode;
+    if (bIsWritten)
+    {
+        std::filesystem::rename(SnapshotTempFilePath, SnapshotFilePath, ErrorCode);
+    }
+
+    if (bIsWritten && !ErrorCode)
+    {
+        Result.Type = IEResult::Type::Success;
+        Result.Message = std::format("Successfully wrote profile snapshot {}", SnapshotFilePath.string());
+    }
+    else
+    {
+        std::filesystem::remove(SnapshotTempFilePath, ErrorCode);
+    }
+    return Result;
+}
+
+bool IEMidiProfileSnapshot::Validate() const
+{
+    if (m_Size < sizeof(IEMidiSnapshotHeader) || reinterpret_cast<uintptr_t>(m_Data) % MIDI_PROFILE_SNAPSHOT_ALIGNMENT != 0)
+    {
+        return false;
+    }
+
+    const IEMidiSnapshotHeader& Header = GetHeader();
+    if (Header.Magic != MIDI_PROFILE_SNAPSHOT_MAGIC || Header.Version != MIDI_PROFILE_SNAPSHOT_VERSION)
+    {
+        return false;
+    }
+
+    const auto IsValidSection = [this](uint64_t Offset, uint64_t Count, uint64_t ElementSize)
+    {
+        return Offset % MIDI_PROFILE_SNAPSHOT_ALIGNMENT == 0 && Offset <= m_Size && Count <= (m_Size - Offset) / ElementSize;
+    };
+    if (!IsValidSection(Header.ProfilesOffset, Header.ProfileCount, sizeof(IEMidiSnapshotProfile)) ||
+        !IsValidSection(Header.PropertiesOffset, Header.PropertyCount, sizeof(IEMidiSnapshotProperty)) ||
+        !IsValidSection(Header.MidiMessagesOffset, Header.MidiMessageCount, sizeof(IEMidiMessage)) ||
+        !IsValidSection(Header.ResponseBreakpointsOffset, Header.ResponseBreakpointCount, sizeof(IEMidiResponseBreakpoint)) ||
+        !IsValidSection(Header.MacroStepsOffset, Header.MacroStepCount, sizeof(IEMidiSnapshotMacroStep)) ||
+        !IsValidSection(Header.StringTableOffset, Header.StringTableSize, 1))
+    {
+        return false;
+    }
+
+    const auto IsValidString = [&Header](const IEMidiSnapshotString& SnapshotString)
+    {
+        return SnapshotString.Offset <= Header.StringTableSize && SnapshotString.Size <= Header.StringTableSize - SnapshotString.Offset;
+    };
+    for (const IEMidiSnapshotProfile& SnapshotProfile : GetProfiles())
+    {
+        if (!IsValidString(SnapshotProfile.Name) ||
+            SnapshotProfile.FirstPropertyIndex > Header.PropertyCount ||
+            SnapshotProfile.PropertyCount > Header.PropertyCount - SnapshotProfile.FirstPropertyIndex ||
+            SnapshotProfile.FirstInitialOutputMidiMessageIndex > Header.MidiMessageCount ||
+            SnapshotProfile.InitialOutputMidiMessageCount > Header.MidiMessageCount - SnapshotProfile.FirstInitialOutputMidiMessageIndex)
+        {
+            return false;
+        }
+    }
+
+    for (const IEMidiSnapshotProperty& SnapshotProperty : GetProperties())
+    {
+        if (!IsValidString(SnapshotProperty.ConsoleCommand) || !IsValidString(SnapshotProperty.OpenFilePath) ||
+            SnapshotProperty.MidiMessage.Size > MIDI_MESSAGE_BYTE_COUNT ||
+            SnapshotProperty.MidiMessageType >= IEMidiMessageType::Count || SnapshotProperty.MidiActionType >= IEMidiActionType::Count ||
+            SnapshotProperty.ResponseCurve >= IEMidiResponseCurve::Count ||
+            SnapshotProperty.FirstResponseBreakpointIndex > Header.ResponseBreakpointCount ||
+            SnapshotProperty.ResponseBreakpointCount > Header.ResponseBreakpointCount - SnapshotProperty.FirstResponseBreakpointIndex ||
+            SnapshotProperty.FirstMacroStepIndex > Header.MacroStepCount ||
+            SnapshotProperty.MacroStepCount > Header.MacroStepCount - SnapshotProperty.FirstMacroStepIndex)
+        {
+            return false;
+        }
+    }
+
+    for (const IEMidiSnapshotMacroStep& SnapshotMacroStep : GetMacroSteps())
+    {
+        if (!IsValidString(SnapshotMacroStep.ConsoleCommand) || SnapshotMacroStep.MidiMessage.Size > MIDI_MESSAGE_BYTE_COUNT ||
+            SnapshotMacroStep.MacroStepType >= IEMidiMacroStepType::Count)
+        {
+            return false;
+        }
+    }
+
+    for (const IEMidiMessage& MidiMessage : GetMidiMessages())
+    {
+        if (MidiMessage.Size > MIDI_MESSAGE_BYTE_COUNT)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string_view IEMidiProfileSnapshot::GetString(const IEMidiSnapshotString& SnapshotString) const
+{
+    return std::string_view(reinterpret_cast<const char*>(m_Data + GetHeader().StringTableOffset) + SnapshotString.Offset, SnapshotString.Size);
+}
+
+std::span<const IEMidiProfileSnapshot::IEMidiSnapshotProfile> IEMidiProfileSnapshot::GetProfiles() const
+{
+    return std::span<const IEMidiSnapshotProfile>(reinterpret_cast<const IEMidiSnapshotProfile*>(m_Data + GetHeader().ProfilesOffset), GetHeader().ProfileCount);
+}
+
+std::span<const IEMidiProfileSnapshot::IEMidiSnapshotProperty> IEMidiProfileSnapshot::GetProperties() const
+{
+    return std::span<const IEMidiSnapshotProperty>(reinterpret_cast<const IEMidiSnapshotProperty*>(m_Data + GetHeader().PropertiesOffset), GetHeader().PropertyCount);
+}
+
+std::span<const IEMidiMessage> IEMidiProfileSnapshot::GetMidiMessages() const
+{
+    return std::span<const IEMidiMessage>(reinterpret_cast<const IEMidiMessage*>(m_Data + GetHeader().MidiMessagesOffset), GetHeader().MidiMessageCount);
+}
+
+std::span<const IEMidiResponseBreakpoint> IEMidiProfileSnapshot::GetResponseBreakpoints() const
+{
+    return std::span<const IEMidiResponseBreakpoint>(reinterpret_cast<const IEMidiResponseBreakpoint*>(m_Data + GetHeader().ResponseBreakpointsOffset),
+                                                     GetHeader().ResponseBreakpointCount);
+}
+
+std::span<const IEMidiProfileSnapshot::IEMidiSnapshotMacroStep> IEMidiProfileSnapshot::GetMacroSteps() const
+{
+    return std::span<const IEMidiSnapshotMacroStep>(reinterpret_cast<const IEMidiSnapshotMacroStep*>(m_Data + GetHeader().MacroStepsOffset), GetHeader().MacroStepCount);
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include "IECore.h"
+
+#include "IEMidiTypes.h"
+
+static constexpr uint32_t MIDI_PROFILE_SNAPSHOT_VERSION = 7;
+
+/*
+* Compiled binary form of the profile library, generated from profiles.yaml and memory mapped on startup.
+* The layout is flat and relocatable: fixed size records referenced by offsets from the start of the file,
+* strings are interned once in a trailing table. The header records the write time and size of the yaml
+* it was compiled from so a stale snapshot is ignored and regenerated.
+*/
+class IEMidiProfileSnapshot
+{
+public:
+    IEMidiProfileSnapshot() = default;
+    ~IEMidiProfileSnapshot();
+    IEMidiProfileSnapshot(const IEMidiProfileSnapshot&) = delete;
+    IEMidiProfileSnapshot& operator=(const IEMidiProfileSnapshot&) = delete;
+
+public:
+    IEResult Open(const std::filesystem::path& SnapshotFilePath);
+    void Close();
+    bool IsOpen() const { return m_Data != nullptr; }
+    bool IsCompiledFrom(std::filesystem::file_time_type SourceWriteTime, uintmax_t SourceSize) const;
+
+    size_t GetProfileCount() const;
+    std::string_view GetProfileName(size_t ProfileIndex) const;
+    uint64_t GetProfileHash(size_t ProfileIndex) const;
+    uint64_t GetProfileSourceHash(size_t ProfileIndex) const;
+    void ReadMidiDeviceProfile(size_t ProfileIndex, IEMidiDeviceProfile& MidiDeviceProfile) const;
+
+    static IEResult Write(const std::filesystem::path& SnapshotFilePath, std::span<const IEMidiDeviceProfile* const> MidiDeviceProfiles,
+                          std::span<const uint64_t> MidiDeviceProfileHashes, std::span<const uint64_t> MidiProfileSourceHashes,
+                          std::filesystem::file_time_type SourceWriteTime, uintmax_t SourceSize);
+
+private:
+    struct IEMidiSnapshotString
+    {
+    public:
+        uint32_t Offset = 0;
+        uint32_t Size = 0;
+    };
+
+    struct IEMidiSnapshotHeader
+    {
+    public:
+        std::array<char, 4> Magic = {};
+        uint32_t Version = 0;
+        int64_t SourceWriteTime = 0;
+        uint64_t SourceSize = 0;
+        uint32_t ProfileCount = 0;
+        uint32_t PropertyCount = 0;
+        uint32_t MidiMessageCount = 0;
+        uint32_t ResponseBreakpointCount = 0;
+        uint32_t MacroStepCount = 0;
+        uint32_t StringTableSize = 0;
+        uint64_t ProfilesOffset = 0;
+        uint64_t PropertiesOffset = 0;
+        uint64_t MidiMessagesOffset = 0;
+        uint64_t ResponseBreakpointsOffset = 0;
+        uint64_t MacroStepsOffset = 0;
+        uint64_t StringTableOffset = 0;
+    };
+
+    struct IEMidiSnapshotProfile
+    {
+    public:
+        uint64_t ContentHash = 0;
+        uint64_t SourceHash = 0;
+        IEMidiSnapshotString Name;
+        uint32_t FirstPropertyIndex = 0;
+        uint32_t PropertyCount = 0;
+        uint32_t FirstInitialOutputMidiMessageIndex = 0;
+        uint32_t InitialOutputMidiMessageCount = 0;
+        uint32_t CoalescingRateHz = DEFAULT_COALESCING_RATE_HZ;
+        uint32_t OutputRateHz = DEFAULT_OUTPUT_RATE_HZ;
+        uint8_t bCoalesceControlChanges = 0;
+        std::array<uint8_t, 3> Padding = {};
+    };
+
+    struct IEMidiSnapshotProperty
+    {
+    public:
+        IEMidiSnapshotString ConsoleCommand;
+        IEMidiSnapshotString OpenFilePath;
+        IEMidiMessage MidiMessage;
+        IEMidiMessageType MidiMessageType = IEMidiMessageType::None;
+        IEMidiActionType MidiActionType = IEMidiActionType::None;
+        uint8_t bToggle = 0;
+        uint8_t bCoalesce = 0;
+        IEMidiResponseCurve ResponseCurve = IEMidiResponseCurve::Linear;
+        uint8_t bInvertResponse = 0;
+        std::array<uint8_t, 2> Padding = {};
+        float ResponseMin = 0.0f;
+        float ResponseMax = 1.0f;
+        uint32_t FirstResponseBreakpointIndex = 0;
+        uint32_t ResponseBreakpointCount = 0;
+        uint8_t bAnyChannel = 0;
+        uint8_t Data1RangeEnd = 0;
+        uint8_t ValueMin = 0;
+        uint8_t ValueMax = 127;
+        uint32_t FirstMacroStepIndex = 0;
+        uint32_t MacroStepCount = 0;
+        uint8_t bPersistentConsoleCommand = 0;
+        uint8_t ConsoleCommandWorkerCount = DEFAULT_CONSOLE_COMMAND_WORKER_COUNT;
+        uint16_t ConsoleCommandQueueDepth = DEFAULT_CONSOLE_COMMAND_QUEUE_DEPTH;
+    };
+
+    struct IEMidiSnapshotMacroStep
+    {
+    public:
+        IEMidiSnapshotString ConsoleCommand;
+        IEMidiMessage MidiMessage;
+        IEMidiMacroStepType MacroStepType = IEMidiMacroStepType::Delay;
+        std::array<uint8_t, 3> Padding = {};
+        float Value = 0.0f;
+        uint32_t DurationMs = 0;
+    };
+
+private:
+    bool Validate() const;
+    std::string_view GetString(const IEMidiSnapshotString& SnapshotString) const;
+    const IEMidiSnapshotHeader& GetHeader() const { return *reinterpret_cast<const IEMidiSnapshotHeader*>(m_Data); }
+    std::span<const IEMidiSnapshotProfile> GetProfiles() const;
+    std::span<const IEMidiSnapshotProperty> GetProperties() const;
+    std::span<const IEMidiMessage> GetMidiMessages() const;
+    std::span<const IEMidiResponseBreakpoint> GetResponseBreakpoints() const;
+    std::span<const IEMidiSnapshotMacroStep> GetMacroSteps() const;
+
+private:
+    const unsigned char* m_Data = nullptr;
+    size_t m_Size = 0;
+    std::vector<unsigned char> m_FallbackBuffer;
+};
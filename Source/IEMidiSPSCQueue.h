@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <bit>
+
+#include "IECore.h"
+
+/*
+* Fixed-capacity lock-free single-producer/single-consumer ring.
+* Capacity is rounded up to a power of two. Push never blocks, it fails when full.
+*/
+template<typename T>
+class IEMidiSPSCQueue
+{
+    static_assert(std::is_trivially_copyable_v<T>, "IEMidiSPSCQueue only holds trivially copyable elements");
+
+public:
+    IEMidiSPSCQueue() = delete;
+    explicit IEMidiSPSCQueue(size_t Capacity) :
+        m_Capacity(std::bit_ceil(std::max<size_t>(Capacity, 2))),
+        m_IndexMask(m_Capacity - 1),
+        m_Elements(std::make_unique<T[]>(m_Capacity))
+    {}
+
+public:
+    bool TryPush(const T& Element)
+    {
+        const size_t WriteIndex = m_WriteIndex.load(std::memory_order_relaxed);
+        if (WriteIndex - m_CachedReadIndex == m_Capacity)
+        {
+            m_CachedReadIndex = m_ReadIndex.load(std::memory_order_acquire);
+            if (WriteIndex - m_CachedReadIndex == m_Capacity)
+            {
+                m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        m_Elements[WriteIndex & m_IndexMask] = Element;
+        m_WriteIndex.store(WriteIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& OutElement)
+    {
+        const size_t ReadIndex = m_ReadIndex.load(std::memory_order_relaxed);
+        if (ReadIndex == m_CachedWriteIndex)
+        {
+            m_CachedWriteIndex = m_WriteIndex.load(std::memory_order_acquire);
+            if (ReadIndex == m_CachedWriteIndex)
+            {
+                return false;
+            }
+        }
+
+        OutElement = m_Elements[ReadIndex & m_IndexMask];
+        m_ReadIndex.store(ReadIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t GetCapacity() const { return m_Capacity; }
+    size_t GetSize() const { return m_WriteIndex.load(std::memory_order_acquire) - m_ReadIndex.load(std::memory_order_acquire); }
+    uint64_t GetDroppedCount() const { return m_DroppedCount.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    const size_t m_Capacity;
+    const size_t m_IndexMask;
+    std::unique_ptr<T[]> m_Elements;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_WriteIndex = 0;
+    size_t m_CachedReadIndex = 0;
+    std::atomic<uint64_t> m_DroppedCount = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_ReadIndex = 0;
+    size_t m_CachedWriteIndex = 0;
+};
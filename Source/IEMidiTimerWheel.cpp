@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#include "IEMidiTimerWheel.h"
+
+void IEMidiTimerWheel::Schedule(uint64_t DeadlineTick, uint64_t TimerData)
+{
+    uint32_t TimerIndex = m_FreeTimerIndex;
+    if (TimerIndex != INVALID_TIMER_INDEX)
+    {
+        m_FreeTimerIndex = m_Timers[TimerIndex].NextTimerIndex;
+    }
+    else
+    {
+        TimerIndex = static_cast<uint32_t>(m_Timers.size());
+        m_Timers.emplace_back();
+    }
+
+    // A deadline that already passed expires on the next tick
+    IEMidiTimer& MidiTimer = m_Timers[TimerIndex];
+    MidiTimer.DeadlineTick = std::max(DeadlineTick, m_CurrentTick + 1);
+    MidiTimer.TimerData = TimerData;
+    InsertTimer(TimerIndex);
+    m_TimerCount++;
+}
+
+void IEMidiTimerWheel::Advance(uint64_t NowTick, std::vector<uint64_t>& OutExpiredTimerData)
+{
+    while (m_CurrentTick < NowTick)
+    {
+        if (m_TimerCount == 0)
+        {
+            m_CurrentTick = NowTick;
+            break;
+        }
+
+        // Below the lowest occupied level nothing expires or cascades, skip straight to the tick before its next slot
+        size_t LowestLevel = 0;
+        while (m_LevelTimerCounts[LowestLevel] == 0)
+        {
+            LowestLevel++;
+        }
+        if (LowestLevel > 0)
+        {
+            const uint64_t LevelSlotMask = (1ull << (SLOT_BITS * LowestLevel)) - 1;
+            m_CurrentTick = std::min(NowTick, m_CurrentTick | LevelSlotMask);
+            if (m_CurrentTick == NowTick)
+            {
+                break;
+            }
+        }
+
+        m_CurrentTick++;
+
+        // Higher levels first, a timer moved down may land in a lower slot that comes up on this same tick
+        size_t CascadeLevelCount = 1;
+        while (CascadeLevelCount < LEVEL_COUNT && (m_CurrentTick & ((1ull << (SLOT_BITS * CascadeLevelCount)) - 1)) == 0)
+        {
+            CascadeLevelCount++;
+        }
+        for (size_t Level = CascadeLevelCount - 1; Level > 0; Level--)
+        {
+            CascadeSlot(Level);
+        }
+
+        uint32_t TimerIndex = DetachSlot(0, m_CurrentTick & SLOT_MASK);
+        while (TimerIndex != INVALID_TIMER_INDEX)
+        {
+            IEMidiTimer& MidiTimer = m_Timers[TimerIndex];
+            const uint32_t NextTimerIndex = MidiTimer.NextTimerIndex;
+            OutExpiredTimerData.push_back(MidiTimer.TimerData);
+            MidiTimer.NextTimerIndex = m_FreeTimerIndex;
+            m_FreeTimerIndex = TimerIndex;
+            m_TimerCount--;
+            TimerIndex = NextTimerIndex;
+        }
+    }
+}
+
+uint64_t IEMidiTimerWheel::GetNextWakeTick() const
+{
+    // The first occupied slot after the current one of each level, at level 0 its tick is a deadline, above it is when its timers move down
+    uint64_t NextWakeTick = std::numeric_limits<uint64_t>::max();
+    for (size_t Level = 0; Level < LEVEL_COUNT; Level++)
+    {
+        if (m_LevelTimerCounts[Level] > 0)
+        {
+            const size_t LevelShift = SLOT_BITS * Level;
+            const uint64_t CurrentSlotTick = m_CurrentTick >> LevelShift;
+            for (uint64_t SlotOffset = 1; SlotOffset <= SLOT_COUNT; SlotOffset++)
+            {
+                if (m_SlotTimerIndices[Level][(CurrentSlotTick + SlotOffset) & SLOT_MASK] != INVALID_TIMER_INDEX)
+                {
+                    NextWakeTick = std::min(NextWakeTick, (CurrentSlotTick + SlotOffset) << LevelShift);
+                    break;
+                }
+            }
+        }
+    }
+    return NextWakeTick;
+}
+
+void IEMidiTimerWheel::InsertTimer(uint32_t TimerIndex)
+{
+    IEMidiTimer& MidiTimer = m_Timers[TimerIndex];
+    const uint64_t TickDistance = std::min(MidiTimer.DeadlineTick - m_CurrentTick, MAX_TICK_DISTANCE);
+
+    size_t Level = 0;
+    while (Level < LEVEL_COUNT - 1 && TickDistance >> (SLOT_BITS * (Level + 1)) != 0)
+    {
+        Level++;
+    }
+
+    const size_t SlotIndex = ((m_CurrentTick + TickDistance) >> (SLOT_BITS * Level)) & SLOT_MASK;
+    MidiTimer.NextTimerIndex = m_SlotTimerIndices[Level][SlotIndex];
+    m_SlotTimerIndices[Level][SlotIndex] = TimerIndex;
+    m_LevelTimerCounts[Level]++;
+}
+
+void IEMidiTimerWheel::CascadeSlot(size_t Level)
+{
+    uint32_t TimerIndex = DetachSlot(Level, (m_CurrentTick >> (SLOT_BITS * Level)) & SLOT_MASK);
+    while (TimerIndex != INVALID_TIMER_INDEX)
+    {
+        const uint32_t NextTimerIndex = m_Timers[TimerIndex].NextTimerIndex;
+        InsertTimer(TimerIndex);
+        TimerIndex = NextTimerIndex;
+    }
+}
+
+uint32_t IEMidiTimerWheel::DetachSlot(size_t Level, size_t SlotIndex)
+{
+    uint32_t TimerIndex = m_SlotTimerIndices[Level][SlotIndex];
+    m_SlotTimerIndices[Level][SlotIndex] = INVALID_TIMER_INDEX;
+    for (uint32_t CountedTimerIndex = TimerIndex; CountedTimerIndex != INVALID_TIMER_INDEX; CountedTimerIndex = m_Timers[CountedTimerIndex].NextTimerIndex)
+    {
+        m_LevelTimerCounts[Level]--;
+    }
+    return TimerIndex;
+}
\ No newline at end of file
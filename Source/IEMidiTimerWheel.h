@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright © Interactive Echoes. All rights reserved.
+// Author: mozahzah
+
+#pragma once
+
+#include <limits>
+
+#include "IECore.h"
+
+/*
+* Hierarchical timer wheel counting in abstract ticks, not thread safe.
+* Each of the LEVEL_COUNT levels has SLOT_COUNT slots, level N covering SLOT_COUNT^N ticks per slot. A timer is filed in
+* the level matching its distance to the deadline and moved down a level each time its slot comes up, so scheduling and
+* expiring are constant time however many timers are pending. Deadlines past the last level are filed there and
+* moved down again until they are in reach. Timers are pooled and never freed, only recycled.
+*/
+class IEMidiTimerWheel
+{
+public:
+    void Schedule(uint64_t DeadlineTick, uint64_t TimerData);
+    /* Moves the wheel to NowTick and appends the data of every timer that came due, timers due on the same tick come in no particular order */
+    void Advance(uint64_t NowTick, std::vector<uint64_t>& OutExpiredTimerData);
+    /* Earliest tick at which Advance can expire or move a timer, max when the wheel is empty */
+    uint64_t GetNextWakeTick() const;
+    uint64_t GetCurrentTick() const { return m_CurrentTick; }
+    size_t GetTimerCount() const { return m_TimerCount; }
+
+private:
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOT_COUNT = 1 << SLOT_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOT_COUNT - 1;
+    static constexpr size_t LEVEL_COUNT = 4;
+    static constexpr uint64_t MAX_TICK_DISTANCE = (1ull << (SLOT_BITS * LEVEL_COUNT)) - 1;
+    static constexpr uint32_t INVALID_TIMER_INDEX = std::numeric_limits<uint32_t>::max();
+
+private:
+    struct IEMidiTimer
+    {
+    public:
+        uint64_t DeadlineTick = 0;
+        uint64_t TimerData = 0;
+        uint32_t NextTimerIndex = INVALID_TIMER_INDEX;
+    };
+
+private:
+    void InsertTimer(uint32_t TimerIndex);
+    void CascadeSlot(size_t Level);
+    uint32_t DetachSlot(size_t Level, size_t SlotIndex);
+
+private:
+    std::vector<IEMidiTimer> m_Timers;
+    uint32_t m_FreeTimerIndex = INVALID_TIMER_INDEX;
+    std::array<std::array<uint32_t, SLOT_COUNT>, LEVEL_COUNT> m_SlotTimerIndices = MakeEmptySlots();
+    std::array<size_t, LEVEL_COUNT> m_LevelTimerCounts = {};
+    size_t m_TimerCount = 0;
+    uint64_t m_CurrentTick = 0;
+
+private:
+    static constexpr std::array<std::array<uint32_t, SLOT_COUNT>, LEVEL_COUNT> MakeEmptySlots()
+    {
+        std::array<std::array<uint32_t, SLOT_COUNT>, LEVEL_COUNT> Slots = {};
+        for (std::array<uint32_t, SLOT_COUNT>& LevelSlots : Slots)
+        {
+            LevelSlots.fill(INVALID_TIMER_INDEX);
+        }
+        return Slots;
+    }
+};
\ No newline at end of file
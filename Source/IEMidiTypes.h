@@ -7,12 +7,23 @@
 #include "IECore.h"
 
 static constexpr size_t MIDI_MESSAGE_BYTE_COUNT = 3;
+static constexpr uint32_t DEFAULT_COALESCING_RATE_HZ = 120;
+static constexpr uint32_t DEFAULT_OUTPUT_RATE_HZ = 1000;
+static constexpr uint8_t DEFAULT_CONSOLE_COMMAND_WORKER_COUNT = 1;
+static constexpr uint16_t DEFAULT_CONSOLE_COMMAND_QUEUE_DEPTH = 64;
 
 enum class IEMidiMessageType : uint8_t
 {
     None,
     NoteOnOff,
     ControlChange,
+    HighResControlChange,
+    NRPN,
+    RPN,
+    PolyPressure,
+    ProgramChange,
+    ChannelPressure,
+    PitchBend,
 
     Count,
 };
@@ -24,10 +35,104 @@ enum class IEMidiActionType : uint8_t
     Mute,
     ConsoleCommand,
     OpenFile,
+    Macro,
 
     Count,
 };
 
+/* Shape applied to a continuous control before its value reaches the action, see IEMidiDispatchTable */
+enum class IEMidiResponseCurve : uint8_t
+{
+    Linear,
+    Logarithmic,
+    Exponential,
+    SCurve,
+    Custom,
+
+    Count,
+};
+
+/* Point of a custom response curve, both coordinates are normalized to [0, 1] */
+struct IEMidiResponseBreakpoint
+{
+public:
+    float Input = 0.0f;
+    float Output = 0.0f;
+};
+static_assert(std::is_trivially_copyable_v<IEMidiResponseBreakpoint>, "IEMidiResponseBreakpoint must stay trivially copyable");
+
+/* Kind of a macro step, macros are run by the processor's macro scheduler */
+enum class IEMidiMacroStepType : uint8_t
+{
+    Delay,
+    Volume,
+    VolumeRamp,
+    Mute,
+    ConsoleCommand,
+    MidiOutput,
+
+    Count,
+};
+
+/*
+* Short MIDI message stored inline, trivially copyable so it never touches the heap.
+* Channel and system common messages fit in MIDI_MESSAGE_BYTE_COUNT bytes,
+* SysEx is passed out of line as a byte span.
+*/
+struct IEMidiMessage
+{
+public:
+    IEMidiMessage() = default;
+    IEMidiMessage(unsigned char Status, unsigned char Data1, unsigned char Data2) :
+        Bytes({ Status, Data1, Data2 }), Size(MIDI_MESSAGE_BYTE_COUNT)
+    {}
+    explicit IEMidiMessage(std::span<const unsigned char> MidiBytes) :
+        Size(static_cast<uint8_t>(std::min(MidiBytes.size(), MIDI_MESSAGE_BYTE_COUNT)))
+    {
+        std::copy_n(MidiBytes.begin(), Size, Bytes.begin());
+    }
+
+    bool operator==(const IEMidiMessage& Other) const
+    {
+        return Size == Other.Size && std::equal(begin(), end(), Other.begin());
+    }
+
+    unsigned char& operator[](size_t ByteIndex) { return Bytes[ByteIndex]; }
+    unsigned char operator[](size_t ByteIndex) const { return Bytes[ByteIndex]; }
+
+    const unsigned char* data() const { return Bytes.data(); }
+    size_t size() const { return Size; }
+    const unsigned char* begin() const { return Bytes.data(); }
+    const unsigned char* end() const { return Bytes.data() + Size; }
+
+public:
+    std::array<unsigned char, MIDI_MESSAGE_BYTE_COUNT> Bytes = {};
+    uint8_t Size = MIDI_MESSAGE_BYTE_COUNT;
+};
+static_assert(std::is_trivially_copyable_v<IEMidiMessage>, "IEMidiMessage must stay trivially copyable");
+
+/* Step of a macro action, steps run in order and only Delay and VolumeRamp take time */
+struct IEMidiMacroStep
+{
+public:
+    IEMidiMacroStepType MacroStepType = IEMidiMacroStepType::Delay;
+    /* Volume in [0, 1], mute when not zero or the value passed to the console command */
+    float Value = 0.0f;
+    /* Length of a delay or of a volume ramp */
+    uint32_t DurationMs = 0;
+    std::string ConsoleCommand = std::string();
+    IEMidiMessage MidiMessage = IEMidiMessage();
+};
+
+struct IEMidiEvent
+{
+public:
+    double TimeStamp = 0.0;
+    IEMidiMessage MidiMessage = IEMidiMessage();
+    uint32_t MidiDeviceSessionID = 0;
+    bool bRecorded = false;
+};
+
 struct IEMidiDeviceProperty
 {
 private:
@@ -51,6 +156,20 @@ public:
             OpenFilePath = Other.OpenFilePath;
             MidiMessage = Other.MidiMessage;
             bToggle = Other.bToggle;
+            bCoalesce = Other.bCoalesce;
+            ResponseCurve = Other.ResponseCurve;
+            bInvertResponse = Other.bInvertResponse;
+            ResponseMin = Other.ResponseMin;
+            ResponseMax = Other.ResponseMax;
+            ResponseBreakpoints = Other.ResponseBreakpoints;
+            bAnyChannel = Other.bAnyChannel;
+            Data1RangeEnd = Other.Data1RangeEnd;
+            ValueMin = Other.ValueMin;
+            ValueMax = Other.ValueMax;
+            MacroSteps = Other.MacroSteps;
+            bPersistentConsoleCommand = Other.bPersistentConsoleCommand;
+            ConsoleCommandWorkerCount = Other.ConsoleCommandWorkerCount;
+            ConsoleCommandQueueDepth = Other.ConsoleCommandQueueDepth;
         }
         return *this;
     }
@@ -63,7 +182,6 @@ public:
 public:
     const uint32_t RuntimeID;
     bool bIsRecording = false;
-    bool bIsConsoleCommandActive = false;
 
 public:
     std::string MidiDeviceName = std::string();
@@ -71,8 +189,32 @@ public:
     IEMidiActionType MidiActionType = IEMidiActionType::None;
     std::string ConsoleCommand = std::string();
     std::string OpenFilePath = std::string();
-    std::vector<unsigned char> MidiMessage = std::vector<unsigned char>(MIDI_MESSAGE_BYTE_COUNT);
+    IEMidiMessage MidiMessage = IEMidiMessage();
     bool bToggle = false;
+    bool bCoalesce = false;
+    IEMidiResponseCurve ResponseCurve = IEMidiResponseCurve::Linear;
+    bool bInvertResponse = false;
+    float ResponseMin = 0.0f;
+    float ResponseMax = 1.0f;
+    std::vector<IEMidiResponseBreakpoint> ResponseBreakpoints;
+
+    /* Matching rules, the message's channel is ignored, data1 of the message starts a range up to Data1RangeEnd when that is above it */
+    bool bAnyChannel = false;
+    uint8_t Data1RangeEnd = 0;
+    /* Inclusive bounds on the 7 most significant bits of the value */
+    uint8_t ValueMin = 0;
+    uint8_t ValueMax = 127;
+
+    /* Steps of a Macro action, a second press while the macro runs cancels it */
+    std::vector<IEMidiMacroStep> MacroSteps;
+
+    /*
+    * Persistent console commands are started once and kept running, each value is written to their standard input as a line,
+    * see IEMidiConsoleCommandRunner. Values past the queue depth drop the oldest pending one.
+    */
+    bool bPersistentConsoleCommand = false;
+    uint8_t ConsoleCommandWorkerCount = DEFAULT_CONSOLE_COMMAND_WORKER_COUNT;
+    uint16_t ConsoleCommandQueueDepth = DEFAULT_CONSOLE_COMMAND_QUEUE_DEPTH;
 };
 
 struct IEMidiDevicePropertyHash
@@ -96,11 +238,19 @@ public:
 
     uint32_t GetInputPortNumber() const { return m_InputPortNumber; }
     uint32_t GetOutputPortNumber() const { return m_OutputPortNumber; }
+    void SetPortNumbers(uint32_t InputPortNumber, uint32_t OutputPortNumber)
+    {
+        m_InputPortNumber = InputPortNumber;
+        m_OutputPortNumber = OutputPortNumber;
+    }
 
 public:
     std::string Name;
-    std::vector<std::vector<unsigned char>> InitialOutputMidiMessages;
+    std::vector<IEMidiMessage> InitialOutputMidiMessages;
     std::vector<IEMidiDeviceProperty> Properties;
+    bool bCoalesceControlChanges = false;
+    uint32_t CoalescingRateHz = DEFAULT_COALESCING_RATE_HZ;
+    uint32_t OutputRateHz = DEFAULT_OUTPUT_RATE_HZ;
 
 private:
     uint32_t m_InputPortNumber = -1;